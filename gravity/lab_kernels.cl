@@ -0,0 +1,73 @@
+// Experimental variants of forces kernel.
+// Production kernel lives in src/gravity_core/accelerators/forces_kernel.cl and is compiled together with these.
+
+// naive: each work item reads all objects from global memory
+kernel void ocl_kernel1(global const float * restrict objX, global const float * restrict objY, global const float * restrict mass,
+                        global float * restrict forceX, global float * restrict forceY, const int count)
+{
+  const int gid = get_global_id(0);
+  const float G = 6.6732e-11;
+  if (gid < count) {
+    const float xi = objX[gid];
+    const float yi = objY[gid];
+    const float mi = mass[gid];
+    float fx = 0, fy = 0;
+    for (int j = 0; j < count; j++) {
+      const float xj = objX[j];
+      const float yj = objY[j];
+      const float mj = mass[j];
+      const float dx = xj - xi;
+      const float dy = yj - yi;
+      const float len2 = dx * dx + dy * dy;
+      if (len2 == 0)
+        continue;
+      const float Fg = (G * mi) * (mj / len2);
+      const float len = sqrt(len2);
+      fx += dx / len * Fg;
+      fy += dy / len * Fg;
+    }
+    forceX[gid] = fx;
+    forceY[gid] = fy;
+  }
+}
+
+// tiles of GROUP_SIZE objects loaded to local memory, one object per work item.
+// Input buffers must be padded to multiple of GROUP_SIZE with zero masses.
+kernel void ocl_kernel3(global const float * restrict objX, global const float * restrict objY, global const float * restrict mass,
+                        global float * restrict forceX, global float * restrict forceY)
+{
+  const float G = 6.6732e-11;
+  const int lid = get_local_id(0);
+  const int gid = get_global_id(0);
+  const int gsiz = get_global_size(0);
+  local float sx[GROUP_SIZE];
+  local float sy[GROUP_SIZE];
+  local float sm[GROUP_SIZE];
+  const float xi = objX[gid];
+  const float yi = objY[gid];
+  const float mi = mass[gid];
+  float fx = 0, fy = 0;
+  for (int c = lid; c < gsiz; c += GROUP_SIZE) {
+    barrier(CLK_LOCAL_MEM_FENCE);
+    sx[lid] = objX[c];
+    sy[lid] = objY[c];
+    sm[lid] = mass[c];
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (int k = 0; k < GROUP_SIZE; ++k) {
+      const float xk = sx[k];
+      const float yk = sy[k];
+      const float mk = sm[k];
+      const float dx = xk - xi;
+      const float dy = yk - yi;
+      float len2 = dx * dx + dy * dy;
+      const int notzero = (len2 != 0);
+      len2 += (len2 == 0);
+      const float Fg = (G * mi) * (mk / len2);
+      const float len = sqrt(len2);
+      fx += dx * Fg / len * notzero;
+      fy += dy * Fg / len * notzero;
+    }
+  }
+  forceX[gid] = fx;
+  forceY[gid] = fy;
+}
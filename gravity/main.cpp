@@ -1,27 +1,56 @@
-#include "ocl_kernel.hpp"
 #include "timer.hpp"
 
 #include <iostream>
+#include <iomanip>
 #include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include <cstdlib>
+#include <cstring>
 #include <cmath>
 
-template <typename T> bool cmpf(T, T, int);
+#include "objects.hpp"
+#include "accelerators/simple_cpu_accelerator.hpp"
+#include "accelerators/tiled_cpu_accelerator.hpp"
 
-template <> bool cmpf<float>(float a, float b, int max_diff) {
-  static_assert(sizeof(float) == sizeof(int), "Invalid size");
-  int ai, bi;
+#ifdef GRAVITY_AVX_ACCELERATOR
+#include "accelerators/avx_accelerator.hpp"
+#include "accelerators/avx_blocks_accelerator.hpp"
+#endif
+
+#ifdef KERNELS_LAB_OPENCL
+#include "ocl_kernel.hpp"
+#endif
+
+/*
+ * Distance in units in the last place: floats are mapped to integers
+ * so that neighbouring floats differ by one (sign-magnitude -> two's complement).
+ */
+inline std::int64_t ulp_distance(float a, float b) {
+  static_assert(sizeof(float) == sizeof(std::int32_t), "Invalid size");
+  std::int32_t ai, bi;
   memcpy(&ai, &a, sizeof(float));
   memcpy(&bi, &b, sizeof(float));
-  if (ai < 0)
-    ai = 0x80000000 - ai;
-  if (bi < 0)
-    bi = 0x80000000 - bi;
-  return (abs(ai - bi) <= max_diff);
+  std::int64_t al = ai, bl = bi;
+  if (al < 0)
+    al = INT32_MIN - al;
+  if (bl < 0)
+    bl = INT32_MIN - bl;
+  return std::abs(al - bl);
 }
 
+template <typename T> bool cmpf(T, T, int);
+
+template <> bool cmpf<float>(float a, float b, int max_diff) {
+  return ulp_distance(a, b) <= max_diff;
+}
+
+// float version of the physics, for comparison with lab OpenCL kernels
 void cpu_forces(const float *__restrict__ objX, const float *__restrict__ objY,
                 const float *__restrict__ mass, float *__restrict__ forcex,
                 float *__restrict__ forcey, const int count) {
@@ -57,31 +86,97 @@ void cpu_forces(const float *__restrict__ objX, const float *__restrict__ objY,
   }
 }
 
-template <typename T1, typename T2>
-bool compare(const T1 &t1, const T2 &t2, int max_diff = 4) {
-  int i = 0;
-  return std::equal(t1.begin(), t1.end(), t2.begin(), [&](float f1, float f2) {
-    ++i;
-    if (!cmpf(f1, f2, max_diff)) {
-      std::cout << i << ": " << f1 << " != " << f2 << " " << (f1 - f2)
-                << std::endl;
-      return false;
-    } else
-      return true;
-  });
+// reference: the same physics in double precision
+void reference_forces(const std::vector<float> &objX, const std::vector<float> &objY,
+                      const std::vector<float> &mass, std::vector<float> &forcex,
+                      std::vector<float> &forcey) {
+  const double G = 6.6732e-11;
+  const int count = objX.size();
+
+  for (int i = 0; i < count; ++i) {
+    double fx = 0, fy = 0;
+    for (int j = 0; j < count; j++) {
+      const double dx = double(objX[j]) - objX[i];
+      const double dy = double(objY[j]) - objY[i];
+      const double len2 = dx * dx + dy * dy;
+      if (i == j || len2 == 0)
+        continue;
+
+      const double Fg = (G * mass[i]) * (mass[j] / len2);
+      const double len = std::sqrt(len2);
+
+      fx += dx / len * Fg;
+      fy += dy / len * Fg;
+    }
+    forcex[i] = fx;
+    forcey[i] = fy;
+  }
 }
 
-void assert(bool v, const char *msg) {
-  if (!v) {
-    std::cout << "Assertion failed: " << msg << std::endl;
-    //    abort();
+struct Accuracy {
+  std::int64_t max = 0;   // max ULP distance
+  std::int64_t p99 = 0;   // 99th percentile of ULP distance
+  std::size_t failed = 0; // components above allowed distance (checked with cmpf)
+};
+
+Accuracy compare(const std::vector<float> &ref_x, const std::vector<float> &ref_y,
+                 const std::vector<float> &fx, const std::vector<float> &fy,
+                 int max_diff) {
+  Accuracy result;
+  std::vector<std::int64_t> distances;
+  distances.reserve(2 * ref_x.size());
+
+  for (std::size_t i = 0; i < ref_x.size(); ++i) {
+    distances.push_back(ulp_distance(ref_x[i], fx[i]));
+    distances.push_back(ulp_distance(ref_y[i], fy[i]));
+
+    result.failed += !cmpf(ref_x[i], fx[i], max_diff);
+    result.failed += !cmpf(ref_y[i], fy[i], max_diff);
   }
+
+  std::sort(distances.begin(), distances.end());
+  result.max = distances.back();
+  result.p99 = distances[(distances.size() - 1) * 99 / 100];
+
+  return result;
+}
+
+/*
+ * Kernel under test: fills forces for objects generated in main().
+ */
+struct Kernel {
+  std::string name;
+  std::function<void(std::vector<float> &, std::vector<float> &)> run;
+};
+
+template <typename Accelerator>
+Kernel accelerator_kernel(const std::string &name, Objects &objects) {
+  auto accelerator = std::make_shared<Accelerator>();
+  accelerator->setObjects(&objects);
+
+  return {name, [accelerator](std::vector<float> &fx, std::vector<float> &fy) {
+            const std::vector<force_vector_t> forces = accelerator->forces();
+
+            for (std::size_t i = 0; i < forces.size(); ++i) {
+              fx[i] = forces[i].x.raw_value();
+              fy[i] = forces[i].y.raw_value();
+            }
+          }};
+}
+
+void usage(const char *app) {
+  std::cout << app << " <problem-size> [options]" << std::endl
+            << "  --device gpu|cpu|any  preferred OpenCL device type (default gpu, falls back to any)" << std::endl
+            << "  --warmup N            untimed runs of each kernel (default 2)" << std::endl
+            << "  --repetitions N       minimal number of timed runs (default 10)" << std::endl
+            << "  --min-time S          minimal time of timed runs in seconds (default 0.5)" << std::endl
+            << "  --max-ulp N           allowed distance from double precision reference (default 1024)" << std::endl;
 }
 
 int main(int argc, char **argv) {
 
-  if (argc != 2 || !isdigit(argv[1][0])) {
-    std::cout << argv[0] << " <problem-size>" << std::endl;
+  if (argc < 2 || !isdigit(argv[1][0])) {
+    usage(argv[0]);
     return 1;
   }
 
@@ -90,59 +185,135 @@ int main(int argc, char **argv) {
    */
   const size_t siz = atoi(argv[1]);
 
+  std::string device = "gpu";
+  int warmup = 2;
+  int repetitions = 10;
+  double min_time = 0.5;
+  int max_ulp = 1024;
+
+  for (int i = 2; i + 1 < argc; i += 2) {
+    const std::string option = argv[i];
+    const char *value = argv[i + 1];
+
+    if (option == "--device")
+      device = value;
+    else if (option == "--warmup")
+      warmup = atoi(value);
+    else if (option == "--repetitions")
+      repetitions = std::max(1, atoi(value));
+    else if (option == "--min-time")
+      min_time = atof(value);
+    else if (option == "--max-ulp")
+      max_ulp = atoi(value);
+    else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
   std::vector<float> x(siz);
   std::vector<float> y(siz);
   std::vector<float> m(siz);
 
-  std::vector<float> f1x(siz);
-  std::vector<float> f1y(siz);
-
-  std::vector<float> f2x(siz);
-  std::vector<float> f2y(siz);
-
+  srand(3);
   auto gen = []() { return (float)rand() / (float)RAND_MAX; };
   std::generate(x.begin(), x.end(), gen);
   std::generate(y.begin(), y.end(), gen);
   std::generate(m.begin(), m.end(), gen);
 
-  {
-    Timer t;
-    cpu_forces(&x[0], &y[0], &m[0], &f1x[0], &f1y[0], siz);
+  // the same data for production CPU kernels
+  Objects objects(siz);
+  objects.resize(siz);
+  for (size_t i = 0; i < siz; ++i) {
+    objects.getId()[i] = i + 1;
+    objects.getX()[i] = x[i];
+    objects.getY()[i] = y[i];
+    objects.getMass()[i] = m[i];
+    objects.getRadius()[i] = 1e-6;
   }
 
-  {
-    OpenCL opencl;
-    std::fill(f2x.begin(), f2x.end(), 0);
-    std::fill(f2y.begin(), f2y.end(), 0);
-    {
-      Timer t;
-      opencl.exec2(&x[0], &y[0], &m[0], &f2x[0], &f2y[0], siz);
-    }
-    assert(compare(f1x, f2x), "results differ too much");
-    assert(compare(f1y, f2y), "results differ too much");
+  std::vector<float> ref_x(siz);
+  std::vector<float> ref_y(siz);
+  reference_forces(x, y, m, ref_x, ref_y);
+
+  std::vector<Kernel> kernels;
+
+  kernels.push_back({"cpu_forces", [&](std::vector<float> &fx, std::vector<float> &fy) {
+                       cpu_forces(&x[0], &y[0], &m[0], &fx[0], &fy[0], siz);
+                     }});
+
+  kernels.push_back(accelerator_kernel<SimpleCpuAccelerator>("simple_cpu", objects));
+  kernels.push_back(accelerator_kernel<TiledCpuAccelerator>("tiled_cpu", objects));
+
+#ifdef GRAVITY_AVX_ACCELERATOR
+  kernels.push_back(accelerator_kernel<AVXAccelerator>("avx", objects));
+  kernels.push_back(accelerator_kernel<AVXBlocksAccelerator>("avx_blocks", objects));
+#endif
+
+#ifdef KERNELS_LAB_OPENCL
+  std::shared_ptr<OpenCL> opencl;
+
+  try {
+    const OpenCL::DeviceType type = device == "cpu" ? OpenCL::CPU
+                                  : device == "any" ? OpenCL::Any
+                                                    : OpenCL::GPU;
+    opencl = std::make_shared<OpenCL>(type);
+    std::cout << "OpenCL device: " << opencl->deviceName() << std::endl;
+  } catch (const std::exception &e) {
+    std::cout << "OpenCL kernels skipped: " << e.what() << std::endl;
   }
-  {
-    OpenCL opencl;
-    std::fill(f2x.begin(), f2x.end(), 0);
-    std::fill(f2y.begin(), f2y.end(), 0);
-    {
-      Timer t;
-      opencl.exec1(&x[0], &y[0], &m[0], &f2x[0], &f2y[0], siz);
-    }
-    assert(compare(f1x, f2x), "results differ too much");
-    assert(compare(f1y, f2y), "results differ too much");
+
+  if (opencl) {
+    kernels.push_back({"ocl_forces", [&](std::vector<float> &fx, std::vector<float> &fy) {
+                         opencl->production(&x[0], &y[0], &m[0], &fx[0], &fy[0], siz);
+                       }});
+    kernels.push_back({"ocl_kernel1", [&](std::vector<float> &fx, std::vector<float> &fy) {
+                         opencl->exec1(&x[0], &y[0], &m[0], &fx[0], &fy[0], siz);
+                       }});
+    kernels.push_back({"ocl_kernel3", [&](std::vector<float> &fx, std::vector<float> &fy) {
+                         opencl->exec3(&x[0], &y[0], &m[0], &fx[0], &fy[0], siz);
+                       }});
   }
-  {
-    OpenCL opencl;
-    std::fill(f2x.begin(), f2x.end(), 0);
-    std::fill(f2y.begin(), f2y.end(), 0);
-    {
-      Timer t;
-      opencl.exec3(&x[0], &y[0], &m[0], &f2x[0], &f2y[0], siz);
+#else
+  (void)device;
+#endif
+
+  std::cout << std::setw(12) << "kernel" << std::setw(8) << "runs"
+            << std::setw(14) << "median [ms]" << std::setw(12) << "min [ms]"
+            << std::setw(12) << "MAD [ms]" << std::setw(16) << "interactions/s"
+            << std::setw(10) << "max ULP" << std::setw(10) << "p99 ULP"
+            << std::setw(8) << "status" << std::endl;
+
+  const Timer timer(warmup, repetitions, min_time);
+  bool all_passed = true;
+
+  for (const Kernel &kernel : kernels) {
+    std::vector<float> fx(siz);
+    std::vector<float> fy(siz);
+
+    Statistics stats;
+
+    try {
+      stats = timer.measure([&] { kernel.run(fx, fy); });
+    } catch (const std::exception &e) {
+      std::cout << std::setw(12) << kernel.name << "  error: " << e.what() << std::endl;
+      all_passed = false;
+      continue;
     }
-    assert(compare(f1x, f2x), "results differ too much");
-    assert(compare(f1y, f2y), "results differ too much");
+
+    const Accuracy accuracy = compare(ref_x, ref_y, fx, fy, max_ulp);
+    const bool passed = accuracy.failed <= 2 * siz / 100;   // 99% of components within max_ulp
+    all_passed &= passed;
+
+    const double interactions = double(siz) * (siz - 1) / 2.0;
+
+    std::cout << std::setw(12) << kernel.name << std::setw(8) << stats.samples
+              << std::setw(14) << stats.median << std::setw(12) << stats.min
+              << std::setw(12) << stats.mad
+              << std::setw(16) << interactions / (stats.median / 1000.0)
+              << std::setw(10) << accuracy.max << std::setw(10) << accuracy.p99
+              << std::setw(8) << (passed ? "ok" : "FAILED") << std::endl;
   }
 
-  return 0;
+  return all_passed ? 0 : 1;
 }
@@ -5,13 +5,28 @@
 #define CL_HPP_TARGET_OPENCL_VERSION 120
 #include <CL/cl2.hpp>
 
+#include <string>
+
+/*
+ * Runs forces kernels on OpenCL device.
+ * Program consists of production kernel (forces_kernel.cl, launched the
+ * same way OpenCLAccelerator does) and experimental ones (lab_kernels.cl).
+ */
 class OpenCL {
 public:
-  OpenCL();
+  enum DeviceType { Any, GPU, CPU };
+
+  // Preferred device type is searched on all platforms first, then any device
+  // is accepted (for example PoCL on machines without GPU).
+  // Throws std::runtime_error when there is no device or program cannot be built.
+  explicit OpenCL(DeviceType preferred = GPU);
+
+  std::string deviceName() const;
+
+  void production(const float *objX, const float *objY, const float *mass,
+                  float *forcex, float *forcey, const int count);
   void exec1(const float *objX, const float *objY, const float *mass,
              float *forcex, float *forcey, const int count);
-  void exec2(const float *objX, const float *objY, const float *mass,
-             float *forcex, float *forcey, const int count);
   void exec3(const float *objX, const float *objY, const float *mass,
              float *forcex, float *forcey, const int count);
 
@@ -1,20 +1,89 @@
-
 #pragma once
 
+#include <algorithm>
 #include <chrono>
-#include <iostream>
-#include <iomanip>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+/*
+ * Repeatable timing: operation is run 'warmup' times without measuring
+ * (caches, JIT compilation, clocks ramping up), then at least 'repetitions'
+ * times and for at least 'min_time' seconds. Median is the headline number,
+ * as it is not affected by occasional preemption.
+ */
+struct Statistics {
+  std::size_t samples = 0;
+  double min = 0.0;       // ms
+  double median = 0.0;    // ms
+  double mean = 0.0;      // ms
+  double stddev = 0.0;    // ms
+  double mad = 0.0;       // median absolute deviation, ms
+};
 
 class Timer {
-  using clock = std::chrono::high_resolution_clock;
+  using clock = std::chrono::steady_clock;
 
 public:
-  Timer() : start(clock::now()) {}
-  ~Timer() {
-    auto d = clock::now() - start;
-    std::cout << "Elapsed time: " << std::setw(16) << d.count() << "ns" << std::endl;
+  Timer(int warmup = 2, int repetitions = 10, double min_time = 0.5)
+      : warmup(warmup), repetitions(repetitions), min_time(min_time) {}
+
+  Statistics measure(const std::function<void()> &operation) const {
+    for (int i = 0; i < warmup; ++i)
+      operation();
+
+    std::vector<double> samples;
+    const auto begin = clock::now();
+
+    while (static_cast<int>(samples.size()) < repetitions ||
+           std::chrono::duration<double>(clock::now() - begin).count() < min_time) {
+      const auto start = clock::now();
+      operation();
+      const auto end = clock::now();
+
+      samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    return statistics(samples);
   }
 
 private:
-  std::chrono::time_point<clock> start;
+  static double median(std::vector<double> values) {
+    const std::size_t half = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + half, values.end());
+    const double upper = values[half];
+
+    if (values.size() % 2 == 1)
+      return upper;
+
+    const double lower = *std::max_element(values.begin(), values.begin() + half);
+    return (lower + upper) / 2.0;
+  }
+
+  static Statistics statistics(const std::vector<double> &samples) {
+    Statistics result;
+    result.samples = samples.size();
+    result.min = *std::min_element(samples.begin(), samples.end());
+    result.median = median(samples);
+
+    double sum = 0.0;
+    for (double s : samples)
+      sum += s;
+    result.mean = sum / samples.size();
+
+    double variance = 0.0;
+    std::vector<double> deviations;
+    for (double s : samples) {
+      variance += (s - result.mean) * (s - result.mean);
+      deviations.push_back(std::abs(s - result.median));
+    }
+    result.stddev = samples.size() > 1 ? std::sqrt(variance / (samples.size() - 1)) : 0.0;
+    result.mad = median(deviations);
+
+    return result;
+  }
+
+  const int warmup;
+  const int repetitions;
+  const double min_time;
 };
@@ -0,0 +1,375 @@
+/*
+ * Headless simulation runner
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "batch_runner.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include <omp.h>
+
+#include "accelerators/simple_cpu_accelerator.hpp"
+#include "accelerators/tiled_cpu_accelerator.hpp"
+
+#ifdef GRAVITY_AVX_ACCELERATOR
+#include "accelerators/avx_accelerator.hpp"
+#include "accelerators/avx_blocks_accelerator.hpp"
+#endif
+
+#ifdef GRAVITY_OPENCL_ACCELERATOR
+#include "accelerators/multi_opencl_accelerator.hpp"
+#include "accelerators/opencl_accelerator.hpp"
+#endif
+
+#if defined(GRAVITY_OPENCL_ACCELERATOR) && defined(GRAVITY_AVX_ACCELERATOR)
+#include "accelerators/hybrid_accelerator.hpp"
+#endif
+
+#include "checkpoint.hpp"
+#include "objects_loader.hpp"
+#include "simulation_engine.hpp"
+#include "tracing.hpp"
+#include "trajectory_writer.hpp"
+
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    double seconds(const Clock::time_point& from, const Clock::time_point& to)
+    {
+        return std::chrono::duration<double>(to - from).count();
+    }
+
+    std::string escape(const std::string& str)
+    {
+        std::string result;
+        result.reserve(str.size());
+
+        for(const char c: str)
+        {
+            if (c == '"' || c == '\\')
+                result += '\\';
+
+            if (static_cast<unsigned char>(c) < 0x20)
+                result += ' ';
+            else
+                result += c;
+        }
+
+        return result;
+    }
+
+    ObjectsLoader::Format scenarioFormat(const std::string& path)
+    {
+        const std::string extension = ".csv";
+
+        const bool csv = path.size() >= extension.size() &&
+                         path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+
+        return csv? ObjectsLoader::Csv: ObjectsLoader::Binary;
+    }
+}
+
+
+void RunSummary::writeJson(std::ostream& stream) const
+{
+    const double stepsPerSecond = runSeconds > 0.0? steps / runSeconds: 0.0;
+
+    // each step computes all pairs of objects (same definition as in accelerators_benchmark)
+    const double n = static_cast<double>(std::max(initialObjects, finalObjects));
+    const double interactionsPerSecond = stepsPerSecond * n * (n - 1.0) / 2.0;
+
+    stream << "{\n";
+    stream << "  \"success\": " << (success? "true": "false") << ",\n";
+    stream << "  \"error\": \"" << escape(error) << "\",\n";
+    stream << "  \"accelerator\": \"" << escape(accelerator) << "\",\n";
+    stream << "  \"threads\": " << threads << ",\n";
+    stream << "  \"objects\": { \"initial\": " << initialObjects << ", \"final\": " << finalObjects << " },\n";
+    stream << "  \"simulated_time\": " << simulatedTime << ",\n";
+    stream << "  \"steps\": " << steps << ",\n";
+    stream << "  \"wall_time\": { \"load\": " << loadSeconds
+           << ", \"run\": " << runSeconds
+           << ", \"io\": " << ioSeconds << " },\n";
+    stream << "  \"step_time\": { \"min\": " << minStepSeconds
+           << ", \"mean\": " << (steps > 0? runSeconds / steps: 0.0)
+           << ", \"max\": " << maxStepSeconds << " },\n";
+    stream << "  \"steps_per_second\": " << stepsPerSecond << ",\n";
+    stream << "  \"interactions_per_second\": " << interactionsPerSecond << ",\n";
+    stream << "  \"checkpoints\": " << checkpoints << ",\n";
+    stream << "  \"snapshots\": { \"written\": " << snapshotsWritten << ", \"dropped\": " << snapshotsDropped << " }\n";
+    stream << "}\n";
+}
+
+
+BatchRunner::BatchRunner(const RunConfig& config):
+    m_config(config)
+{
+
+}
+
+
+BatchRunner::~BatchRunner()
+{
+
+}
+
+
+RunSummary BatchRunner::run()
+{
+    RunSummary summary;
+    summary.accelerator = m_config.accelerator;
+
+    // SimulationEngine has one integrator (explicit Euler with adaptive time step)
+    if (m_config.integrator != "euler")
+    {
+        summary.error = "Unknown integrator: " + m_config.integrator;
+        return summary;
+    }
+
+    if (m_config.threads > 0)
+        omp_set_num_threads(m_config.threads);
+
+    summary.threads = omp_get_max_threads();
+
+    std::unique_ptr<IAccelerator> accelerator = createAccelerator(m_config.accelerator);
+
+    if (accelerator.get() == nullptr)
+    {
+        summary.error = "Unknown or unavailable accelerator: " + m_config.accelerator;
+        return summary;
+    }
+
+    const Clock::time_point loadStart = Clock::now();
+
+    std::unique_ptr<SimulationEngine> engine;
+
+    if (m_config.restore.empty() == false)
+    {
+        engine = Checkpoint::restore(m_config.restore, accelerator.get());
+
+        if (engine.get() == nullptr)
+        {
+            summary.error = "Could not restore checkpoint " + m_config.restore;
+            return summary;
+        }
+    }
+    else
+    {
+        ObjectsLoader loader(m_config.threads);
+
+        if (loader.open(m_config.scenario, scenarioFormat(m_config.scenario)) == false)
+        {
+            summary.error = loader.error();
+            return summary;
+        }
+
+        engine = std::make_unique<SimulationEngine>(accelerator.get(), loader.count());
+
+        if (loader.count() > 0 &&
+            engine->addObjects(loader.count(), [&loader](Objects& objects, std::size_t first) { return loader.load(objects, first); }) == 0)
+        {
+            summary.error = loader.error();
+            return summary;
+        }
+    }
+
+    summary.loadSeconds = seconds(loadStart, Clock::now());
+    summary.initialObjects = engine->objectCount();
+
+    if (summary.initialObjects == 0)
+    {
+        summary.error = "Nothing to simulate";
+        return summary;
+    }
+
+    engine->setDeviceResident(m_config.deviceResident);
+
+    std::unique_ptr<TrajectoryWriter> trajectory;
+
+    if (m_config.trajectory.empty() == false)
+    {
+        TrajectoryWriter::Config config;
+        config.interval = m_config.trajectoryInterval;
+        config.capacity = summary.initialObjects;
+        config.backpressure = TrajectoryWriter::Block;           // batch results should be complete
+        config.compress = m_config.compressTrajectory;
+
+        trajectory = std::make_unique<TrajectoryWriter>(m_config.trajectory, config);
+
+        if (trajectory->good() == false)
+        {
+            summary.error = "Could not open trajectory file " + m_config.trajectory;
+            return summary;
+        }
+
+        trajectory->capture(engine->objects(), engine->simulatedTime());
+    }
+
+    const double checkpointInterval = m_config.checkpointInterval > 0.0?
+                                      m_config.checkpointInterval:
+                                      std::numeric_limits<double>::infinity();
+
+    // restored engine continues its own time line, so end time and intervals are absolute
+    double time = engine->simulatedTime();
+    double nextCheckpoint = checkpointInterval;
+    bool ioFailed = false;
+
+    while (nextCheckpoint <= time)
+        nextCheckpoint += checkpointInterval;
+
+    auto saveCheckpoint = [&]()
+    {
+        if (Checkpoint::save(*engine, m_config.checkpoint))
+            summary.checkpoints++;
+        else
+        {
+            summary.error = "Could not write checkpoint " + m_config.checkpoint;
+            ioFailed = true;
+        }
+    };
+
+    summary.minStepSeconds = std::numeric_limits<double>::max();
+
+    if (m_config.trace.empty() == false)
+        Tracing::Tracer::instance().capture(m_config.traceFirstStep, m_config.traceSteps);
+
+    while (time < m_config.endTime && ioFailed == false)
+    {
+        const Clock::time_point stepStart = Clock::now();
+        engine->step();
+        time = engine->simulatedTime();
+        const Clock::time_point stepEnd = Clock::now();
+
+        const double stepSeconds = seconds(stepStart, stepEnd);
+        summary.runSeconds += stepSeconds;
+        summary.minStepSeconds = std::min(summary.minStepSeconds, stepSeconds);
+        summary.maxStepSeconds = std::max(summary.maxStepSeconds, stepSeconds);
+        summary.steps++;
+
+        // objects() downloads device resident objects, so ask for them only when needed
+        if (trajectory && trajectory->due(time))
+            trajectory->capture(engine->objects(), time);
+
+        if (m_config.checkpoint.empty() == false && time >= nextCheckpoint)
+        {
+            saveCheckpoint();
+
+            while (nextCheckpoint <= time)
+                nextCheckpoint += checkpointInterval;
+        }
+
+        summary.ioSeconds += seconds(stepEnd, Clock::now());
+    }
+
+    if (summary.steps == 0)
+        summary.minStepSeconds = 0.0;
+
+    const Clock::time_point finishStart = Clock::now();
+
+    if (m_config.checkpoint.empty() == false && ioFailed == false)
+        saveCheckpoint();
+
+    if (trajectory)
+    {
+        trajectory->close();
+
+        summary.snapshotsWritten = trajectory->written();
+        summary.snapshotsDropped = trajectory->dropped();
+
+        if (trajectory->good() == false && ioFailed == false)
+        {
+            summary.error = "Could not write trajectory file " + m_config.trajectory;
+            ioFailed = true;
+        }
+    }
+
+    if (m_config.trace.empty() == false)
+    {
+        Tracing::Tracer::instance().stop();
+
+        if (Tracing::Tracer::instance().exportChromeTrace(m_config.trace) == false && ioFailed == false)
+        {
+            summary.error = "Could not write trace file " + m_config.trace;
+            ioFailed = true;
+        }
+    }
+
+    summary.ioSeconds += seconds(finishStart, Clock::now());
+    summary.simulatedTime = time;
+    summary.finalObjects = engine->objectCount();
+    summary.success = ioFailed == false;
+
+    return summary;
+}
+
+
+std::vector<std::string> BatchRunner::accelerators()
+{
+    std::vector<std::string> result = { "cpu", "tiled" };
+
+#ifdef GRAVITY_AVX_ACCELERATOR
+    result.push_back("avx");
+    result.push_back("avx-blocks");
+#endif
+
+#ifdef GRAVITY_OPENCL_ACCELERATOR
+    result.push_back("opencl");
+    result.push_back("opencl-multi");
+#endif
+
+#if defined(GRAVITY_OPENCL_ACCELERATOR) && defined(GRAVITY_AVX_ACCELERATOR)
+    result.push_back("hybrid");
+#endif
+
+    return result;
+}
+
+
+std::unique_ptr<IAccelerator> BatchRunner::createAccelerator(const std::string& name)
+{
+    std::unique_ptr<IAccelerator> result;
+
+    if (name == "cpu")
+        result = std::make_unique<SimpleCpuAccelerator>();
+    else if (name == "tiled")
+        result = std::make_unique<TiledCpuAccelerator>();
+
+#ifdef GRAVITY_AVX_ACCELERATOR
+    else if (name == "avx")
+        result = std::make_unique<AVXAccelerator>();
+    else if (name == "avx-blocks")
+        result = std::make_unique<AVXBlocksAccelerator>();
+#endif
+
+#ifdef GRAVITY_OPENCL_ACCELERATOR
+    else if (name == "opencl")
+        result = std::make_unique<OpenCLAccelerator>();
+    else if (name == "opencl-multi")
+        result = std::make_unique<MultiOpenCLAccelerator>();
+#endif
+
+#if defined(GRAVITY_OPENCL_ACCELERATOR) && defined(GRAVITY_AVX_ACCELERATOR)
+    else if (name == "hybrid")
+        result = std::make_unique<HybridAccelerator>();
+#endif
+
+    return result;
+}
@@ -0,0 +1,100 @@
+/*
+ * Headless simulation runner
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BATCHRUNNER_HPP
+#define BATCHRUNNER_HPP
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct IAccelerator;
+
+
+struct RunConfig
+{
+    std::string scenario;                   // objects to load (csv or binary, see ObjectsLoader)
+    std::string restore;                    // checkpoint to continue from (instead of scenario)
+    std::string accelerator = "cpu";
+    std::string integrator = "euler";
+    unsigned int threads = 0;               // 0 = all cores
+    double endTime = 0.0;                   // simulated time to stop at (seconds, restored checkpoint keeps its time)
+    bool deviceResident = false;            // keep objects in accelerator's memory between steps (see SimulationEngine)
+
+    std::string checkpoint;                 // checkpoint file (empty = none)
+    double checkpointInterval = 0.0;        // simulated time between checkpoints (0 = only at the end)
+
+    std::string trajectory;                 // trajectory file (empty = none)
+    double trajectoryInterval = 0.0;        // simulated time between snapshots (0 = each step)
+    bool compressTrajectory = false;
+
+    std::string trace;                      // Chrome trace file (empty = none), needs ENABLE_TRACING build
+    unsigned long long traceFirstStep = 0;  // first traced step, counting from start of run
+    unsigned long long traceSteps = 100;    // number of traced steps
+};
+
+
+struct RunSummary
+{
+    bool success = false;
+    std::string error;
+
+    std::string accelerator;
+    unsigned int threads = 0;
+    std::size_t initialObjects = 0;
+    std::size_t finalObjects = 0;
+
+    double simulatedTime = 0.0;
+    long long steps = 0;
+
+    double loadSeconds = 0.0;
+    double runSeconds = 0.0;                // steps only, without I/O done in this thread
+    double ioSeconds = 0.0;                 // checkpoints and trajectory captures
+    double minStepSeconds = 0.0;
+    double maxStepSeconds = 0.0;
+
+    std::size_t checkpoints = 0;
+    std::size_t snapshotsWritten = 0;
+    std::size_t snapshotsDropped = 0;
+
+    void writeJson(std::ostream &) const;
+};
+
+
+// Runs one simulation from start to end time as fast as possible, no rendering.
+class BatchRunner
+{
+    public:
+        explicit BatchRunner(const RunConfig &);
+        BatchRunner(const BatchRunner &) = delete;
+        ~BatchRunner();
+
+        BatchRunner& operator=(const BatchRunner &) = delete;
+
+        RunSummary run();
+
+        static std::vector<std::string> accelerators();        // names accepted by RunConfig::accelerator
+        static std::unique_ptr<IAccelerator> createAccelerator(const std::string& name);
+
+    private:
+        const RunConfig m_config;
+};
+
+#endif // BATCHRUNNER_HPP
@@ -0,0 +1,137 @@
+
+#include <fstream>
+#include <iostream>
+
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <boost/program_options/parsers.hpp>
+
+#include "batch_runner.hpp"
+
+
+namespace po = boost::program_options;
+
+
+namespace
+{
+    std::string join(const std::vector<std::string>& items)
+    {
+        std::string result;
+
+        for(const std::string& item: items)
+            result += (result.empty()? "": ", ") + item;
+
+        return result;
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    RunConfig config;
+    std::string configFile;
+    std::string summaryFile;
+
+    po::options_description generic("Generic options");
+    generic.add_options()
+        ("config,c", po::value<std::string>(&configFile), "read run configuration from file (same keys as long options)")
+        ("summary,s", po::value<std::string>(&summaryFile), "write performance summary (JSON) to file instead of stdout")
+        ("help,h", "show help message")
+    ;
+
+    po::options_description run("Run configuration");
+    run.add_options()
+        ("scenario", po::value<std::string>(&config.scenario), "initial objects (*.csv or binary file)")
+        ("restore", po::value<std::string>(&config.restore), "continue from checkpoint instead of scenario")
+        ("accelerator", po::value<std::string>(&config.accelerator)->default_value(config.accelerator),
+            ("one of: " + join(BatchRunner::accelerators())).c_str())
+        ("integrator", po::value<std::string>(&config.integrator)->default_value(config.integrator), "integration method (euler)")
+        ("threads", po::value<unsigned int>(&config.threads)->default_value(config.threads), "number of threads (0 = all cores)")
+        ("device-resident", po::bool_switch(&config.deviceResident), "keep objects in accelerator's memory between steps (opencl)")
+        ("end-time", po::value<double>(&config.endTime)->required(), "simulated time to stop at [s] (restored run continues from time of checkpoint)")
+        ("checkpoint", po::value<std::string>(&config.checkpoint), "checkpoint file")
+        ("checkpoint-interval", po::value<double>(&config.checkpointInterval)->default_value(config.checkpointInterval),
+            "simulated time between checkpoints [s] (0 = only at the end)")
+        ("trajectory", po::value<std::string>(&config.trajectory), "trajectory file")
+        ("trajectory-interval", po::value<double>(&config.trajectoryInterval)->default_value(config.trajectoryInterval),
+            "simulated time between trajectory snapshots [s] (0 = each step)")
+        ("compress-trajectory", po::bool_switch(&config.compressTrajectory), "use lossy trajectory compression")
+        ("trace", po::value<std::string>(&config.trace), "timeline of steps in Chrome trace format (chrome://tracing, ui.perfetto.dev)")
+        ("trace-first-step", po::value<unsigned long long>(&config.traceFirstStep)->default_value(config.traceFirstStep),
+            "first step to trace")
+        ("trace-steps", po::value<unsigned long long>(&config.traceSteps)->default_value(config.traceSteps), "number of steps to trace")
+    ;
+
+    po::options_description all("Options");
+    all.add(generic).add(run);
+
+    po::variables_map vm;
+
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, all), vm);
+
+        if (vm.count("help"))
+        {
+            std::cout << all << std::endl;
+
+            return 0;
+        }
+
+        // command line has priority over config file
+        if (vm.count("config"))
+        {
+            const std::string path = vm["config"].as<std::string>();
+            std::ifstream file(path);
+
+            if (file.fail())
+            {
+                std::cerr << "Could not open file " << path << " for reading" << std::endl;
+                return 1;
+            }
+
+            po::store(po::parse_config_file(file, run), vm);
+        }
+
+        po::notify(vm);
+    }
+    catch(const std::logic_error& error)
+    {
+        std::cerr << error.what() << std::endl;
+
+        return 1;
+    }
+
+    if (config.scenario.empty() == config.restore.empty())
+    {
+        std::cerr << "Exactly one of scenario and restore options is required" << std::endl;
+
+        return 1;
+    }
+
+    BatchRunner runner(config);
+    const RunSummary summary = runner.run();
+
+    bool summaryWritten = true;
+
+    if (summaryFile.empty())
+        summary.writeJson(std::cout);
+    else
+    {
+        std::ofstream file(summaryFile, std::ios_base::out | std::ios_base::trunc);
+        summary.writeJson(file);
+        file.close();
+
+        if (file.fail())
+        {
+            std::cerr << "Could not write file " << summaryFile << std::endl;
+            summaryWritten = false;
+        }
+    }
+
+    if (summary.success == false)
+        std::cerr << summary.error << std::endl;
+
+    // 1: invalid usage, 2: simulation failed, 3: results could not be written
+    return summary.success == false? 2: summaryWritten? 0: 3;
+}
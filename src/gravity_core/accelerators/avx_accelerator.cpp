@@ -74,6 +74,62 @@ AVXAccelerator::~AVXAccelerator()
 }
 
 
+void AVXAccelerator::forcesOn(std::size_t first, std::size_t last, force_vector_t* forces) const
+{
+    const std::size_t objs = m_objects->size();
+    const std::size_t last_simd_idx = objs & (-8);
+
+    const float G = 6.6732e-11;
+    const __m256 vG = _mm256_set1_ps(G);
+    const __m256 zero = _mm256_setzero_ps();
+
+    #pragma omp parallel for schedule(static)
+    for(std::size_t i = first; i < last; i++)
+    {
+        const __m256 x0 = _mm256_set1_ps(m_objects->getX()[i]);
+        const __m256 y0 = _mm256_set1_ps(m_objects->getY()[i]);
+        const __m256 vG_m0 = _mm256_mul_ps(vG, _mm256_set1_ps(m_objects->getMass()[i]));
+
+        __m256 fx = zero;
+        __m256 fy = zero;
+
+        std::size_t j = 0;
+        for(; j < last_simd_idx; j += 8)
+        {
+            const __m256 x1234 = _mm256_load_ps( &m_objects->getX()[j] );
+            const __m256 y1234 = _mm256_load_ps( &m_objects->getY()[j] );
+            const __m256 m1234 = _mm256_load_ps( &m_objects->getMass()[j] );
+
+            const __m256 dx = _mm256_sub_ps(x1234, x0);
+            const __m256 dy = _mm256_sub_ps(y1234, y0);
+            const __m256 dist2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            const __m256 dist = _mm256_sqrt_ps(dist2);
+
+            // Fg divided by distance (to turn [dx, dy] into unit vector)
+            const __m256 Fg = _mm256_mul_ps(vG_m0, _mm256_div_ps(m1234, dist2));
+            const __m256 Fg_dist = _mm256_div_ps(Fg, dist);
+
+            // object i itself (and objects at the same place) does not attract
+            const __m256 valid = _mm256_cmp_ps(dist2, zero, _CMP_NEQ_OQ);
+            const __m256 f = _mm256_and_ps(Fg_dist, valid);
+
+            fx = _mm256_add_ps(fx, _mm256_mul_ps(dx, f));
+            fy = _mm256_add_ps(fy, _mm256_mul_ps(dy, f));
+        }
+
+        force_vector_t result;
+        for (int k = 0; k < 8; k++)
+            result += XY(fx[k], fy[k]);
+
+        for(; j < objs; j++)
+            if (j != i)
+                result += force(i, j);
+
+        forces[i - first] = result;
+    }
+}
+
+
 void AVXAccelerator::forcesFor(std::size_t i, std::vector<force_vector_t>& forces) const
 {
     const std::size_t objs = m_objects->size();
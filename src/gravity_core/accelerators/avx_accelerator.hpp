@@ -37,6 +37,11 @@ class AVXAccelerator: public CpuAcceleratorBase
 
         AVXAccelerator& operator=(const AVXAccelerator &) = delete;
 
+        // Forces acting on objects [first, last) from all objects, written to forces[0, last - first).
+        // Unlike forces() it does not use symmetry of forces, so each object is independent of others
+        // and part of them may be computed elsewhere (see HybridAccelerator).
+        void forcesOn(std::size_t first, std::size_t last, force_vector_t* forces) const;
+
     private:
         virtual void forcesFor(std::size_t, std::vector<force_vector_t> &) const override;
 };
@@ -0,0 +1,371 @@
+/*
+ * AVX based engine running 8 simulations at once.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "avx_batched_engine.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+
+namespace
+{
+    const int AllLanes = (1 << AVXBatchedEngine::Lanes) - 1;
+
+    float alive_bits()
+    {
+        const int bits = -1;
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+
+        return result;
+    }
+}
+
+
+AVXBatchedEngine::AVXBatchedEngine(std::size_t objects):
+    m_objects(objects),
+    m_x(objects * Lanes, 0.0f),
+    m_y(objects * Lanes, 0.0f),
+    m_vx(objects * Lanes, 0.0f),
+    m_vy(objects * Lanes, 0.0f),
+    m_mass(objects * Lanes, 0.0f),
+    m_radius(objects * Lanes, 0.0f),
+    m_alive(objects * Lanes, 0.0f),
+    m_fx(objects * Lanes),
+    m_fy(objects * Lanes),
+    m_newX(objects * Lanes),
+    m_newY(objects * Lanes),
+    m_newVX(objects * Lanes),
+    m_newVY(objects * Lanes),
+    m_collisions()
+{
+    for(int l = 0; l < Lanes; l++)
+        m_dt[l] = 60.0;                 // the same initial value as SimulationEngine uses
+}
+
+
+AVXBatchedEngine::~AVXBatchedEngine()
+{
+
+}
+
+
+void AVXBatchedEngine::setObjects(int lane, const std::vector<Object>& objects)
+{
+    assert(lane >= 0 && lane < Lanes);
+    assert(objects.size() <= m_objects);
+
+    for(std::size_t i = 0; i < m_objects; i++)
+    {
+        const std::size_t idx = i * Lanes + lane;
+        const bool exists = i < objects.size();
+
+        m_x[idx]      = exists? objects[i].pos().x: 0.0f;
+        m_y[idx]      = exists? objects[i].pos().y: 0.0f;
+        m_vx[idx]     = exists? objects[i].velocity().x.raw_value(): 0.0f;
+        m_vy[idx]     = exists? objects[i].velocity().y.raw_value(): 0.0f;
+        m_mass[idx]   = exists? objects[i].mass().raw_value(): 0.0f;
+        m_radius[idx] = exists? objects[i].radius(): 0.0f;
+        m_alive[idx]  = exists? alive_bits(): 0.0f;
+    }
+
+    m_dt[lane] = 60.0;
+}
+
+
+std::vector<int> AVXBatchedEngine::stepBy(double dt)
+{
+    return stepBy( std::vector<double>(Lanes, dt) );
+}
+
+
+std::vector<int> AVXBatchedEngine::stepBy(const std::vector<double>& dt)
+{
+    assert(dt.size() == Lanes);
+
+    std::vector<double> remaining(dt);
+    std::vector<int> steps(Lanes, 0);
+
+    for(;;)
+    {
+        // simulations which still have time to go
+        int active = 0;
+        for(int l = 0; l < Lanes; l++)
+            if (remaining[l] > 0.0)
+                active |= 1 << l;
+
+        if (active == 0)
+            break;
+
+        step(active);
+
+        for(int l = 0; l < Lanes; l++)
+            if (active & (1 << l))
+            {
+                remaining[l] -= m_dt[l];
+                steps[l]++;
+            }
+    }
+
+    return steps;
+}
+
+
+void AVXBatchedEngine::objects(int lane, Objects& objects) const
+{
+    for(std::size_t i = 0; i < m_objects; i++)
+    {
+        const std::size_t idx = i * Lanes + lane;
+
+        if (m_mass[idx] > 0.0f)
+            objects.insert( Object(m_x[idx], m_y[idx], m_mass[idx], m_radius[idx], m_vx[idx], m_vy[idx]), i + 1 );
+    }
+}
+
+
+std::size_t AVXBatchedEngine::objectCount(int lane) const
+{
+    std::size_t count = 0;
+
+    for(std::size_t i = 0; i < m_objects; i++)
+        if (m_mass[i * Lanes + lane] > 0.0f)
+            count++;
+
+    return count;
+}
+
+
+double AVXBatchedEngine::dt(int lane) const
+{
+    return m_dt[lane];
+}
+
+
+void AVXBatchedEngine::step(int active)
+{
+    const __m256 activeMask = _mm256_castsi256_ps(
+        _mm256_setr_epi32(active & 1? -1: 0, active & 2? -1: 0, active & 4? -1: 0, active & 8? -1: 0,
+                          active & 16? -1: 0, active & 32? -1: 0, active & 64? -1: 0, active & 128? -1: 0)
+    );
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    forces();
+
+    // Find time step for each lane. Lanes which are not active are considered optimal.
+    int optimal = ~active & AllLanes;
+
+    do
+    {
+        const __m256 dt = _mm256_setr_ps(m_dt[0], m_dt[1], m_dt[2], m_dt[3], m_dt[4], m_dt[5], m_dt[6], m_dt[7]);
+        __m256 max_travel = _mm256_setzero_ps();
+
+        for(std::size_t i = 0; i < m_objects; i++)
+        {
+            const std::size_t idx = i * Lanes;
+            const __m256 alive = _mm256_load_ps(&m_alive[idx]);
+            const __m256 mass = _mm256_blendv_ps(one, _mm256_load_ps(&m_mass[idx]), alive);
+
+            // F=am ⇒ a = F/m, ΔV = aΔt
+            const __m256 dvx = _mm256_mul_ps(_mm256_div_ps(_mm256_load_ps(&m_fx[idx]), mass), dt);
+            const __m256 dvy = _mm256_mul_ps(_mm256_div_ps(_mm256_load_ps(&m_fy[idx]), mass), dt);
+
+            const __m256 x = _mm256_load_ps(&m_x[idx]);
+            const __m256 y = _mm256_load_ps(&m_y[idx]);
+            const __m256 vx = _mm256_add_ps(dvx, _mm256_load_ps(&m_vx[idx]));
+            const __m256 vy = _mm256_add_ps(dvy, _mm256_load_ps(&m_vy[idx]));
+            const __m256 nx = _mm256_add_ps(x, _mm256_mul_ps(vx, dt));
+            const __m256 ny = _mm256_add_ps(y, _mm256_mul_ps(vy, dt));
+
+            _mm256_store_ps(&m_newVX[idx], vx);
+            _mm256_store_ps(&m_newVY[idx], vy);
+            _mm256_store_ps(&m_newX[idx], nx);
+            _mm256_store_ps(&m_newY[idx], ny);
+
+            const __m256 tx = _mm256_sub_ps(nx, x);
+            const __m256 ty = _mm256_sub_ps(ny, y);
+            const __m256 travel = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(tx, tx), _mm256_mul_ps(ty, ty)));
+
+            max_travel = _mm256_max_ps(max_travel, _mm256_and_ps(travel, alive));
+        }
+
+        float travels[Lanes];
+        _mm256_storeu_ps(travels, max_travel);
+
+        // do not allow too big jumps (precission loss) nor no small ones (performance loss)
+        for(int l = 0; l < Lanes; l++)
+        {
+            if (optimal & (1 << l))
+                continue;
+
+            if (travels[l] > 100e3)
+                m_dt[l] = m_dt[l] * 100e3 / travels[l];
+            else if (travels[l] < 1e3 && travels[l] > 0.0f)
+                m_dt[l] = m_dt[l] * 1e3 / travels[l];
+            else
+                optimal |= 1 << l;          // nothing moves at all also ends search
+        }
+    }
+    while(optimal != AllLanes);
+
+    // apply new positions and speeds for active simulations (and existing objects)
+    for(std::size_t i = 0; i < m_objects; i++)
+    {
+        const std::size_t idx = i * Lanes;
+        const __m256 update = _mm256_and_ps(activeMask, _mm256_load_ps(&m_alive[idx]));
+
+        _mm256_store_ps(&m_x[idx], _mm256_blendv_ps(_mm256_load_ps(&m_x[idx]), _mm256_load_ps(&m_newX[idx]), update));
+        _mm256_store_ps(&m_y[idx], _mm256_blendv_ps(_mm256_load_ps(&m_y[idx]), _mm256_load_ps(&m_newY[idx]), update));
+        _mm256_store_ps(&m_vx[idx], _mm256_blendv_ps(_mm256_load_ps(&m_vx[idx]), _mm256_load_ps(&m_newVX[idx]), update));
+        _mm256_store_ps(&m_vy[idx], _mm256_blendv_ps(_mm256_load_ps(&m_vy[idx]), _mm256_load_ps(&m_newVY[idx]), update));
+    }
+
+    collisions(active);
+}
+
+
+void AVXBatchedEngine::forces()
+{
+    const __m256 G = _mm256_set1_ps(6.6732e-11f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    std::fill(m_fx.begin(), m_fx.end(), 0.0f);
+    std::fill(m_fy.begin(), m_fy.end(), 0.0f);
+
+    for(std::size_t i = 0; i < m_objects; i++)
+    {
+        const std::size_t iidx = i * Lanes;
+
+        const __m256 xi = _mm256_load_ps(&m_x[iidx]);
+        const __m256 yi = _mm256_load_ps(&m_y[iidx]);
+        const __m256 alive_i = _mm256_load_ps(&m_alive[iidx]);
+        const __m256 G_mi = _mm256_mul_ps(G, _mm256_load_ps(&m_mass[iidx]));
+
+        __m256 fxi = _mm256_load_ps(&m_fx[iidx]);
+        __m256 fyi = _mm256_load_ps(&m_fy[iidx]);
+
+        for(std::size_t j = i + 1; j < m_objects; j++)
+        {
+            const std::size_t jidx = j * Lanes;
+
+            const __m256 valid = _mm256_and_ps(alive_i, _mm256_load_ps(&m_alive[jidx]));
+
+            const __m256 x_diff = _mm256_sub_ps(_mm256_load_ps(&m_x[jidx]), xi);
+            const __m256 y_diff = _mm256_sub_ps(_mm256_load_ps(&m_y[jidx]), yi);
+
+            // missing objects get fake distance (no NaNs) and no force
+            __m256 dist = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(x_diff, x_diff), _mm256_mul_ps(y_diff, y_diff)));
+            dist = _mm256_blendv_ps(one, dist, valid);
+
+            const __m256 dist2 = _mm256_mul_ps(dist, dist);
+
+            // (G * mi) and (mj / dist2) are here to decrease partial results - for floats "mi * mj" may be a killer
+            const __m256 Fg = _mm256_and_ps(_mm256_mul_ps(G_mi, _mm256_div_ps(_mm256_load_ps(&m_mass[jidx]), dist2)), valid);
+
+            const __m256 fx = _mm256_mul_ps(_mm256_div_ps(x_diff, dist), Fg);
+            const __m256 fy = _mm256_mul_ps(_mm256_div_ps(y_diff, dist), Fg);
+
+            fxi = _mm256_add_ps(fxi, fx);
+            fyi = _mm256_add_ps(fyi, fy);
+
+            _mm256_store_ps(&m_fx[jidx], _mm256_sub_ps(_mm256_load_ps(&m_fx[jidx]), fx));
+            _mm256_store_ps(&m_fy[jidx], _mm256_sub_ps(_mm256_load_ps(&m_fy[jidx]), fy));
+        }
+
+        _mm256_store_ps(&m_fx[iidx], fxi);
+        _mm256_store_ps(&m_fy[iidx], fyi);
+    }
+}
+
+
+void AVXBatchedEngine::collisions(int active)
+{
+    // find all colliding pairs first (as SimulationEngine does) ...
+    m_collisions.clear();
+
+    for(std::size_t i = 0; i < m_objects; i++)
+    {
+        const std::size_t iidx = i * Lanes;
+
+        const __m256 xi = _mm256_load_ps(&m_x[iidx]);
+        const __m256 yi = _mm256_load_ps(&m_y[iidx]);
+        const __m256 ri = _mm256_load_ps(&m_radius[iidx]);
+        const __m256 alive_i = _mm256_load_ps(&m_alive[iidx]);
+
+        for(std::size_t j = i + 1; j < m_objects; j++)
+        {
+            const std::size_t jidx = j * Lanes;
+
+            const __m256 x_diff = _mm256_sub_ps(_mm256_load_ps(&m_x[jidx]), xi);
+            const __m256 y_diff = _mm256_sub_ps(_mm256_load_ps(&m_y[jidx]), yi);
+            const __m256 dist = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(x_diff, x_diff), _mm256_mul_ps(y_diff, y_diff)));
+            const __m256 r = _mm256_add_ps(ri, _mm256_load_ps(&m_radius[jidx]));
+
+            const __m256 hit = _mm256_and_ps(_mm256_cmp_ps(r, dist, _CMP_GT_OQ),
+                                             _mm256_and_ps(alive_i, _mm256_load_ps(&m_alive[jidx])));
+
+            const int lanes = _mm256_movemask_ps(hit) & active;
+
+            if (lanes != 0)
+                m_collisions.push_back( Collision{i, j, lanes} );
+        }
+    }
+
+    // ... and then resolve them, skipping objects which were already annihilated
+    for(const Collision& collision: m_collisions)
+        for(int l = 0; l < Lanes; l++)
+            if (collision.lanes & (1 << l))
+                collide(collision.i, collision.j, l);
+}
+
+
+void AVXBatchedEngine::collide(std::size_t i, std::size_t j, int lane)
+{
+    const std::size_t iidx = i * Lanes + lane;
+    const std::size_t jidx = j * Lanes + lane;
+
+    if (m_mass[iidx] == 0.0f || m_mass[jidx] == 0.0f)
+        return;
+
+    const std::size_t heavier = m_mass[iidx] > m_mass[jidx]? iidx: jidx;
+    const std::size_t lighter = heavier == iidx? jidx: iidx;
+
+    // correct velocity by summing momentums
+    const float masses = m_mass[heavier] + m_mass[lighter];
+    const float momentum_x = m_vx[heavier] * m_mass[heavier] + m_vx[lighter] * m_mass[lighter];
+    const float momentum_y = m_vy[heavier] * m_mass[heavier] + m_vy[lighter] * m_mass[lighter];
+
+    m_vx[heavier] = momentum_x / masses;
+    m_vy[heavier] = momentum_y / masses;
+
+    // increase mass and radius
+    m_radius[heavier] = std::cbrt( std::pow( m_radius[heavier], 3 ) + std::pow( m_radius[lighter], 3 ) );
+    m_mass[heavier] = masses;
+
+    // annihilate lighter one
+    m_x[lighter]      = 0.0f;
+    m_y[lighter]      = 0.0f;
+    m_vx[lighter]     = 0.0f;
+    m_vy[lighter]     = 0.0f;
+    m_mass[lighter]   = 0.0f;
+    m_radius[lighter] = 0.0f;
+    m_alive[lighter]  = 0.0f;
+}
@@ -0,0 +1,94 @@
+/*
+ * AVX based engine running 8 simulations at once.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AVXBATCHEDENGINE_HPP
+#define AVXBATCHEDENGINE_HPP
+
+#include <vector>
+
+#include "../objects.hpp"
+
+
+// Engine for tiny systems (tens of objects).
+// For such systems SIMD lanes cannot be filled with objects of one simulation,
+// so here each lane holds different, independent simulation.
+// Data of object 'i' of all 8 simulations forms one AVX register, so pair loops
+// advance all simulations at once.
+// Simulations may have different number of objects - missing ones are masked out.
+// Each simulation has its own time step, collisions are detected with masks and resolved per lane.
+// Physics is the same as in SimulationEngine + SimpleCpuAccelerator.
+class AVXBatchedEngine
+{
+    public:
+        static const int Lanes = 8;
+
+        AVXBatchedEngine(std::size_t objects);                      // max number of objects in one simulation
+        AVXBatchedEngine(const AVXBatchedEngine &) = delete;
+        ~AVXBatchedEngine();
+
+        AVXBatchedEngine& operator=(const AVXBatchedEngine &) = delete;
+
+        void setObjects(int lane, const std::vector<Object> &);     // set up simulation in given lane
+
+        std::vector<int> stepBy(double);                            // advance all simulations by the same time. Returns number of steps for each lane.
+        std::vector<int> stepBy(const std::vector<double> &);       // advance each simulation by its own time.
+
+        void objects(int lane, Objects &) const;                    // append objects of given simulation. Object id is its index in simulation + 1
+        std::size_t objectCount(int lane) const;
+        double dt(int lane) const;
+
+    private:
+        typedef std::vector<float, Objects::AlignmentAllocator<float, 64>> LanesVector;
+
+        struct Collision
+        {
+            std::size_t i;
+            std::size_t j;
+            int lanes;
+        };
+
+        std::size_t m_objects;
+
+        // data of i-th object of lane 'l' is at position i * Lanes + l
+        LanesVector m_x;
+        LanesVector m_y;
+        LanesVector m_vx;
+        LanesVector m_vy;
+        LanesVector m_mass;
+        LanesVector m_radius;
+        LanesVector m_alive;                    // all bits set for existing objects
+
+        // buffers for calculations
+        LanesVector m_fx;
+        LanesVector m_fy;
+        LanesVector m_newX;
+        LanesVector m_newY;
+        LanesVector m_newVX;
+        LanesVector m_newVY;
+        std::vector<Collision> m_collisions;
+
+        double m_dt[Lanes];
+
+        void step(int active);
+        void forces();
+        void collisions(int active);
+        void collide(std::size_t i, std::size_t j, int lane);
+};
+
+#endif // AVXBATCHEDENGINE_HPP
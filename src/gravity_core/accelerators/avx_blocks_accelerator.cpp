@@ -0,0 +1,297 @@
+/*
+ * AVX based accelerator working on objects packed into blocks.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "avx_blocks_accelerator.hpp"
+
+#include <cassert>
+#include <immintrin.h>
+#include <omp.h>
+
+#include "../objects.hpp"
+#include "../tracing.hpp"
+
+
+namespace
+{
+    // mask of lanes which index (within block) is in range [first, last)
+    __m256 lanes_mask(int first, int last)
+    {
+        const __m256 lanes = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256 vfirst = _mm256_set1_ps(first);
+        const __m256 vlast = _mm256_set1_ps(last);
+
+        const __m256 above = _mm256_cmp_ps(lanes, vfirst, _CMP_GE_OQ);
+        const __m256 below = _mm256_cmp_ps(lanes, vlast, _CMP_LT_OQ);
+
+        return _mm256_and_ps(above, below);
+    }
+
+    float horizontal_sum(const __m256& v)
+    {
+        const __m128 lo = _mm256_castps256_ps128(v);
+        const __m128 hi = _mm256_extractf128_ps(v, 1);
+        __m128 sum = _mm_add_ps(lo, hi);
+        sum = _mm_hadd_ps(sum, sum);
+        sum = _mm_hadd_ps(sum, sum);
+
+        return _mm_cvtss_f32(sum);
+    }
+}
+
+
+AVXBlocksAccelerator::AVXBlocksAccelerator(Objects* objects):
+    m_objects(objects),
+    m_blocks()
+{
+
+}
+
+
+AVXBlocksAccelerator::~AVXBlocksAccelerator()
+{
+
+}
+
+
+void AVXBlocksAccelerator::setObjects(Objects* objects)
+{
+    m_objects = objects;
+}
+
+
+std::vector<force_vector_t> AVXBlocksAccelerator::forces()
+{
+    assert(m_objects != nullptr);
+
+    {
+        TRACE_SCOPE("accelerator", "blocks assign");
+        m_blocks.assign(*m_objects);
+    }
+
+    const std::size_t objs = m_blocks.size();
+    const std::size_t blocks = m_blocks.blocks();
+
+    // prepare private tables for threads for results, so we don't get races when accessing 'forces'
+    const int threads = omp_get_max_threads();
+    std::vector<ForceBlocks> private_forces(threads);
+
+    for(int t = 0; t < threads; t++)
+        private_forces[t] = ForceBlocks(blocks);
+
+    #pragma omp parallel
+    {
+        TRACE_SCOPE("accelerator", "forces worker");
+
+        #pragma omp for schedule(static, 1) nowait
+        for(std::size_t i = 0; i < objs - 1; i++)
+        {
+            const int tid = omp_get_thread_num();
+            forcesFor(i, private_forces[tid]);
+        }
+    }
+
+    TRACE_SCOPE("accelerator", "forces reduction");
+
+    // accumulate results
+    std::vector<force_vector_t> forces(objs);
+
+    for(int t = 0; t < threads; t++)
+        for(std::size_t i = 0; i < objs; i++)
+        {
+            const ForceBlock& f = private_forces[t][i / Blocks::width];
+            const std::size_t l = i % Blocks::width;
+
+            forces[i] += XY(f.x[l], f.y[l]);
+        }
+
+    return forces;
+}
+
+
+std::vector<XY> AVXBlocksAccelerator::velocities(const std::vector<force_vector_t>& forces, time_type dt) const
+{
+    assert(m_objects != nullptr);
+
+    const std::size_t objs = m_objects->size();
+    std::vector<XY> result;
+    result.reserve(objs);
+
+    for(std::size_t i = 0; i < objs; i++)
+    {
+        const force_vector_t& dF = forces[i];
+        const Object& o = (*m_objects)[i];
+
+        // F=am ⇒ a = F/m
+        const acceleration_vector_t a = dF / o.mass();
+
+        // ΔV = aΔt
+        const velocity_vector_t dv = a * dt;
+
+        result.push_back(dv);
+    }
+
+    return result;
+}
+
+
+std::vector<std::pair<int, int>> AVXBlocksAccelerator::collisions() const
+{
+    assert(m_objects != nullptr);
+
+    m_blocks.assign(*m_objects);
+
+    const std::size_t objs = m_blocks.size();
+
+    const int threads = omp_get_max_threads();
+    std::vector< std::vector< std::pair<int, int> > > toColide(threads);
+
+    // calculate collisions in parallel
+    #pragma omp parallel
+    {
+        TRACE_SCOPE("accelerator", "collisions worker");
+
+        #pragma omp for schedule(static, 1) nowait
+        for(std::size_t i = 0; i < objs - 1; i++)
+        {
+            const int tid = omp_get_thread_num();
+            collisionsFor(i, toColide[tid]);
+        }
+    }
+
+    std::vector<std::pair<int, int>> result;
+
+    // collect data from threads into one set of objects to be colided
+    for(int t = 0; t < threads; t++)
+    {
+        const auto& thread_colided = toColide[t];
+        for(std::size_t i = 0; i < thread_colided.size(); i++)
+            result.push_back( thread_colided[i] );
+    }
+
+    return result;
+}
+
+
+void AVXBlocksAccelerator::forcesFor(std::size_t i, ForceBlocks& forces) const
+{
+    const std::size_t width = Blocks::width;
+    const std::size_t objs = m_blocks.size();
+    const std::size_t first_block = i / width;
+    const std::size_t last_block = (objs - 1) / width;
+
+    const Blocks::Block& bi = m_blocks.block(first_block);
+    const std::size_t li = i % width;
+
+    const float G = 6.6732e-11;
+    const __m256 x0 = _mm256_set1_ps(bi.x[li]);
+    const __m256 y0 = _mm256_set1_ps(bi.y[li]);
+    const __m256 G_m0 = _mm256_set1_ps(G * bi.mass[li]);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    __m256 fx0 = _mm256_setzero_ps();
+    __m256 fy0 = _mm256_setzero_ps();
+
+    for(std::size_t b = first_block; b <= last_block; b++)
+    {
+        const Blocks::Block& bj = m_blocks.block(b);
+
+        const __m256 x = _mm256_load_ps(bj.x);
+        const __m256 y = _mm256_load_ps(bj.y);
+        __m256 m = _mm256_load_ps(bj.mass);
+
+        const __m256 x_diff = _mm256_sub_ps(x, x0);
+        const __m256 y_diff = _mm256_sub_ps(y, y0);
+        __m256 dist2 = _mm256_add_ps(_mm256_mul_ps(x_diff, x_diff), _mm256_mul_ps(y_diff, y_diff));
+
+        // only objects after i-th one are to be calculated (and only existing ones).
+        // Turn off other lanes by zeroing mass and faking distance so no NaNs are produced.
+        if (b == first_block || b == last_block)
+        {
+            const int first = b == first_block? li + 1: 0;
+            const int last = b == last_block? objs - b * width: width;
+            const __m256 mask = lanes_mask(first, last);
+
+            m = _mm256_and_ps(m, mask);
+            dist2 = _mm256_blendv_ps(one, dist2, mask);
+        }
+
+        const __m256 dist = _mm256_sqrt_ps(dist2);
+
+        // (G * m0) and (m / dist2) are here to decrease partial results - for floats "m0 * m" may be a killer
+        const __m256 Fg = _mm256_mul_ps(G_m0, _mm256_div_ps(m, dist2));
+        const __m256 Fg_dist = _mm256_div_ps(Fg, dist);
+
+        const __m256 fx = _mm256_mul_ps(x_diff, Fg_dist);
+        const __m256 fy = _mm256_mul_ps(y_diff, Fg_dist);
+
+        fx0 = _mm256_add_ps(fx0, fx);
+        fy0 = _mm256_add_ps(fy0, fy);
+
+        ForceBlock& fj = forces[b];
+        _mm256_store_ps(fj.x, _mm256_sub_ps(_mm256_load_ps(fj.x), fx));
+        _mm256_store_ps(fj.y, _mm256_sub_ps(_mm256_load_ps(fj.y), fy));
+    }
+
+    ForceBlock& fi = forces[first_block];
+    fi.x[li] += horizontal_sum(fx0);
+    fi.y[li] += horizontal_sum(fy0);
+}
+
+
+void AVXBlocksAccelerator::collisionsFor(std::size_t i, std::vector<std::pair<int, int>>& colided) const
+{
+    const std::size_t width = Blocks::width;
+    const std::size_t objs = m_blocks.size();
+    const std::size_t first_block = i / width;
+    const std::size_t last_block = (objs - 1) / width;
+
+    const Blocks::Block& bi = m_blocks.block(first_block);
+    const std::size_t li = i % width;
+
+    const __m256 x0 = _mm256_set1_ps(bi.x[li]);
+    const __m256 y0 = _mm256_set1_ps(bi.y[li]);
+    const __m256 r0 = _mm256_set1_ps(bi.radius[li]);
+
+    for(std::size_t b = first_block; b <= last_block; b++)
+    {
+        const Blocks::Block& bj = m_blocks.block(b);
+
+        const __m256 x_diff = _mm256_sub_ps(_mm256_load_ps(bj.x), x0);
+        const __m256 y_diff = _mm256_sub_ps(_mm256_load_ps(bj.y), y0);
+        const __m256 dist2 = _mm256_add_ps(_mm256_mul_ps(x_diff, x_diff), _mm256_mul_ps(y_diff, y_diff));
+        const __m256 dist = _mm256_sqrt_ps(dist2);
+        const __m256 r = _mm256_add_ps(_mm256_load_ps(bj.radius), r0);
+
+        __m256 hit = _mm256_cmp_ps(r, dist, _CMP_GT_OQ);
+
+        if (b == first_block || b == last_block)
+        {
+            const int first = b == first_block? li + 1: 0;
+            const int last = b == last_block? objs - b * width: width;
+
+            hit = _mm256_and_ps(hit, lanes_mask(first, last));
+        }
+
+        int hits = _mm256_movemask_ps(hit);
+
+        for(int l = 0; hits != 0; l++, hits >>= 1)
+            if (hits & 1)
+                colided.push_back( std::make_pair(i, b * width + l) );
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * AVX based accelerator working on objects packed into blocks.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AVXBLOCKSACCELERATOR_HPP
+#define AVXBLOCKSACCELERATOR_HPP
+
+#include <vector>
+
+#include "iaccelerator.hpp"
+
+#include "../objects_blocks.hpp"
+
+class Objects;
+
+// Accelerator using AoSoA layout (see ObjectsBlocks).
+// Objects are packed into blocks of 8 at the beginning of forces() and collisions()
+// so all pair loops can use aligned AVX loads without scalar prologue nor epilogue.
+class AVXBlocksAccelerator: public IAccelerator
+{
+    public:
+        typedef ObjectsBlocks<8> Blocks;
+
+        AVXBlocksAccelerator(Objects * = nullptr);
+        AVXBlocksAccelerator(const AVXBlocksAccelerator &) = delete;
+        ~AVXBlocksAccelerator();
+
+        AVXBlocksAccelerator& operator=(const AVXBlocksAccelerator &) = delete;
+
+        virtual void setObjects(Objects *) override;
+
+        virtual std::vector<force_vector_t> forces() override;
+        virtual std::vector<XY> velocities(const std::vector<force_vector_t>& forces, time_type dt) const override;
+        virtual std::vector<std::pair<int, int>> collisions() const override;
+
+    private:
+        struct alignas(32) ForceBlock
+        {
+            BaseType x[Blocks::width];
+            BaseType y[Blocks::width];
+        };
+
+        typedef std::vector<ForceBlock, Objects::AlignmentAllocator<ForceBlock, 64>> ForceBlocks;
+
+        Objects* m_objects;
+        mutable Blocks m_blocks;
+
+        void forcesFor(std::size_t, ForceBlocks &) const;
+        void collisionsFor(std::size_t, std::vector<std::pair<int, int>> &) const;
+};
+
+#endif // AVXBLOCKSACCELERATOR_HPP
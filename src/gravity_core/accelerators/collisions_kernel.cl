@@ -0,0 +1,61 @@
+
+
+// Finds all pairs (i, j), i < j, of overlapping objects.
+// Pairs are appended to 'pairs' in no particular order, 'found' counts all of them
+// (also those which did not fit into 'pairs_capacity' - caller should retry with bigger buffer then).
+kernel void collisions(global const float* objX,
+                       global const float* objY,
+                       global const float* radius,
+                       global int2* pairs,
+                       volatile global int* found,
+                       const int pairs_capacity,
+                       const int count
+                      )
+{
+    local float sx[LOCAL_MEM_SIZE];
+    local float sy[LOCAL_MEM_SIZE];
+    local float sr[LOCAL_MEM_SIZE];
+
+    const int i = get_global_id(0);
+    const int valid = i < count;
+
+    const float xi = valid? objX[i]: 0;
+    const float yi = valid? objY[i]: 0;
+    const float ri = valid? radius[i]: 0;
+
+    // only j > i are interesting: skip tiles which are before first object of group (same for all items of group).
+    // Kernel may be run with global offset (for part of objects), so group's first object is taken from global id.
+    const int group_first = get_global_id(0) - get_local_id(0);
+    const int first_tile = (group_first / LOCAL_MEM_SIZE) * LOCAL_MEM_SIZE;
+
+    for (int c = first_tile; c < count; c += LOCAL_MEM_SIZE)
+    {
+      const int n = min(count - c, LOCAL_MEM_SIZE);
+
+      for(int k = get_local_id(0); k < n; k += get_local_size(0))
+      {
+        sx[k] = objX[c + k];
+        sy[k] = objY[c + k];
+        sr[k] = radius[c + k];
+      }
+
+      barrier(CLK_LOCAL_MEM_FENCE);
+
+      for(int k = max(i + 1 - c, 0); valid && k < n; ++k)
+      {
+        const float dx = sx[k] - xi;
+        const float dy = sy[k] - yi;
+        const float dist = sqrt(dx * dx + dy * dy);
+
+        if (ri + sr[k] > dist)
+        {
+          const int slot = atomic_inc(found);
+
+          if (slot < pairs_capacity)
+            pairs[slot] = (int2)(i, c + k);
+        }
+      }
+
+      barrier(CLK_LOCAL_MEM_FENCE);
+    }
+}
@@ -23,6 +23,7 @@
 #include <omp.h>
 
 #include "../objects.hpp"
+#include "../tracing.hpp"
 
 
 CpuAcceleratorBase::CpuAcceleratorBase (Objects* objects): m_objects(objects)
@@ -58,17 +59,26 @@ std::vector<force_vector_t> CpuAcceleratorBase::forces()
     for(int t = 0; t < threads; t++)
         private_forces[t] = std::vector<force_vector_t>(objs);             // initialize vector of results for each vector
 
-    #pragma omp parallel for schedule(static, 1)
-    for(std::size_t i = 0; i < objs - 1; i++)
+    #pragma omp parallel
     {
-        const int tid = omp_get_thread_num();
-        forcesFor(i, private_forces[tid]);
+        TRACE_SCOPE("accelerator", "forces worker");
+
+        #pragma omp for schedule(static, 1) nowait
+        for(std::size_t i = 0; i < objs - 1; i++)
+        {
+            const int tid = omp_get_thread_num();
+            forcesFor(i, private_forces[tid]);
+        }
     }
 
     // accumulate results
-    for(int t = 0; t < threads; t++)
-        for(std::size_t i = 0; i < objs; i++)
-            forces[i] += private_forces[t][i];
+    {
+        TRACE_SCOPE("accelerator", "forces reduction");
+
+        for(int t = 0; t < threads; t++)
+            for(std::size_t i = 0; i < objs; i++)
+                forces[i] += private_forces[t][i];
+    }
 
     return forces;
 }
@@ -132,26 +142,31 @@ std::vector< std::pair< int, int > > CpuAcceleratorBase::collisions() const
     std::vector< std::vector< std::pair<int, int> > > toColide(threads);
 
     // calculate collisions in parallel
-    #pragma omp parallel for schedule(static, 1)
-    for(std::size_t i = 0; i < objs - 1; i++)
-        for(std::size_t j = i + 1; j < objs; j++)
-        {
-            const BaseType x1 = m_objects->getX()[i];
-            const BaseType y1 = m_objects->getY()[i];
-            const BaseType x2 = m_objects->getX()[j];
-            const BaseType y2 = m_objects->getY()[j];
-            const BaseType r1 = m_objects->getRadius()[i];
-            const BaseType r2 = m_objects->getRadius()[j];
-
-            const BaseType dist = utils::distance(x1, y1, x2, y2);
+    #pragma omp parallel
+    {
+        TRACE_SCOPE("accelerator", "collisions worker");
 
-            if ( (r1 + r2) > dist)
+        #pragma omp for schedule(static, 1) nowait
+        for(std::size_t i = 0; i < objs - 1; i++)
+            for(std::size_t j = i + 1; j < objs; j++)
             {
-                const int tid = omp_get_thread_num();
-                const auto colided = std::make_pair(i, j);
-                toColide[tid].push_back(colided);
+                const BaseType x1 = m_objects->getX()[i];
+                const BaseType y1 = m_objects->getY()[i];
+                const BaseType x2 = m_objects->getX()[j];
+                const BaseType y2 = m_objects->getY()[j];
+                const BaseType r1 = m_objects->getRadius()[i];
+                const BaseType r2 = m_objects->getRadius()[j];
+
+                const BaseType dist = utils::distance(x1, y1, x2, y2);
+
+                if ( (r1 + r2) > dist)
+                {
+                    const int tid = omp_get_thread_num();
+                    const auto colided = std::make_pair(i, j);
+                    toColide[tid].push_back(colided);
+                }
             }
-        }
+    }
 
     std::vector<std::pair<int, int>> result;
 
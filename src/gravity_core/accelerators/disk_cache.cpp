@@ -0,0 +1,82 @@
+/*
+ * Files in user's cache directory.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "disk_cache.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+
+std::string DiskCache::directory()
+{
+    const char* xdgCache = std::getenv("XDG_CACHE_HOME");
+    const char* home = std::getenv("HOME");
+
+    std::string cacheDir;
+
+    if (xdgCache != nullptr && xdgCache[0] != '\0')
+        cacheDir = xdgCache;
+    else if (home != nullptr && home[0] != '\0')
+        cacheDir = std::string(home) + "/.cache";
+    else
+        return std::string();                                   // no cache on disk
+
+    return cacheDir + "/gravity_simulator";
+}
+
+
+bool DiskCache::write(const std::string& path, const std::string& content)
+{
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+    const std::string temporary = path + "." + std::to_string(std::random_device()()) + ".tmp";
+
+    {
+        std::ofstream file(temporary, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+
+        if (file.fail())
+        {
+            std::cerr << "Could not open file " << temporary << " for writing" << std::endl;
+            return false;
+        }
+
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        file.close();
+
+        if (file.fail())
+        {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary, path, error);
+
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    return true;
+}
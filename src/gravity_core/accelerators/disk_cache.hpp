@@ -0,0 +1,38 @@
+/*
+ * Files in user's cache directory.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DISKCACHE_HPP
+#define DISKCACHE_HPP
+
+#include <string>
+
+
+// Location and writing of files cached between runs (OpenCL programs, tuning results)
+class DiskCache
+{
+    public:
+        // $XDG_CACHE_HOME/gravity_simulator or ~/.cache/gravity_simulator. Empty when there is no place for cache
+        static std::string directory();
+
+        // Writes to temporary file and renames it, so other processes never see partial file.
+        // Missing directories are created.
+        static bool write(const std::string& path, const std::string& content);
+};
+
+#endif // DISKCACHE_HPP
@@ -12,4 +12,9 @@ extern "C"
         return 0;
     }
 
+    void omp_set_num_threads(int)
+    {
+
+    }
+
 }
@@ -13,16 +13,42 @@ float2 unit_vector(float2 p1, float2 p2)
 }
 
 
+#ifndef UNROLL
+#define UNROLL 1
+#endif
+
+
+// force of gravity of object k acting on object i
+float2 attraction(float xi, float yi, float mi, float xk, float yk, float mk)
+{
+    const float G = 6.6732e-11;
+
+    const float dx = xk - xi;
+    const float dy = yk - yi;
+    float len2 = dx * dx + dy * dy;
+    const int notzero = (len2 != 0);
+    len2 += (len2 == 0);
+    const float Fg = (G * mi) * (mk / len2);
+    const float len = sqrt(len2);
+
+    return (float2)(dx * Fg / len * notzero, dy * Fg / len * notzero);
+}
+
+
+// Forces acting on objects (one per work item, global offset may be used to compute part of them)
+// coming from objects [column_begin, column_end). When 'accumulate' is set, they are added to
+// forces already stored in 'force' - so pipelined host code can compute forces in parts,
+// while other objects are still being uploaded.
 kernel void forces(global const float* objX,
                    global const float* objY,
                    global const float* mass,
                    global float2* force,
-                   const int count
+                   const int count,
+                   const int column_begin,
+                   const int column_end,
+                   const int accumulate
                   )
 {
-    const float G = 6.6732e-11;
-    const int count_local = ((count + LOCAL_MEM_SIZE - 1) / LOCAL_MEM_SIZE) * LOCAL_MEM_SIZE;
-
     local float sx[LOCAL_MEM_SIZE];
     local float sy[LOCAL_MEM_SIZE];
     local float sm[LOCAL_MEM_SIZE];
@@ -33,9 +59,9 @@ kernel void forces(global const float* objX,
 
     float fx = 0, fy = 0;
 
-    for (int c = 0; c < count_local; c += LOCAL_MEM_SIZE)
+    for (int c = column_begin; c < column_end; c += LOCAL_MEM_SIZE)
     {
-      const int n = min(count - c, LOCAL_MEM_SIZE);
+      const int n = min(column_end - c, LOCAL_MEM_SIZE);
 
       for(int k = get_local_id(0); k < n; k += get_local_size(0))
       {
@@ -46,20 +72,25 @@ kernel void forces(global const float* objX,
 
       barrier(CLK_LOCAL_MEM_FENCE);
 
-      for(int k = 0; k < n; ++k)
+      // main loop is unrolled UNROLL times (tuned per device, see OpenCLTuner)
+      int k = 0;
+
+      for(; k + UNROLL <= n; k += UNROLL)
+      {
+        #pragma unroll
+        for(int u = 0; u < UNROLL; u++)
+        {
+          const float2 f = attraction(xi, yi, mi, sx[k + u], sy[k + u], sm[k + u]);
+          fx += f.x;
+          fy += f.y;
+        }
+      }
+
+      for(; k < n; ++k)
       {
-        const float xk = sx[k];
-        const float yk = sy[k];
-        const float mk = sm[k];
-        const float dx = xk - xi;
-        const float dy = yk - yi;
-        float len2 = dx * dx + dy * dy;
-        const int notzero = (len2 != 0);
-        len2 += (len2 == 0);
-        const float Fg = (G * mi) * (mk / len2);
-        const float len = sqrt(len2);
-        fx += dx * Fg / len * notzero;
-        fy += dy * Fg / len * notzero;
+        const float2 f = attraction(xi, yi, mi, sx[k], sy[k], sm[k]);
+        fx += f.x;
+        fy += f.y;
       }
 
       barrier(CLK_LOCAL_MEM_FENCE);
@@ -67,6 +98,7 @@ kernel void forces(global const float* objX,
 
   if (get_global_id(0) < count)
   {
-    force[get_global_id(0)] = (float2)(fx, fy);
+    const float2 f = (float2)(fx, fy);
+    force[get_global_id(0)] = accumulate? force[get_global_id(0)] + f: f;
   }
 }
@@ -0,0 +1,141 @@
+/*
+ * Accelerator sharing work between OpenCL device and CPU.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "hybrid_accelerator.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "../objects.hpp"
+#include "../tracing.hpp"
+
+
+namespace
+{
+    // weight of last step's timings in split (the rest is history), smooths out noise
+    const double adaptation = 0.5;
+}
+
+
+HybridAccelerator::HybridAccelerator(Objects* objects):
+    m_objects(objects),
+    m_device(objects),
+    m_host(objects),
+    m_deviceShare(0.5)
+{
+
+}
+
+
+HybridAccelerator::~HybridAccelerator()
+{
+
+}
+
+
+void HybridAccelerator::setObjects(Objects* objects)
+{
+    m_objects = objects;
+    m_device.setObjects(objects);
+    m_host.setObjects(objects);
+}
+
+
+std::vector<force_vector_t> HybridAccelerator::forces()
+{
+    const std::size_t count = m_objects->size();
+
+    if (count == 0)
+        return {};
+
+    TRACE_SCOPE("hybrid", "forces");
+
+    // device gets objects [0, rows), host the rest. Boundary is aligned down to work groups,
+    // and host keeps at least one group when there is more than one (otherwise share could not adapt back)
+    const std::size_t group = OpenCLTuner::MaxGroupSize;
+    const std::size_t rowsLimit = count > group? count - group: 0;
+    const std::size_t rows = std::min(rowsLimit, static_cast<std::size_t>(m_deviceShare * count / group) * group);
+
+    std::vector<force_vector_t> result(count);
+
+    if (rows > 0)
+        m_device.enqueueForces(rows);
+
+    // host works while device does its part
+    const auto hostStart = std::chrono::steady_clock::now();
+
+    if (rows < count)
+    {
+        TRACE_SCOPE("hybrid", "host part");
+        m_host.forcesOn(rows, count, result.data() + rows);
+    }
+
+    const std::chrono::duration<double> hostTime = std::chrono::steady_clock::now() - hostStart;
+
+    if (rows > 0)
+    {
+        const std::vector<force_vector_t> deviceForces = m_device.finishForces();
+        std::copy(deviceForces.begin(), deviceForces.end(), result.begin());
+    }
+
+    // new split: so both sides would finish at the same time with speeds (objects per second) measured now
+    const double deviceTime = m_device.lastForcesTime();
+
+    if (rows > 0 && deviceTime > 0.0 && hostTime.count() > 0.0)
+    {
+        const double deviceSpeed = rows / deviceTime;
+        const double hostSpeed = (count - rows) / hostTime.count();
+        const double target = deviceSpeed / (deviceSpeed + hostSpeed);
+
+        m_deviceShare = (1.0 - adaptation) * m_deviceShare + adaptation * target;
+    }
+    else if (rows == 0 && count > group)
+    {
+        // device got less than one group: its speed is unknown, so move share towards it until it gets some work
+        m_deviceShare = (1.0 - adaptation) * m_deviceShare + adaptation;
+    }
+
+    m_deviceShare = std::clamp(m_deviceShare, MinShare, 1.0 - MinShare);
+
+    return result;
+}
+
+
+std::vector<XY> HybridAccelerator::velocities(const std::vector<force_vector_t>& forces, time_type dt) const
+{
+    return m_host.velocities(forces, dt);
+}
+
+
+std::vector<std::pair<int, int>> HybridAccelerator::collisions() const
+{
+    return m_device.collisions();
+}
+
+
+void HybridAccelerator::setInstrumentation(Instrumentation* instrumentation)
+{
+    m_device.setInstrumentation(instrumentation);
+}
+
+
+double HybridAccelerator::deviceShare() const
+{
+    return m_deviceShare;
+}
@@ -0,0 +1,60 @@
+/*
+ * Accelerator sharing work between OpenCL device and CPU.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef HYBRIDACCELERATOR_HPP
+#define HYBRIDACCELERATOR_HPP
+
+#include "avx_accelerator.hpp"
+#include "iaccelerator.hpp"
+#include "opencl_accelerator.hpp"
+
+class Objects;
+
+// Computes forces acting on first part of objects with OpenCLAccelerator and, at the same time,
+// forces acting on the rest with AVXAccelerator on host cores.
+// Split adapts after each step to timings of both parts, so both finish at the same time.
+class HybridAccelerator: public IAccelerator
+{
+    public:
+        static constexpr double MinShare = 0.02;                // each side keeps at least this part of objects, so its speed can still be measured
+
+        HybridAccelerator(Objects * = nullptr);
+        HybridAccelerator(const HybridAccelerator &) = delete;
+        ~HybridAccelerator();
+
+        HybridAccelerator& operator=(const HybridAccelerator &) = delete;
+
+        virtual void setObjects(Objects *) override;
+
+        virtual std::vector<force_vector_t> forces() override;
+        virtual std::vector<XY> velocities(const std::vector<force_vector_t>& forces, time_type dt) const override;
+        virtual std::vector<std::pair<int, int>> collisions() const override;
+
+        virtual void setInstrumentation(Instrumentation *) override;
+
+        double deviceShare() const;                             // part of objects given to OpenCL device
+
+    private:
+        Objects* m_objects;
+        OpenCLAccelerator m_device;
+        AVXAccelerator m_host;
+        double m_deviceShare;
+};
+
+#endif // HYBRIDACCELERATOR_HPP
@@ -2,10 +2,12 @@
 #ifndef IACCELERATOR_HPP
 #define IACCELERATOR_HPP
 
+#include <functional>
 #include <vector>
 
 #include "../object.hpp"
 
+class Instrumentation;
 class Objects;
 
 struct IAccelerator
@@ -17,6 +19,20 @@ struct IAccelerator
     virtual std::vector<force_vector_t> forces() = 0;
     virtual std::vector<XY> velocities(const std::vector<force_vector_t>& forces, time_type dt) const = 0;
     virtual std::vector< std::pair<int, int> > collisions() const = 0;
+
+    // Device resident stepping (optional).
+    // Accelerator keeps positions, velocities and masses in its own memory and does whole step there:
+    // forces, velocities and positions (repeated until 'accept' agrees with dt and maximal travel of objects),
+    // and check for collisions. Objects are not updated until synchronize().
+    // Returns false when not supported - engine does regular step then.
+    typedef std::function<bool(double& dt, BaseType maxTravel)> DtController;    // returns true when dt is accepted, may modify it otherwise
+
+    virtual bool residentStep(double& /* dt */, const DtController& /* accept */, bool& /* collisions */) { return false; }
+    virtual void synchronize() {}                   // copy resident state to Objects
+    virtual void invalidate() {}                    // Objects were modified, resident state needs to be reloaded
+
+    // Accelerator may record its own metrics (i.e. Instrumentation::TransferOverlap). Set by engine.
+    virtual void setInstrumentation(Instrumentation *) {}
 };
 
 
@@ -0,0 +1,59 @@
+
+
+// Velocities and positions after dt (for forces calculated by 'forces' kernel).
+// Results go to separate buffers, as dt may be rejected. Maximal distance made by object
+// in each work group goes to 'travel' (one entry per group), so host can adjust dt.
+kernel void kick_drift(global const float* objX,
+                       global const float* objY,
+                       global const float* velX,
+                       global const float* velY,
+                       global const float* mass,
+                       global const float2* force,
+                       global float* nextX,
+                       global float* nextY,
+                       global float* nextVelX,
+                       global float* nextVelY,
+                       global float* travel,
+                       const float dt,
+                       const int count
+                      )
+{
+    local float group_travel[GROUP_SIZE];
+
+    const int i = get_global_id(0);
+    const int l = get_local_id(0);
+
+    float distance = 0;
+
+    if (i < count)
+    {
+      // F = am => a = F/m, dV = a dt
+      const float2 a = force[i] / mass[i];
+      const float vx = velX[i] + a.x * dt;
+      const float vy = velY[i] + a.y * dt;
+
+      const float dx = vx * dt;
+      const float dy = vy * dt;
+
+      nextX[i] = objX[i] + dx;
+      nextY[i] = objY[i] + dy;
+      nextVelX[i] = vx;
+      nextVelY[i] = vy;
+
+      distance = sqrt(dx * dx + dy * dy);
+    }
+
+    group_travel[l] = distance;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for(int s = get_local_size(0) / 2; s > 0; s /= 2)
+    {
+      if (l < s)
+        group_travel[l] = max(group_travel[l], group_travel[l + s]);
+
+      barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (l == 0)
+      travel[get_group_id(0)] = group_travel[0];
+}
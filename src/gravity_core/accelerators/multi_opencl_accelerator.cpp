@@ -0,0 +1,445 @@
+/*
+ * Accelerator splitting work across many OpenCL devices.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "multi_opencl_accelerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+#include "../objects.hpp"
+#include "../tracing.hpp"
+#include "forces_kernel.hpp"
+#include "collisions_kernel.hpp"
+
+
+namespace
+{
+    // rows of devices begin at multiples of biggest work group, so no work group crosses devices
+    std::size_t padded(std::size_t objects, std::size_t alignment)
+    {
+        return (objects + alignment - 1) / alignment * alignment;
+    }
+
+    double kernelTime(const boost::compute::event& event)
+    {
+        const cl_ulong start = event.get_profiling_info<cl_ulong>(CL_PROFILING_COMMAND_START);
+        const cl_ulong end = event.get_profiling_info<cl_ulong>(CL_PROFILING_COMMAND_END);
+
+        return (end - start) * 1e-9;
+    }
+}
+
+
+MultiOpenCLAccelerator::Device::Device(const boost::compute::device& dev):
+    device(dev),
+    context(dev),
+    queue(context, dev, boost::compute::command_queue::enable_profiling),
+    programCache(std::make_unique<OpenCLProgramCache>(context, dev)),
+    tuner(std::make_unique<OpenCLTuner>(context, dev, *programCache)),
+    config(OpenCLTuner::defaultConfig),
+    forcesKernel(),
+    collisionsKernel(),
+    capacity(0),
+    objX(),
+    objY(),
+    mass(),
+    radius(),
+    force(),
+    pairsCapacity(0),
+    pairs(),
+    pairsFound(context, sizeof(cl_int)),
+    share(0.0),
+    begin(0),
+    end(0),
+    rows(0),
+    busy(0.0)
+{
+
+}
+
+
+MultiOpenCLAccelerator::MultiOpenCLAccelerator(Objects* objects, const std::vector<boost::compute::device>& devices):
+    m_objects(objects),
+    m_devices(),
+    m_steps(0)
+{
+    if (devices.empty())
+        throw std::runtime_error("No OpenCL devices found");
+
+    // initial split: by theoretical power of devices, will be corrected by measurements
+    double power = 0.0;
+
+    for(const boost::compute::device& device: devices)
+    {
+        m_devices.push_back(std::make_unique<Device>(device));
+        m_devices.back()->share = static_cast<double>(device.compute_units()) * std::max(device.clock_frequency(), 1u);
+        power += m_devices.back()->share;
+
+        reservePairs(*m_devices.back(), 256);
+
+        std::cerr << "OpenCL device: " << device.name() << std::endl;
+    }
+
+    for(auto& device: m_devices)
+        device->share /= power;
+}
+
+
+MultiOpenCLAccelerator::~MultiOpenCLAccelerator()
+{
+
+}
+
+
+void MultiOpenCLAccelerator::setObjects(Objects* objects)
+{
+    m_objects = objects;
+}
+
+
+std::vector<force_vector_t> MultiOpenCLAccelerator::forces()
+{
+    const std::size_t count = m_objects->size();
+
+    if (count == 0)
+        return {};
+
+    prepare(count);
+
+    TRACE_SCOPE("opencl", "multi forces");
+
+    std::vector<force_vector_t> result(count);
+    std::vector<boost::compute::event> kernels(m_devices.size());
+
+    const std::size_t columnSize = count * sizeof(float);
+
+    // all devices work at the same time, each one on its own queue
+    for(std::size_t i = 0; i < m_devices.size(); i++)
+    {
+        Device& d = *m_devices[i];
+
+        if (d.begin == d.end)
+            continue;
+
+        d.queue.enqueue_write_buffer_async(d.objX, 0, columnSize, m_objects->getX().data());
+        d.queue.enqueue_write_buffer_async(d.objY, 0, columnSize, m_objects->getY().data());
+        d.queue.enqueue_write_buffer_async(d.mass, 0, columnSize, m_objects->getMass().data());
+
+        // forces acting on rows [begin, end) from all objects
+        d.forcesKernel.set_arg(0, d.objX);
+        d.forcesKernel.set_arg(1, d.objY);
+        d.forcesKernel.set_arg(2, d.mass);
+        d.forcesKernel.set_arg(3, d.force);
+        d.forcesKernel.set_arg(4, static_cast<cl_int>(count));
+        d.forcesKernel.set_arg(5, 0);
+        d.forcesKernel.set_arg(6, static_cast<cl_int>(count));
+        d.forcesKernel.set_arg(7, 0);
+
+        kernels[i] = d.queue.enqueue_nd_range_kernel(d.forcesKernel,
+                                                     boost::compute::extents<1>(d.begin),
+                                                     boost::compute::extents<1>(padded(d.end - d.begin, d.config.groupSize)),
+                                                     boost::compute::extents<1>(d.config.groupSize));
+
+        d.queue.enqueue_read_buffer_async(d.force,
+                                          d.begin * sizeof(force_vector_t),
+                                          (d.end - d.begin) * sizeof(force_vector_t),
+                                          result.data() + d.begin);
+    }
+
+    {
+        TRACE_SCOPE("opencl", "wait");
+
+        for(std::size_t i = 0; i < m_devices.size(); i++)
+        {
+            Device& d = *m_devices[i];
+
+            if (d.begin == d.end)
+                continue;
+
+            d.queue.finish();
+
+            d.busy += kernelTime(kernels[i]);
+            d.rows += d.end - d.begin;
+        }
+    }
+
+    if (++m_steps % RebalanceInterval == 0)
+        rebalance();
+
+    return result;
+}
+
+
+std::vector<XY> MultiOpenCLAccelerator::velocities(const std::vector<force_vector_t>& forces, time_type dt) const
+{
+    std::vector<XY> result;
+    result.reserve(m_objects->size());
+
+    for(std::size_t i = 0; i < m_objects->size(); i++)
+    {
+        const force_vector_t& dF = forces[i];
+        const Object& o = (*m_objects)[i];
+
+        // F=am ⇒ a = F/m
+        const acceleration_vector_t a = dF / o.mass();
+
+        // ΔV = aΔt
+        const velocity_vector_t dv = a * dt;
+
+        result.push_back(dv);
+    }
+
+    return result;
+}
+
+
+std::vector<std::pair<int, int>> MultiOpenCLAccelerator::collisions() const
+{
+    const std::size_t count = m_objects->size();
+
+    if (count < 2)
+        return {};
+
+    prepare(count);
+
+    TRACE_SCOPE("opencl", "multi collisions");
+
+    static const cl_int zero = 0;
+    std::vector<cl_int> found(m_devices.size(), 0);
+
+    const std::size_t columnSize = count * sizeof(float);
+
+    auto findCollisions = [count, &found](Device& d, std::size_t i)
+    {
+        d.collisionsKernel.set_arg(3, d.pairs);
+        d.collisionsKernel.set_arg(4, d.pairsFound);
+        d.collisionsKernel.set_arg(5, static_cast<cl_int>(d.pairsCapacity));
+        d.collisionsKernel.set_arg(6, static_cast<cl_int>(count));
+
+        d.queue.enqueue_write_buffer_async(d.pairsFound, 0, sizeof(cl_int), &zero);
+        d.queue.enqueue_nd_range_kernel(d.collisionsKernel,
+                                        boost::compute::extents<1>(d.begin),
+                                        boost::compute::extents<1>(padded(d.end - d.begin, d.config.groupSize)),
+                                        boost::compute::extents<1>(d.config.groupSize));
+        d.queue.enqueue_read_buffer_async(d.pairsFound, 0, sizeof(cl_int), &found[i]);
+    };
+
+    // pairs (i, j) with i in rows of device
+    for(std::size_t i = 0; i < m_devices.size(); i++)
+    {
+        Device& d = *m_devices[i];
+
+        if (d.begin == d.end)
+            continue;
+
+        d.queue.enqueue_write_buffer_async(d.objX, 0, columnSize, m_objects->getX().data());
+        d.queue.enqueue_write_buffer_async(d.objY, 0, columnSize, m_objects->getY().data());
+        d.queue.enqueue_write_buffer_async(d.radius, 0, columnSize, m_objects->getRadius().data());
+
+        d.collisionsKernel.set_arg(0, d.objX);
+        d.collisionsKernel.set_arg(1, d.objY);
+        d.collisionsKernel.set_arg(2, d.radius);
+
+        findCollisions(d, i);
+    }
+
+    std::vector<std::pair<int, int>> result;
+
+    for(std::size_t i = 0; i < m_devices.size(); i++)
+    {
+        Device& d = *m_devices[i];
+
+        if (d.begin == d.end)
+            continue;
+
+        d.queue.finish();
+
+        // kernel counts all pairs, even those which did not fit into buffer - then run it once again with bigger one
+        const std::size_t pairsFound = static_cast<std::size_t>(found[i]);
+
+        if (pairsFound > d.pairsCapacity)
+        {
+            reservePairs(d, pairsFound);
+            findCollisions(d, i);
+            d.queue.finish();
+        }
+
+        std::vector<cl_int2> pairs(found[i]);
+
+        if (pairs.empty() == false)
+            d.queue.enqueue_read_buffer(d.pairs, 0, pairs.size() * sizeof(cl_int2), pairs.data());
+
+        for(const cl_int2& pair: pairs)
+            result.emplace_back(pair.s[0], pair.s[1]);
+    }
+
+    // order of pairs found by devices is random, sort them so results are reproducible
+    std::sort(result.begin(), result.end());
+
+    return result;
+}
+
+
+std::vector<double> MultiOpenCLAccelerator::shares() const
+{
+    std::vector<double> result;
+
+    for(const auto& device: m_devices)
+        result.push_back(device->share);
+
+    return result;
+}
+
+
+std::vector<boost::compute::device> MultiOpenCLAccelerator::allDevices()
+{
+    return boost::compute::system::devices();
+}
+
+
+std::vector<boost::compute::device> MultiOpenCLAccelerator::cpuSubDevices(std::size_t count)
+{
+    for(const boost::compute::device& device: boost::compute::system::devices())
+    {
+        if ((device.type() & boost::compute::device::cpu) == 0 || count == 0 || device.compute_units() < count)
+            continue;
+
+        try
+        {
+            std::vector<boost::compute::device> result = device.partition_equally(device.compute_units() / count);
+
+            if (result.size() >= count)
+            {
+                result.resize(count);
+                return result;
+            }
+        }
+        catch(const boost::compute::opencl_error &)
+        {
+            // device fission not supported
+        }
+    }
+
+    return {};
+}
+
+
+void MultiOpenCLAccelerator::prepare(std::size_t count) const
+{
+    double cumulated = 0.0;
+    std::size_t begin = 0;
+
+    for(std::size_t i = 0; i < m_devices.size(); i++)
+    {
+        Device& d = *m_devices[i];
+
+        configure(d, count);
+        reserve(d, count);
+
+        cumulated += d.share;
+
+        const std::size_t boundary = static_cast<std::size_t>(std::llround(cumulated * count / OpenCLTuner::MaxGroupSize)) * OpenCLTuner::MaxGroupSize;
+        const std::size_t end = i + 1 == m_devices.size()? count: std::min(std::max(boundary, begin), count);
+
+        d.begin = begin;
+        d.end = end;
+        begin = end;
+    }
+}
+
+
+void MultiOpenCLAccelerator::configure(Device& d, std::size_t count) const
+{
+    const OpenCLTuner::Config config = d.tuner->config(count);
+
+    if (d.forcesKernel.get() != nullptr && config == d.config)
+        return;
+
+    TRACE_SCOPE("opencl", "configure");
+
+    const std::vector<std::string> sources = { forces_kernel_cl, collisions_kernel_cl };
+    const boost::compute::program program = d.programCache->build(sources, config.buildOptions());
+
+    d.forcesKernel = boost::compute::kernel(program, "forces");
+    d.collisionsKernel = boost::compute::kernel(program, "collisions");
+    d.config = config;
+}
+
+
+void MultiOpenCLAccelerator::reserve(Device& d, std::size_t count) const
+{
+    if (count <= d.capacity)
+        return;
+
+    // grow geometrically, pad to biggest work group (kernels may run past number of objects)
+    const std::size_t capacity = padded(std::max(count, d.capacity * 2), OpenCLTuner::MaxGroupSize);
+    const std::size_t columnSize = capacity * sizeof(float);
+
+    d.objX = boost::compute::buffer(d.context, columnSize, boost::compute::buffer::read_only);
+    d.objY = boost::compute::buffer(d.context, columnSize, boost::compute::buffer::read_only);
+    d.mass = boost::compute::buffer(d.context, columnSize, boost::compute::buffer::read_only);
+    d.radius = boost::compute::buffer(d.context, columnSize, boost::compute::buffer::read_only);
+    d.force = boost::compute::buffer(d.context, capacity * sizeof(force_vector_t), boost::compute::buffer::write_only);
+
+    d.capacity = capacity;
+}
+
+
+void MultiOpenCLAccelerator::reservePairs(Device& d, std::size_t pairs) const
+{
+    if (pairs <= d.pairsCapacity)
+        return;
+
+    d.pairsCapacity = std::max(pairs, d.pairsCapacity * 2);
+    d.pairs = boost::compute::buffer(d.context, d.pairsCapacity * sizeof(cl_int2), boost::compute::buffer::write_only);
+}
+
+
+void MultiOpenCLAccelerator::rebalance()
+{
+    // Devices which computed something since last rebalance share their part proportionally to
+    // measured throughput (rows per second). Others (too small part to get any rows) keep theirs.
+    double measuredShare = 0.0;
+    double throughput = 0.0;
+
+    for(const auto& d: m_devices)
+        if (d->rows > 0 && d->busy > 0.0)
+        {
+            measuredShare += d->share;
+            throughput += d->rows / d->busy;
+        }
+
+    if (throughput > 0.0)
+        for(auto& d: m_devices)
+            if (d->rows > 0 && d->busy > 0.0)
+            {
+                const double target = measuredShare * (d->rows / d->busy) / throughput;
+
+                // move halfway only, so measurement noise does not make split oscillate
+                d->share = (d->share + target) / 2.0;
+            }
+
+    for(auto& d: m_devices)
+    {
+        d->rows = 0;
+        d->busy = 0.0;
+    }
+}
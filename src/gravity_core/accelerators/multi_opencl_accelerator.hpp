@@ -0,0 +1,105 @@
+/*
+ * Accelerator splitting work across many OpenCL devices.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MULTIOPENCLACCELERATOR_HPP
+#define MULTIOPENCLACCELERATOR_HPP
+
+#include <memory>
+#include <vector>
+
+#include <boost/compute/core.hpp>
+
+#include "iaccelerator.hpp"
+#include "opencl_program_cache.hpp"
+#include "opencl_tuner.hpp"
+
+class Objects;
+
+// Runs forces and collisions kernels on all given OpenCL devices (all devices of all platforms by default).
+// Each device gets all objects, but computes results only for its part of them (range of rows).
+// Parts are proportional to throughput of devices, measured with kernels' profiling and rebalanced
+// every few steps.
+class MultiOpenCLAccelerator: public IAccelerator
+{
+    public:
+        MultiOpenCLAccelerator(Objects * = nullptr, const std::vector<boost::compute::device>& = allDevices());
+        MultiOpenCLAccelerator(const MultiOpenCLAccelerator &) = delete;
+        ~MultiOpenCLAccelerator();
+
+        MultiOpenCLAccelerator& operator=(const MultiOpenCLAccelerator &) = delete;
+
+        virtual void setObjects(Objects *) override;
+
+        virtual std::vector<force_vector_t> forces() override;
+        virtual std::vector<XY> velocities(const std::vector<force_vector_t>& forces, time_type dt) const override;
+        virtual std::vector<std::pair<int, int>> collisions() const override;
+
+        std::vector<double> shares() const;                     // current part of objects per device, sums to 1
+
+        static std::vector<boost::compute::device> allDevices();
+        static std::vector<boost::compute::device> cpuSubDevices(std::size_t count);  // CPU device split with device fission (empty if not supported)
+
+        static const int RebalanceInterval = 8;                 // in steps
+
+    private:
+        struct Device
+        {
+            Device(const boost::compute::device &);
+
+            boost::compute::device device;
+            boost::compute::context context;
+            boost::compute::command_queue queue;
+            std::unique_ptr<OpenCLProgramCache> programCache;       // used by tuner, so constructed before it
+            std::unique_ptr<OpenCLTuner> tuner;
+
+            OpenCLTuner::Config config;
+            boost::compute::kernel forcesKernel;
+            boost::compute::kernel collisionsKernel;
+
+            std::size_t capacity;                               // in objects
+            boost::compute::buffer objX;
+            boost::compute::buffer objY;
+            boost::compute::buffer mass;
+            boost::compute::buffer radius;
+            boost::compute::buffer force;
+
+            std::size_t pairsCapacity;
+            boost::compute::buffer pairs;
+            boost::compute::buffer pairsFound;
+
+            double share;                                       // of objects
+            std::size_t begin, end;                             // rows computed by device in current step
+
+            // measured since last rebalance
+            std::size_t rows;
+            double busy;                                        // [s] of kernels' time
+        };
+
+        Objects* m_objects;
+        mutable std::vector<std::unique_ptr<Device>> m_devices;
+        int m_steps;
+
+        void prepare(std::size_t count) const;                  // configure kernels, reserve buffers, split rows
+        void configure(Device &, std::size_t count) const;
+        void reserve(Device &, std::size_t count) const;
+        void reservePairs(Device &, std::size_t pairs) const;
+        void rebalance();
+};
+
+#endif // MULTIOPENCLACCELERATOR_HPP
@@ -17,11 +17,10 @@
  *
  */
 
-#define BOOST_COMPUTE_DEBUG_KERNEL_COMPILATION
-
 #include "opencl_accelerator.hpp"
 
-#include "omp.h"
+#include <algorithm>
+#include <cassert>
 
 #include <boost/compute/core.hpp>
 #include <boost/compute/algorithm/copy.hpp>
@@ -32,89 +31,274 @@
 #include <boost/compute/functional/math.hpp>
 #include <boost/compute/functional/operator.hpp>
 
+#include "../instrumentation.hpp"
 #include "../objects.hpp"
+#include "../tracing.hpp"
 #include "forces_kernel.hpp"
+#include "collisions_kernel.hpp"
+#include "integration_kernel.hpp"
 
 
-#define SHARED_MEM_SIZE_PER_GROUP (2 * 1024)
-#define GROUP_SIZE 128
-
 // tutorials:
 // https://anteru.net/blog/2012/11/03/2009/
 
 
+namespace
+{
+    // total time covered by (possibly overlapping) events, in ns
+    cl_ulong busyTime(const std::vector<boost::compute::event>& events)
+    {
+        std::vector<std::pair<cl_ulong, cl_ulong>> intervals;
+        intervals.reserve(events.size());
+
+        for(const boost::compute::event& event: events)
+            intervals.emplace_back(event.get_profiling_info<cl_ulong>(CL_PROFILING_COMMAND_START),
+                                   event.get_profiling_info<cl_ulong>(CL_PROFILING_COMMAND_END));
+
+        std::sort(intervals.begin(), intervals.end());
+
+        cl_ulong result = 0;
+        cl_ulong covered = 0;                       // end of already counted time
+
+        for(const auto& interval: intervals)
+        {
+            const cl_ulong begin = std::max(interval.first, covered);
+
+            if (interval.second > begin)
+            {
+                result += interval.second - begin;
+                covered = interval.second;
+            }
+        }
+
+        return result;
+    }
+}
+
+
 OpenCLAccelerator::OpenCLAccelerator(Objects* objects):
     m_objects(objects),
-    m_program(),
     m_context(),
-    m_device()
+    m_device(),
+    m_instrumentation(nullptr),
+    m_programCache(),
+    m_tuner(),
+    m_config(OpenCLTuner::defaultConfig),
+    m_programs(),
+    m_program(),
+    m_queue(),
+    m_transferQueue(),
+    m_forcesKernel(),
+    m_collisionsKernel(),
+    m_kickDriftKernel(),
+    m_capacity(0),
+    m_objX(),
+    m_objY(),
+    m_mass(),
+    m_radius(),
+    m_force(),
+    m_pinnedInput(),
+    m_pinnedOutput(),
+    m_hostInput(nullptr),
+    m_hostOutput(nullptr),
+    m_transfers(),
+    m_kernels(),
+    m_pendingRows(0),
+    m_lastForcesTime(0.0),
+    m_pairsCapacity(0),
+    m_pairs(),
+    m_pairsFound(),
+    m_residentValid(false),
+    m_velX(),
+    m_velY(),
+    m_nextX(),
+    m_nextY(),
+    m_nextVelX(),
+    m_nextVelY(),
+    m_travel()
 {
     m_device = boost::compute::system::default_device();
     m_context = boost::compute::context(m_device);
-    m_program = boost::compute::program::create_with_source(forces_kernel_cl, m_context);
+    m_programCache = std::make_unique<OpenCLProgramCache>(m_context, m_device);
+    m_tuner = std::make_unique<OpenCLTuner>(m_context, m_device, *m_programCache);
+    m_queue = boost::compute::command_queue(m_context, m_device, boost::compute::command_queue::enable_profiling);
+    m_transferQueue = boost::compute::command_queue(m_context, m_device, boost::compute::command_queue::enable_profiling);
 
-    const std::string program_args = "-DLOCAL_MEM_SIZE=" + std::to_string(SHARED_MEM_SIZE_PER_GROUP / sizeof(float) / 4);
+    // program is built for kernels' configuration chosen for number of objects, see configure()
 
-    m_program.build(program_args);
+    m_pairsFound = boost::compute::buffer(m_context, sizeof(cl_int));
+    reservePairs(256);
 
-    std::cout << "OpenCL device: " << m_device.name() << std::endl;
+    std::cerr << "OpenCL device: " << m_device.name() << std::endl;
 }
 
 
 OpenCLAccelerator::~OpenCLAccelerator()
 {
-
+    unmapPinned();
 }
 
 
 void OpenCLAccelerator::setObjects(Objects* objects)
 {
     m_objects = objects;
+    m_residentValid = false;
 }
 
 
 std::vector<force_vector_t> OpenCLAccelerator::forces()
 {
-    const int count = m_objects->size();
-    std::vector<force_vector_t> host_force(count);
+    const std::size_t count = m_objects->size();
+
+    if (count == 0)
+        return {};
+
+    TRACE_SCOPE("opencl", "forces");
+
+    enqueueForces(count);
+
+    return finishForces();
+}
+
+
+void OpenCLAccelerator::enqueueForces(std::size_t rows)
+{
+    const std::size_t count = m_objects->size();
+
+    assert(rows <= count);
+
+    configure(count);
+    reserve(count);
+
+    TRACE_SCOPE("opencl", "enqueue");
+
+    // Pipeline: objects are split into chunks, transfers go through m_transferQueue, kernels through m_queue.
+    //  1. chunk k is uploaded while forces between objects of previous chunks are computed:
+    //     when upload finishes, forces acting on chunk k from objects [0, end of k) are computed.
+    //  2. when all chunks are on device, forces acting on chunk k from the rest of objects are added
+    //     and chunk k is downloaded while the next one is being computed.
+    // All objects are uploaded, but only forces acting on [0, rows) are computed.
+    const std::size_t chunkSize = globalSize(std::max(count / PipelineChunks, MinChunkSize));
+
+    m_transfers.clear();
+    m_kernels.clear();
+    m_pendingRows = rows;
+
+    // nothing queued before may use buffers being overwritten
+    m_queue.finish();
+    m_residentValid = false;                            // velocities on device are not up to date anymore
+
+    m_forcesKernel.set_arg(4, static_cast<cl_int>(count));
+
+    std::vector<boost::compute::event> computed;        // by first phase, per chunk
+    boost::compute::wait_list pending;                  // uploads of chunks not used by first phase
+
+    for(std::size_t begin = 0; begin < count; begin += chunkSize)
+    {
+        const std::size_t end = std::min(begin + chunkSize, count);
+        const std::size_t rowsEnd = std::min(end, rows);
+
+        boost::compute::wait_list uploaded;
+
+        for(const StagingColumn column: {X, Y, Mass})
+        {
+            const Objects::DataVector& source = column == X? m_objects->getX(): column == Y? m_objects->getY(): m_objects->getMass();
+            const boost::compute::buffer& destination = column == X? m_objX: column == Y? m_objY: m_mass;
+
+            std::copy(source.begin() + begin, source.begin() + end, staging(column) + begin);
+
+            m_transfers.push_back(m_transferQueue.enqueue_write_buffer_async(destination, begin * sizeof(float), (end - begin) * sizeof(float), staging(column) + begin));
+            uploaded.insert(m_transfers.back());
+        }
+
+        if (begin < rowsEnd)
+        {
+            // buffers are padded to whole groups (see reserve()), so kernel may run past end
+            m_forcesKernel.set_arg(5, 0);
+            m_forcesKernel.set_arg(6, static_cast<cl_int>(end));
+            m_forcesKernel.set_arg(7, 0);
+
+            m_kernels.push_back(m_queue.enqueue_nd_range_kernel(m_forcesKernel,
+                                                                boost::compute::extents<1>(begin),
+                                                                boost::compute::extents<1>(globalSize(rowsEnd - begin)),
+                                                                boost::compute::extents<1>(m_config.groupSize),
+                                                                uploaded));
+            computed.push_back(m_kernels.back());
+        }
+        else
+        {
+            for(const boost::compute::event& upload: uploaded)
+                pending.insert(upload);
+        }
+    }
+
+    // uploads of chunks with first phase kernel are already waited for by m_queue (it is in-order)
+    for(std::size_t begin = 0, chunk = 0; begin < rows; begin += chunkSize, chunk++)
+    {
+        const std::size_t end = std::min(begin + chunkSize, count);
+        const std::size_t rowsEnd = std::min(end, rows);
+        boost::compute::event done = computed[chunk];
+
+        if (end < count)
+        {
+            m_forcesKernel.set_arg(5, static_cast<cl_int>(end));
+            m_forcesKernel.set_arg(6, static_cast<cl_int>(count));
+            m_forcesKernel.set_arg(7, 1);
+
+            done = m_queue.enqueue_nd_range_kernel(m_forcesKernel,
+                                                   boost::compute::extents<1>(begin),
+                                                   boost::compute::extents<1>(globalSize(rowsEnd - begin)),
+                                                   boost::compute::extents<1>(m_config.groupSize),
+                                                   pending);
+            m_kernels.push_back(done);
+        }
 
-    boost::compute::command_queue queue(m_context, m_device);
+        m_transfers.push_back(m_transferQueue.enqueue_read_buffer_async(m_force,
+                                                                        begin * sizeof(force_vector_t),
+                                                                        (rowsEnd - begin) * sizeof(force_vector_t),
+                                                                        m_hostOutput + begin,
+                                                                        boost::compute::wait_list(done)));
+    }
 
-    boost::compute::buffer objX(m_context, count * sizeof(float), boost::compute::buffer::read_only);
-    boost::compute::buffer objY(m_context, count * sizeof(float), boost::compute::buffer::read_only);
-    boost::compute::buffer mass(m_context, count * sizeof(float), boost::compute::buffer::read_only);
-    boost::compute::buffer force(m_context, count * sizeof(force_vector_t), boost::compute::buffer::write_only);
+    // make sure device starts working now, caller may be busy for a while
+    m_queue.flush();
+    m_transferQueue.flush();
+}
 
-    auto objXFuture = queue.enqueue_write_buffer_async(objX, 0, count * sizeof(float), m_objects->getX().data());
-    auto objYFuture = queue.enqueue_write_buffer_async(objY, 0, count * sizeof(float), m_objects->getY().data());
-    auto massFuture = queue.enqueue_write_buffer_async(mass, 0, count * sizeof(float), m_objects->getMass().data());
 
-    boost::compute::kernel kernel(m_program, "forces");
+std::vector<force_vector_t> OpenCLAccelerator::finishForces()
+{
+    {
+        TRACE_SCOPE("opencl", "wait");
+        m_transferQueue.finish();
+    }
 
-    kernel.set_arg(0, objX);
-    kernel.set_arg(1, objY);
-    kernel.set_arg(2, mass);
-    kernel.set_arg(3, force);
-    kernel.set_arg(4, count);
+    const cl_ulong transferTime = busyTime(m_transfers);
+    const cl_ulong kernelTime = busyTime(m_kernels);
 
-    objXFuture.wait();
-    objYFuture.wait();
-    massFuture.wait();
+    std::vector<boost::compute::event> all(m_transfers);
+    all.insert(all.end(), m_kernels.begin(), m_kernels.end());
 
-    const int group_size = GROUP_SIZE;
+    const cl_ulong deviceTime = busyTime(all);
+    m_lastForcesTime = deviceTime * 1e-9;
 
-    const std::size_t global_size = count % group_size == 0? count: (count + group_size) & (-group_size);
+    if (m_instrumentation != nullptr && m_instrumentation->enabled())
+    {
+        // share of transfers time during which kernels were running
+        const cl_ulong overlapped = transferTime + kernelTime - deviceTime;
+        const double overlap = transferTime > 0? 100.0 * overlapped / transferTime: 0.0;
 
-    queue.enqueue_nd_range_kernel(kernel,
-                                  boost::compute::extents<1>(0),
-                                  boost::compute::extents<1>(global_size),
-                                  boost::compute::extents<1>(group_size));
+        m_instrumentation->record(Instrumentation::TransferOverlap, overlap);
+        TRACE_COUNTER("opencl", "transfer overlap", overlap);
+    }
 
-    auto forceReadFuture = queue.enqueue_read_buffer_async(force, 0, count * sizeof(XY), host_force.data());
+    return std::vector<force_vector_t>(m_hostOutput, m_hostOutput + m_pendingRows);
+}
 
-    forceReadFuture.wait();
 
-    return host_force;
+double OpenCLAccelerator::lastForcesTime() const
+{
+    return m_lastForcesTime;
 }
 
 
@@ -143,42 +327,332 @@ std::vector<XY> OpenCLAccelerator::velocities(const std::vector<force_vector_t>&
 
 std::vector<std::pair<int, int>> OpenCLAccelerator::collisions() const
 {
-    const std::size_t objs = m_objects->size();
+    const int count = m_objects->size();
 
-    const int threads = omp_get_max_threads();
-    std::vector< std::vector< std::pair<int, int> > > toColide(threads);
+    if (count < 2)
+        return {};
 
-    // calculate collisions in parallel
-    #pragma omp parallel for schedule(static, 1)
-    for(std::size_t i = 0; i < objs - 1; i++)
-        for(std::size_t j = i + 1; j < objs; j++)
-        {
-            const float x1 = m_objects->getX()[i];
-            const float y1 = m_objects->getY()[i];
-            const float x2 = m_objects->getX()[j];
-            const float y2 = m_objects->getY()[j];
-            const float r1 = m_objects->getRadius()[i];
-            const float r2 = m_objects->getRadius()[j];
+    configure(count);
+    reserve(count);
 
-            const float dist = utils::distance(x1, y1, x2, y2);
+    TRACE_SCOPE("opencl", "collisions");
 
-            if ( (r1 + r2) > dist)
-            {
-                const int tid = omp_get_thread_num();
-                const auto colided = std::make_pair(i, j);
-                toColide[tid].push_back(colided);
-            }
-        }
+    // positions changed since forces(), upload them again (together with radius)
+    upload(count, {X, Y, Radius});
+    m_residentValid = false;
 
-    std::vector<std::pair<int, int>> result;
+    // kernel counts all pairs, even those which did not fit into buffer - then run it once again with bigger one
+    std::size_t found = findCollisions(count, m_pairsCapacity);
 
-    // collect data from threads into one set of objects to be colided
-    for(int t = 0; t < threads; t++)
+    if (found > m_pairsCapacity)
     {
-        const auto& thread_colided = toColide[t];
-        for(std::size_t i = 0; i < thread_colided.size(); i++)
-            result.push_back( thread_colided[i] );
+        reservePairs(found);
+        found = findCollisions(count, m_pairsCapacity);
     }
 
+    std::vector<cl_int2> pairs(found);
+
+    if (found > 0)
+        m_queue.enqueue_read_buffer(m_pairs, 0, found * sizeof(cl_int2), pairs.data());
+
+    // order of pairs found by device is random, sort them so results are reproducible
+    std::vector<std::pair<int, int>> result;
+    result.reserve(found);
+
+    for(const cl_int2& pair: pairs)
+        result.emplace_back(pair.s[0], pair.s[1]);
+
+    std::sort(result.begin(), result.end());
+
     return result;
 }
+
+
+bool OpenCLAccelerator::residentStep(double& dt, const DtController& accept, bool& collisions)
+{
+    const int count = m_objects->size();
+
+    if (count < 2)
+        return false;
+
+    configure(count);
+    reserve(count);
+
+    TRACE_SCOPE("opencl", "resident step");
+
+    if (m_residentValid == false)
+    {
+        upload(count, {X, Y, Mass, Radius, VX, VY});
+        m_residentValid = true;
+    }
+
+    const std::size_t global_size = globalSize(count);
+    const std::size_t groups = global_size / m_config.groupSize;
+
+    m_forcesKernel.set_arg(4, count);
+    m_forcesKernel.set_arg(5, 0);
+    m_forcesKernel.set_arg(6, count);
+    m_forcesKernel.set_arg(7, 0);
+    m_queue.enqueue_nd_range_kernel(m_forcesKernel,
+                                    boost::compute::extents<1>(0),
+                                    boost::compute::extents<1>(global_size),
+                                    boost::compute::extents<1>(m_config.groupSize));
+
+    // integrate with dt adjustments: only maximal travel of each work group goes to host
+    std::vector<float> travel(groups);
+    m_kickDriftKernel.set_arg(12, count);
+
+    for(;;)
+    {
+        TRACE_SCOPE("opencl", "kick drift");
+
+        m_kickDriftKernel.set_arg(11, static_cast<float>(dt));
+        m_queue.enqueue_nd_range_kernel(m_kickDriftKernel,
+                                        boost::compute::extents<1>(0),
+                                        boost::compute::extents<1>(global_size),
+                                        boost::compute::extents<1>(m_config.groupSize));
+
+        m_queue.enqueue_read_buffer(m_travel, 0, travel.size() * sizeof(float), travel.data());
+
+        const float max_travel = *std::max_element(travel.begin(), travel.end());
+
+        if (accept(dt, max_travel))
+            break;
+    }
+
+    // accept new positions and velocities
+    std::swap(m_objX, m_nextX);
+    std::swap(m_objY, m_nextY);
+    std::swap(m_velX, m_nextVelX);
+    std::swap(m_velY, m_nextVelY);
+
+    bindArguments();
+
+    // only flag collisions (no room for pairs), engine takes care of them on host
+    {
+        TRACE_SCOPE("opencl", "collisions flag");
+        collisions = findCollisions(count, 0) > 0;
+    }
+
+    return true;
+}
+
+
+void OpenCLAccelerator::synchronize()
+{
+    const std::size_t count = m_objects->size();
+
+    if (m_residentValid == false || count == 0)
+        return;
+
+    TRACE_SCOPE("opencl", "synchronize");
+
+    const std::size_t size = count * sizeof(float);
+
+    m_queue.enqueue_read_buffer_async(m_objX, 0, size, staging(X));
+    m_queue.enqueue_read_buffer_async(m_objY, 0, size, staging(Y));
+    m_queue.enqueue_read_buffer_async(m_velX, 0, size, staging(VX));
+    m_queue.enqueue_read_buffer_async(m_velY, 0, size, staging(VY));
+    m_queue.finish();
+
+    std::copy(staging(X), staging(X) + count, m_objects->getX().begin());
+    std::copy(staging(Y), staging(Y) + count, m_objects->getY().begin());
+    std::copy(staging(VX), staging(VX) + count, m_objects->getVX().begin());
+    std::copy(staging(VY), staging(VY) + count, m_objects->getVY().begin());
+}
+
+
+void OpenCLAccelerator::invalidate()
+{
+    m_residentValid = false;
+}
+
+
+void OpenCLAccelerator::setInstrumentation(Instrumentation* instrumentation)
+{
+    m_instrumentation = instrumentation;
+}
+
+
+float* OpenCLAccelerator::staging(StagingColumn column) const
+{
+    return m_hostInput + column * m_capacity;
+}
+
+
+std::size_t OpenCLAccelerator::globalSize(std::size_t objects) const
+{
+    // buffers are padded (see reserve()), so kernels may run past number of objects, up to full work group
+    return (objects + m_config.groupSize - 1) / m_config.groupSize * m_config.groupSize;
+}
+
+
+void OpenCLAccelerator::configure(std::size_t objects) const
+{
+    const OpenCLTuner::Config config = m_tuner->config(objects);
+
+    if (m_program.get() != nullptr && config == m_config)
+        return;
+
+    TRACE_SCOPE("opencl", "configure");
+
+    const std::string options = config.buildOptions();
+    auto it = m_programs.find(options);
+
+    if (it == m_programs.end())
+    {
+        const std::vector<std::string> sources = { forces_kernel_cl, collisions_kernel_cl, integration_kernel_cl };
+        it = m_programs.emplace(options, m_programCache->build(sources, options)).first;
+    }
+
+    m_program = it->second;
+    m_forcesKernel = boost::compute::kernel(m_program, "forces");
+    m_collisionsKernel = boost::compute::kernel(m_program, "collisions");
+    m_kickDriftKernel = boost::compute::kernel(m_program, "kick_drift");
+    m_config = config;
+
+    bindArguments();
+}
+
+
+void OpenCLAccelerator::reserve(std::size_t objects) const
+{
+    if (objects <= m_capacity)
+        return;
+
+    TRACE_SCOPE("opencl", "reserve");
+
+    // Grow geometrically to avoid reallocations when objects are being added one by one.
+    // Kernels are run for whole work groups, so capacity is padded to biggest one.
+    const std::size_t wanted = std::max(objects, m_capacity * 2);
+    const std::size_t capacity = (wanted + OpenCLTuner::MaxGroupSize - 1) / OpenCLTuner::MaxGroupSize * OpenCLTuner::MaxGroupSize;
+    const std::size_t columnSize = capacity * sizeof(float);
+
+    unmapPinned();
+
+    m_objX = boost::compute::buffer(m_context, columnSize);
+    m_objY = boost::compute::buffer(m_context, columnSize);
+    m_mass = boost::compute::buffer(m_context, columnSize);
+    m_radius = boost::compute::buffer(m_context, columnSize);
+    m_force = boost::compute::buffer(m_context, capacity * sizeof(force_vector_t));
+
+    m_velX = boost::compute::buffer(m_context, columnSize);
+    m_velY = boost::compute::buffer(m_context, columnSize);
+    m_nextX = boost::compute::buffer(m_context, columnSize);
+    m_nextY = boost::compute::buffer(m_context, columnSize);
+    m_nextVelX = boost::compute::buffer(m_context, columnSize);
+    m_nextVelY = boost::compute::buffer(m_context, columnSize);
+    m_travel = boost::compute::buffer(m_context, capacity * sizeof(float));                // one entry per work group
+
+    m_residentValid = false;
+
+    // host accessible (pinned) memory, kept mapped for whole life of buffers
+    m_pinnedInput = boost::compute::buffer(m_context, Columns * columnSize, boost::compute::buffer::alloc_host_ptr);
+    m_pinnedOutput = boost::compute::buffer(m_context, capacity * sizeof(force_vector_t), boost::compute::buffer::alloc_host_ptr);
+
+    m_hostInput = static_cast<float *>(m_queue.enqueue_map_buffer(m_pinnedInput, CL_MAP_READ | CL_MAP_WRITE, 0, m_pinnedInput.size()));
+    m_hostOutput = static_cast<force_vector_t *>(m_queue.enqueue_map_buffer(m_pinnedOutput, CL_MAP_READ | CL_MAP_WRITE, 0, m_pinnedOutput.size()));
+
+    m_capacity = capacity;
+
+    bindArguments();
+}
+
+
+void OpenCLAccelerator::reservePairs(std::size_t pairs) const
+{
+    if (pairs <= m_pairsCapacity)
+        return;
+
+    m_pairsCapacity = std::max(pairs, m_pairsCapacity * 2);
+    m_pairs = boost::compute::buffer(m_context, m_pairsCapacity * sizeof(cl_int2), boost::compute::buffer::write_only);
+}
+
+
+void OpenCLAccelerator::bindArguments() const
+{
+    m_forcesKernel.set_arg(0, m_objX);
+    m_forcesKernel.set_arg(1, m_objY);
+    m_forcesKernel.set_arg(2, m_mass);
+    m_forcesKernel.set_arg(3, m_force);
+
+    m_collisionsKernel.set_arg(0, m_objX);
+    m_collisionsKernel.set_arg(1, m_objY);
+    m_collisionsKernel.set_arg(2, m_radius);
+
+    m_kickDriftKernel.set_arg(0, m_objX);
+    m_kickDriftKernel.set_arg(1, m_objY);
+    m_kickDriftKernel.set_arg(2, m_velX);
+    m_kickDriftKernel.set_arg(3, m_velY);
+    m_kickDriftKernel.set_arg(4, m_mass);
+    m_kickDriftKernel.set_arg(5, m_force);
+    m_kickDriftKernel.set_arg(6, m_nextX);
+    m_kickDriftKernel.set_arg(7, m_nextY);
+    m_kickDriftKernel.set_arg(8, m_nextVelX);
+    m_kickDriftKernel.set_arg(9, m_nextVelY);
+    m_kickDriftKernel.set_arg(10, m_travel);
+}
+
+
+void OpenCLAccelerator::unmapPinned() const
+{
+    if (m_hostInput != nullptr)
+        m_queue.enqueue_unmap_buffer(m_pinnedInput, m_hostInput);
+
+    if (m_hostOutput != nullptr)
+        m_queue.enqueue_unmap_buffer(m_pinnedOutput, m_hostOutput);
+
+    if (m_hostInput != nullptr || m_hostOutput != nullptr)
+        m_queue.finish();
+
+    m_hostInput = nullptr;
+    m_hostOutput = nullptr;
+}
+
+
+void OpenCLAccelerator::upload(std::size_t count, const std::vector<StagingColumn>& columns) const
+{
+    // stage data in pinned memory, so driver can DMA it directly. Queue is in-order, so there is no need to wait for transfers
+    for(const StagingColumn column: columns)
+    {
+        const Objects::DataVector* source = nullptr;
+        boost::compute::buffer* destination = nullptr;
+
+        switch(column)
+        {
+            case X:         source = &m_objects->getX();       destination = &m_objX;      break;
+            case Y:         source = &m_objects->getY();       destination = &m_objY;      break;
+            case Mass:      source = &m_objects->getMass();    destination = &m_mass;      break;
+            case Radius:    source = &m_objects->getRadius();  destination = &m_radius;    break;
+            case VX:        source = &m_objects->getVX();      destination = &m_velX;      break;
+            case VY:        source = &m_objects->getVY();      destination = &m_velY;      break;
+            case Columns:   break;
+        }
+
+        assert(source != nullptr && destination != nullptr);
+
+        std::copy(source->begin(), source->begin() + count, staging(column));
+        m_queue.enqueue_write_buffer_async(*destination, 0, count * sizeof(float), staging(column));
+    }
+}
+
+
+std::size_t OpenCLAccelerator::findCollisions(int count, std::size_t capacity) const
+{
+    static const cl_int zero = 0;
+    cl_int found = 0;
+
+    m_collisionsKernel.set_arg(3, m_pairs);
+    m_collisionsKernel.set_arg(4, m_pairsFound);
+    m_collisionsKernel.set_arg(5, static_cast<cl_int>(capacity));
+    m_collisionsKernel.set_arg(6, count);
+
+    m_queue.enqueue_write_buffer_async(m_pairsFound, 0, sizeof(cl_int), &zero);
+    m_queue.enqueue_nd_range_kernel(m_collisionsKernel,
+                                    boost::compute::extents<1>(0),
+                                    boost::compute::extents<1>(globalSize(count)),
+                                    boost::compute::extents<1>(m_config.groupSize));
+    m_queue.enqueue_read_buffer(m_pairsFound, 0, sizeof(cl_int), &found);
+
+    return static_cast<std::size_t>(found);
+}
@@ -20,15 +20,24 @@
 #ifndef OPENCLACCELERATOR_HPP
 #define OPENCLACCELERATOR_HPP
 
+#include <map>
+#include <memory>
+
 #include <boost/compute/core.hpp>
 
 #include "iaccelerator.hpp"
+#include "opencl_program_cache.hpp"
+#include "opencl_tuner.hpp"
 
 class Objects;
 
 class OpenCLAccelerator: public IAccelerator
 {
     public:
+        // forces() splits objects into this many chunks (if there are enough of them) to overlap transfers with kernels
+        static constexpr std::size_t PipelineChunks = 4;
+        static constexpr std::size_t MinChunkSize = 2048;
+
         OpenCLAccelerator(Objects * = nullptr);
         OpenCLAccelerator(const OpenCLAccelerator &) = delete;
         ~OpenCLAccelerator();
@@ -41,11 +50,91 @@ class OpenCLAccelerator: public IAccelerator
         virtual std::vector<XY> velocities(const std::vector<force_vector_t>& forces, time_type dt) const override;
         virtual std::vector<std::pair<int, int>> collisions() const override;
 
+        virtual bool residentStep(double& dt, const DtController &, bool& collisions) override;
+        virtual void synchronize() override;
+        virtual void invalidate() override;
+
+        virtual void setInstrumentation(Instrumentation *) override;
+
+        // Forces acting on objects [0, rows) only (from all objects), see HybridAccelerator.
+        // enqueueForces() returns as soon as work is queued, finishForces() waits for results.
+        void enqueueForces(std::size_t rows);
+        std::vector<force_vector_t> finishForces();
+        double lastForcesTime() const;                      // [s] of device's work in last forces()
+
     private:
+        // columns of pinned staging memory
+        enum StagingColumn
+        {
+            X,
+            Y,
+            Mass,
+            Radius,
+            VX,
+            VY,
+
+            Columns,
+        };
+
         Objects* m_objects;
-        boost::compute::program m_program;
         boost::compute::context m_context;
         boost::compute::device  m_device;
+        Instrumentation* m_instrumentation;
+        std::unique_ptr<OpenCLProgramCache> m_programCache;  // used by tuner, so it has to outlive it
+        std::unique_ptr<OpenCLTuner> m_tuner;
+
+        // device state is reused between steps and shared by forces() and (const) collisions()
+        mutable OpenCLTuner::Config m_config;               // of current program
+        mutable std::map<std::string, boost::compute::program> m_programs;    // by build options (built ones are cached on disk too)
+        mutable boost::compute::program m_program;
+        mutable boost::compute::command_queue m_queue;          // kernels (and all transfers outside of forces())
+        mutable boost::compute::command_queue m_transferQueue;  // transfers of forces() pipeline
+        mutable boost::compute::kernel m_forcesKernel;
+        mutable boost::compute::kernel m_collisionsKernel;
+        mutable boost::compute::kernel m_kickDriftKernel;
+
+        // device buffers and pinned host memory for transfers
+        mutable std::size_t m_capacity;                     // in objects
+        mutable boost::compute::buffer m_objX;
+        mutable boost::compute::buffer m_objY;
+        mutable boost::compute::buffer m_mass;
+        mutable boost::compute::buffer m_radius;
+        mutable boost::compute::buffer m_force;
+        mutable boost::compute::buffer m_pinnedInput;       // all staging columns, m_capacity each
+        mutable boost::compute::buffer m_pinnedOutput;
+        mutable float* m_hostInput;                         // m_pinnedInput mapped into host memory
+        mutable force_vector_t* m_hostOutput;               // m_pinnedOutput mapped into host memory
+
+        // forces() pipeline in progress
+        std::vector<boost::compute::event> m_transfers;
+        std::vector<boost::compute::event> m_kernels;
+        std::size_t m_pendingRows;
+        double m_lastForcesTime;
+
+        // collisions found on device
+        mutable std::size_t m_pairsCapacity;
+        mutable boost::compute::buffer m_pairs;
+        mutable boost::compute::buffer m_pairsFound;        // counter
+
+        // device resident state (see residentStep()): velocities, results of kick_drift and maximal travel per work group
+        mutable bool m_residentValid;                       // device buffers contain current objects
+        mutable boost::compute::buffer m_velX;
+        mutable boost::compute::buffer m_velY;
+        mutable boost::compute::buffer m_nextX;
+        mutable boost::compute::buffer m_nextY;
+        mutable boost::compute::buffer m_nextVelX;
+        mutable boost::compute::buffer m_nextVelY;
+        mutable boost::compute::buffer m_travel;
+
+        float* staging(StagingColumn) const;
+        std::size_t globalSize(std::size_t objects) const;
+        void configure(std::size_t objects) const;
+        void reserve(std::size_t objects) const;
+        void reservePairs(std::size_t pairs) const;
+        void bindArguments() const;
+        void unmapPinned() const;
+        void upload(std::size_t count, const std::vector<StagingColumn> &) const;
+        std::size_t findCollisions(int count, std::size_t capacity) const;
 };
 
 #endif // OPENCLACCELERATOR_HPP
@@ -0,0 +1,195 @@
+/*
+ * Cache of compiled OpenCL programs.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#define BOOST_COMPUTE_DEBUG_KERNEL_COMPILATION
+
+#include "opencl_program_cache.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "disk_cache.hpp"
+
+
+namespace
+{
+    // first line of cache file, bump when format changes
+    const char* const fileMagic = "gravity_simulator opencl program 1";
+
+    std::string toHex(std::uint64_t value)
+    {
+        std::ostringstream result;
+        result << std::hex << std::setw(16) << std::setfill('0') << value;
+
+        return result.str();
+    }
+}
+
+
+OpenCLProgramCache::OpenCLProgramCache(const boost::compute::context& context, const boost::compute::device& device, const std::string& directory):
+    m_context(context),
+    m_device(device),
+    m_directory(directory)
+{
+    const char* cache = std::getenv("GRAVITY_OPENCL_PROGRAM_CACHE");
+
+    if (cache != nullptr && std::string(cache) == "0")
+        m_directory.clear();
+}
+
+
+OpenCLProgramCache::~OpenCLProgramCache()
+{
+
+}
+
+
+boost::compute::program OpenCLProgramCache::build(const std::vector<std::string>& sources, const std::string& options)
+{
+    const std::string programKey = key(sources, options);
+
+    boost::compute::program program = load(programKey, options);
+
+    if (program.get() == nullptr)
+    {
+        program = boost::compute::program::create_with_source(sources, m_context);
+        program.build(options);
+
+        store(programKey, program);
+    }
+
+    return program;
+}
+
+
+std::uint64_t OpenCLProgramCache::hash(const std::string& data)
+{
+    std::uint64_t result = 14695981039346656037ull;
+
+    for(const char c: data)
+    {
+        result ^= static_cast<unsigned char>(c);
+        result *= 1099511628211ull;
+    }
+
+    return result;
+}
+
+
+std::string OpenCLProgramCache::defaultDirectory()
+{
+    const std::string cacheDir = DiskCache::directory();
+
+    return cacheDir.empty()? cacheDir: cacheDir + "/opencl_programs";
+}
+
+
+std::string OpenCLProgramCache::serialize(const std::string& programKey, const std::vector<unsigned char>& binary)
+{
+    std::string result = std::string(fileMagic) + '\n' + programKey + '\n' + std::to_string(binary.size()) + '\n';
+    result.append(binary.begin(), binary.end());
+
+    return result;
+}
+
+
+std::vector<unsigned char> OpenCLProgramCache::deserialize(std::istream& file, const std::string& programKey)
+{
+    std::string magic;
+    std::string storedKey;
+    std::size_t size = 0;
+
+    if (std::getline(file, magic) && std::getline(file, storedKey) && (file >> size) && file.get() == '\n')
+    {
+        // file name is just a hash of key, so compare whole key to be sure it is the same program
+        if (magic != fileMagic || storedKey != programKey || size == 0)
+            return {};
+
+        std::vector<unsigned char> binary(size);
+        file.read(reinterpret_cast<char *>(binary.data()), static_cast<std::streamsize>(size));
+
+        if (file.gcount() == static_cast<std::streamsize>(size))
+            return binary;
+    }
+
+    return {};
+}
+
+
+std::string OpenCLProgramCache::key(const std::vector<std::string>& sources, const std::string& options) const
+{
+    std::string source;
+    for(const std::string& part: sources)
+        source += part;
+
+    // everything which may change resulting binary (tabs separated, single line)
+    return m_device.name() + '\t' +
+           m_device.vendor() + '\t' +
+           m_device.driver_version() + '\t' +
+           m_device.platform().version() + '\t' +
+           toHex(hash(source)) + '\t' +
+           options;
+}
+
+
+std::string OpenCLProgramCache::path(const std::string& programKey) const
+{
+    return m_directory + "/" + toHex(hash(programKey)) + ".bin";
+}
+
+
+boost::compute::program OpenCLProgramCache::load(const std::string& programKey, const std::string& options) const
+{
+    if (m_directory.empty())
+        return boost::compute::program();
+
+    std::ifstream file(path(programKey), std::ios_base::in | std::ios_base::binary);
+    const std::vector<unsigned char> binary = deserialize(file, programKey);
+
+    if (binary.empty() == false)
+    {
+        try
+        {
+            boost::compute::program program = boost::compute::program::create_with_binary(binary, m_context);
+            program.build(options);
+
+            return program;
+        }
+        catch(const boost::compute::opencl_error &)
+        {
+            // binary refused by device (i.e. corrupted), compile it again
+        }
+    }
+
+    return boost::compute::program();
+}
+
+
+void OpenCLProgramCache::store(const std::string& programKey, const boost::compute::program& program) const
+{
+    if (m_directory.empty())
+        return;
+
+    const std::vector<unsigned char> binary = program.binary();
+
+    if (binary.empty() == false)
+        DiskCache::write(path(programKey), serialize(programKey, binary));
+}
@@ -0,0 +1,66 @@
+/*
+ * Cache of compiled OpenCL programs.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OPENCLPROGRAMCACHE_HPP
+#define OPENCLPROGRAMCACHE_HPP
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include <boost/compute/core.hpp>
+
+
+// Builds OpenCL programs, keeping their binaries on disk so next runs do not need to compile them again.
+// Binaries are keyed by device name, driver version, hash of sources and build options.
+// When binary is missing or does not match (or device refuses it) program is compiled from sources.
+//
+// Disk cache may be disabled with GRAVITY_OPENCL_PROGRAM_CACHE=0 environment variable.
+class OpenCLProgramCache
+{
+    public:
+        OpenCLProgramCache(const boost::compute::context &, const boost::compute::device &, const std::string& directory = defaultDirectory());
+        OpenCLProgramCache(const OpenCLProgramCache &) = delete;
+        ~OpenCLProgramCache();
+
+        OpenCLProgramCache& operator=(const OpenCLProgramCache &) = delete;
+
+        boost::compute::program build(const std::vector<std::string>& sources, const std::string& options);
+
+        static std::uint64_t hash(const std::string &);             // FNV-1a, stable between runs and builds
+        static std::string defaultDirectory();                      // in DiskCache::directory()
+
+        // cache file: magic, key and size lines followed by binary.
+        // deserialize() returns empty binary when file is damaged or was written for other key
+        static std::string serialize(const std::string& key, const std::vector<unsigned char>& binary);
+        static std::vector<unsigned char> deserialize(std::istream &, const std::string& key);
+
+    private:
+        boost::compute::context m_context;
+        boost::compute::device m_device;
+        std::string m_directory;
+
+        std::string key(const std::vector<std::string>& sources, const std::string& options) const;
+        std::string path(const std::string& key) const;
+        boost::compute::program load(const std::string& key, const std::string& options) const;
+        void store(const std::string& key, const boost::compute::program &) const;
+};
+
+#endif // OPENCLPROGRAMCACHE_HPP
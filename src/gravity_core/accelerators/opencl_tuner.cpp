@@ -0,0 +1,345 @@
+/*
+ * Autotuning of OpenCL kernels.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "opencl_tuner.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+
+#include "disk_cache.hpp"
+#include "forces_kernel.hpp"
+#include "opencl_program_cache.hpp"
+
+
+namespace
+{
+    // Benchmark size limit. Kernels are O(N²), so bigger buckets are tuned on this many objects.
+    const std::size_t maxTuningObjects = 16384;
+}
+
+
+const OpenCLTuner::Config OpenCLTuner::defaultConfig = { 128, 128, 1 };
+
+
+std::string OpenCLTuner::Config::buildOptions() const
+{
+    return "-DGROUP_SIZE=" + std::to_string(groupSize) +
+           " -DLOCAL_MEM_SIZE=" + std::to_string(tileSize) +
+           " -DUNROLL=" + std::to_string(unroll);
+}
+
+
+bool OpenCLTuner::Config::operator==(const Config& other) const
+{
+    return groupSize == other.groupSize && tileSize == other.tileSize && unroll == other.unroll;
+}
+
+
+bool OpenCLTuner::Config::operator!=(const Config& other) const
+{
+    return (*this == other) == false;
+}
+
+
+OpenCLTuner::OpenCLTuner(const boost::compute::context& context, const boost::compute::device& device, OpenCLProgramCache& programCache,
+                         const std::string& cacheFile):
+    m_context(context),
+    m_device(device),
+    m_programCache(programCache),
+    m_cacheFile(cacheFile),
+    m_configs(),
+    m_enabled(true)
+{
+    const char* tuning = std::getenv("GRAVITY_OPENCL_TUNING");
+    m_enabled = tuning == nullptr || std::string(tuning) != "0";
+
+    if (m_enabled)
+        load();
+}
+
+
+OpenCLTuner::~OpenCLTuner()
+{
+
+}
+
+
+OpenCLTuner::Config OpenCLTuner::config(std::size_t objects)
+{
+    if (m_enabled == false)
+        return fallback();
+
+    const std::size_t b = bucket(objects);
+    auto it = m_configs.find(b);
+
+    if (it == m_configs.end())
+    {
+        const Config tuned = tune(b);
+
+        // stdout belongs to applications (gravity_cli writes its summary there)
+        std::cerr << "OpenCL kernels tuned for " << (std::size_t(1) << b) << " objects: "
+                  << "work group " << tuned.groupSize << ", tile " << tuned.tileSize << ", unroll " << tuned.unroll << std::endl;
+
+        store(b, tuned);
+        it = m_configs.emplace(b, tuned).first;
+    }
+
+    return it->second;
+}
+
+
+std::vector<OpenCLTuner::Config> OpenCLTuner::candidates() const
+{
+    const std::size_t localMemory = m_device.local_memory_size();
+    const std::size_t maxGroup = maxGroupSize();
+
+    std::vector<Config> result;
+
+    for(std::size_t group = 1; group <= maxGroup; group *= 2)
+    {
+        // small groups are worth trying only on devices which do not allow bigger ones (some CPU runtimes)
+        if (group < 32 && maxGroup >= 32)
+            continue;
+
+        for(std::size_t tile: {group, 2 * group, 4 * group})
+        {
+            // kernels keep 3 floats per object of tile in local memory
+            if (3 * tile * sizeof(float) > localMemory)
+                continue;
+
+            for(int unroll: {1, 4, 8})
+                result.push_back( Config{group, tile, unroll} );
+        }
+    }
+
+    return result;
+}
+
+
+std::size_t OpenCLTuner::bucket(std::size_t objects)
+{
+    std::size_t result = 0;
+
+    while ((std::size_t(1) << result) < objects)
+        result++;
+
+    return result;
+}
+
+
+std::string OpenCLTuner::defaultCacheFile()
+{
+    const std::string cacheDir = DiskCache::directory();
+
+    return cacheDir.empty()? cacheDir: cacheDir + "/opencl_tuning.txt";
+}
+
+
+std::map<std::size_t, OpenCLTuner::Config> OpenCLTuner::parseCache(std::istream& file, const std::string& device)
+{
+    std::map<std::size_t, Config> result;
+
+    for(std::string line; std::getline(file, line); )
+    {
+        std::istringstream entry(line);
+        std::string entryDevice;
+        std::size_t bucket = 0;
+        Config config = defaultConfig;
+
+        if (std::getline(entry, entryDevice, '\t') && entry >> bucket >> config.groupSize >> config.tileSize >> config.unroll && entryDevice == device)
+            result[bucket] = config;
+    }
+
+    return result;
+}
+
+
+std::string OpenCLTuner::updateCache(std::istream& file, const std::string& device, std::size_t bucket, const Config& config)
+{
+    std::ostringstream result;
+
+    for(std::string line; std::getline(file, line); )
+    {
+        std::istringstream entry(line);
+        std::string entryDevice;
+        std::size_t entryBucket = 0;
+
+        const bool valid = std::getline(entry, entryDevice, '\t') && entry >> entryBucket;
+
+        if (valid && (entryDevice != device || entryBucket != bucket))
+            result << line << '\n';
+    }
+
+    result << device << '\t' << bucket << '\t' << config.groupSize << '\t' << config.tileSize << '\t' << config.unroll << '\n';
+
+    return result.str();
+}
+
+
+OpenCLTuner::Config OpenCLTuner::tune(std::size_t bucket)
+{
+    const std::size_t objects = std::min(std::size_t(1) << bucket, maxTuningObjects);
+    const std::size_t padded = (objects + MaxGroupSize - 1) / MaxGroupSize * MaxGroupSize;
+
+    // workload: random objects (kernels do not branch on data, so its exact shape does not matter)
+    std::mt19937 generator(static_cast<unsigned int>(objects));
+    std::uniform_real_distribution<float> position(-1e9f, 1e9f);
+
+    std::vector<float> x(padded), y(padded), mass(padded, 1e20f);
+    for(std::size_t i = 0; i < padded; i++)
+    {
+        x[i] = position(generator);
+        y[i] = position(generator);
+    }
+
+    boost::compute::command_queue queue(m_context, m_device);
+    boost::compute::buffer objX(m_context, padded * sizeof(float));
+    boost::compute::buffer objY(m_context, padded * sizeof(float));
+    boost::compute::buffer objMass(m_context, padded * sizeof(float));
+    boost::compute::buffer force(m_context, padded * 2 * sizeof(float));
+
+    queue.enqueue_write_buffer(objX, 0, padded * sizeof(float), x.data());
+    queue.enqueue_write_buffer(objY, 0, padded * sizeof(float), y.data());
+    queue.enqueue_write_buffer(objMass, 0, padded * sizeof(float), mass.data());
+
+    // group size does not change code of forces kernel, so programs are built once for each tile and unroll
+    std::map<std::string, boost::compute::kernel> kernels;
+
+    Config best = fallback();
+    double bestTime = std::numeric_limits<double>::max();
+
+    for(const Config& candidate: candidates())
+    {
+        try
+        {
+            const std::string options = "-DLOCAL_MEM_SIZE=" + std::to_string(candidate.tileSize) +
+                                        " -DUNROLL=" + std::to_string(candidate.unroll);
+
+            auto kernelIt = kernels.find(options);
+
+            if (kernelIt == kernels.end())
+            {
+                const boost::compute::program program = m_programCache.build({ forces_kernel_cl }, options);
+
+                kernelIt = kernels.emplace(options, boost::compute::kernel(program, "forces")).first;
+            }
+
+            boost::compute::kernel& kernel = kernelIt->second;
+
+            if (candidate.groupSize > kernel.get_work_group_info<std::size_t>(m_device, CL_KERNEL_WORK_GROUP_SIZE))
+                continue;
+
+            kernel.set_arg(0, objX);
+            kernel.set_arg(1, objY);
+            kernel.set_arg(2, objMass);
+            kernel.set_arg(3, force);
+            kernel.set_arg(4, static_cast<cl_int>(objects));
+            kernel.set_arg(5, static_cast<cl_int>(0));
+            kernel.set_arg(6, static_cast<cl_int>(objects));
+            kernel.set_arg(7, static_cast<cl_int>(0));
+
+            const std::size_t global_size = (objects + candidate.groupSize - 1) / candidate.groupSize * candidate.groupSize;
+
+            // first run is a warmup
+            double time = std::numeric_limits<double>::max();
+
+            for(int run = 0; run < 3; run++)
+            {
+                const auto start = std::chrono::steady_clock::now();
+
+                queue.enqueue_nd_range_kernel(kernel,
+                                              boost::compute::extents<1>(0),
+                                              boost::compute::extents<1>(global_size),
+                                              boost::compute::extents<1>(candidate.groupSize));
+                queue.finish();
+
+                const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+                if (run > 0)
+                    time = std::min(time, duration.count());
+            }
+
+            if (time < bestTime)
+            {
+                bestTime = time;
+                best = candidate;
+            }
+        }
+        catch(const boost::compute::opencl_error &)
+        {
+            // configuration not supported by device (i.e. not enough resources)
+        }
+    }
+
+    return best;
+}
+
+
+OpenCLTuner::Config OpenCLTuner::fallback() const
+{
+    const std::size_t group = std::min(defaultConfig.groupSize, maxGroupSize());
+
+    return Config{ group, std::max(group, defaultConfig.tileSize), defaultConfig.unroll };
+}
+
+
+std::size_t OpenCLTuner::maxGroupSize() const
+{
+    std::size_t result = 1;
+
+    // power of 2, as required by reductions in kernels
+    while (result * 2 <= std::min<std::size_t>(m_device.max_work_group_size(), MaxGroupSize))
+        result *= 2;
+
+    return result;
+}
+
+
+void OpenCLTuner::load()
+{
+    if (m_cacheFile.empty())
+        return;
+
+    std::ifstream file(m_cacheFile);
+    const std::vector<Config> valid = candidates();
+
+    // entries not valid anymore for device (i.e. after driver change) are ignored
+    for(const auto& entry: parseCache(file, m_device.name()))
+        if (std::find(valid.begin(), valid.end(), entry.second) != valid.end())
+            m_configs[entry.first] = entry.second;
+}
+
+
+void OpenCLTuner::store(std::size_t bucket, const Config& config) const
+{
+    if (m_cacheFile.empty())
+        return;
+
+    std::ifstream file(m_cacheFile);
+    const std::string content = updateCache(file, m_device.name(), bucket, config);
+    file.close();
+
+    DiskCache::write(m_cacheFile, content);
+}
@@ -0,0 +1,91 @@
+/*
+ * Autotuning of OpenCL kernels.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OPENCLTUNER_HPP
+#define OPENCLTUNER_HPP
+
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/compute/core.hpp>
+
+class OpenCLProgramCache;
+
+// Chooses work group size, local memory tile size and loop unroll factor of OpenCLAccelerator's kernels.
+// Candidates are benchmarked (forces kernel) on given device when bucket of objects count (next power of 2)
+// is seen for the first time. Candidate programs are built through OpenCLProgramCache, so only the first
+// tuning on device compiles them. Winners are remembered per device name and bucket in memory and in cache file.
+//
+// Tuning may be disabled with GRAVITY_OPENCL_TUNING=0 environment variable, defaultConfig is used then.
+class OpenCLTuner
+{
+    public:
+        struct Config
+        {
+            std::size_t groupSize;
+            std::size_t tileSize;                   // objects kept in local memory at once (LOCAL_MEM_SIZE)
+            int unroll;                             // unroll factor of main loop (UNROLL)
+
+            std::string buildOptions() const;
+
+            bool operator==(const Config &) const;
+            bool operator!=(const Config &) const;
+        };
+
+        static const Config defaultConfig;
+        static constexpr std::size_t MaxGroupSize = 256;           // buffers should be padded to it
+
+        OpenCLTuner(const boost::compute::context &, const boost::compute::device &, OpenCLProgramCache &,
+                    const std::string& cacheFile = defaultCacheFile());
+        OpenCLTuner(const OpenCLTuner &) = delete;
+        ~OpenCLTuner();
+
+        OpenCLTuner& operator=(const OpenCLTuner &) = delete;
+
+        Config config(std::size_t objects);
+
+        std::vector<Config> candidates() const;                     // valid for device
+
+        static std::size_t bucket(std::size_t objects);             // ⌈log2(objects)⌉
+        static std::string defaultCacheFile();                      // in DiskCache::directory()
+
+        // cache file: one entry per line: device name, bucket, group size, tile size, unroll (tab separated).
+        // parseCache() returns configs of given device by bucket (later entries override earlier ones),
+        // updateCache() returns new content of file with entry of device and bucket replaced (other entries are kept)
+        static std::map<std::size_t, Config> parseCache(std::istream &, const std::string& device);
+        static std::string updateCache(std::istream &, const std::string& device, std::size_t bucket, const Config &);
+
+    private:
+        boost::compute::context m_context;
+        boost::compute::device m_device;
+        OpenCLProgramCache& m_programCache;
+        std::string m_cacheFile;
+        std::map<std::size_t, Config> m_configs;                    // bucket -> config
+        bool m_enabled;
+
+        Config tune(std::size_t bucket);
+        Config fallback() const;                                    // defaultConfig limited to device
+        std::size_t maxGroupSize() const;
+        void load();
+        void store(std::size_t bucket, const Config &) const;
+};
+
+#endif // OPENCLTUNER_HPP
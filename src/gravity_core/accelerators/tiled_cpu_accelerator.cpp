@@ -0,0 +1,234 @@
+/*
+ * CPU accelerator processing objects in tiles.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "tiled_cpu_accelerator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include <omp.h>
+
+#include "../objects.hpp"
+#include "../tracing.hpp"
+
+
+namespace
+{
+    const std::size_t min_tile_size = 8;
+}
+
+
+TiledCpuAccelerator::TiledCpuAccelerator(std::size_t memoryBudget, Objects* objects):
+    m_objects(objects),
+    m_memoryBudget(memoryBudget)
+{
+
+}
+
+
+TiledCpuAccelerator::~TiledCpuAccelerator()
+{
+
+}
+
+
+void TiledCpuAccelerator::setObjects(Objects* objects)
+{
+    m_objects = objects;
+}
+
+
+std::vector<force_vector_t> TiledCpuAccelerator::forces()
+{
+    assert(m_objects != nullptr);
+
+    const std::size_t objs = m_objects->size();
+    const std::size_t tile = std::min(tileSize(), std::max<std::size_t>(objs, 1));     // do not allocate private forces bigger than needed
+    const int threads = omp_get_max_threads();
+
+    std::vector<force_vector_t> forces(objs);
+
+    // private accumulators for forces of 'I' tile - each thread works on different 'J' tile, but the same 'I' one
+    std::vector<std::vector<XY>> private_forces(threads, std::vector<XY>(tile));
+
+    for(std::size_t firstI = 0; firstI < objs; firstI += tile)
+    {
+        TRACE_SCOPE("accelerator", "forces tile row");
+
+        const std::size_t lastI = std::min(firstI + tile, objs);
+
+        #pragma omp parallel for schedule(dynamic)
+        for(std::size_t firstJ = firstI; firstJ < objs; firstJ += tile)
+        {
+            const std::size_t lastJ = std::min(firstJ + tile, objs);
+            const int tid = omp_get_thread_num();
+
+            forcesFor(firstI, lastI, firstJ, lastJ, private_forces[tid], forces);
+        }
+
+        // accumulate results
+        for(int t = 0; t < threads; t++)
+            for(std::size_t i = firstI; i < lastI; i++)
+            {
+                XY& f = private_forces[t][i - firstI];
+
+                forces[i] += f;
+                f = XY(0.0, 0.0);
+            }
+    }
+
+    return forces;
+}
+
+
+std::vector<XY> TiledCpuAccelerator::velocities(const std::vector<force_vector_t>& forces, time_type dt) const
+{
+    assert(m_objects != nullptr);
+
+    const std::size_t objs = m_objects->size();
+    std::vector<XY> result;
+    result.reserve(objs);
+
+    for(std::size_t i = 0; i < objs; i++)
+    {
+        const force_vector_t& dF = forces[i];
+        const Object& o = (*m_objects)[i];
+
+        // F=am ⇒ a = F/m
+        const acceleration_vector_t a = dF / o.mass();
+
+        // ΔV = aΔt
+        const velocity_vector_t dv = a * dt;
+
+        result.push_back(dv);
+    }
+
+    return result;
+}
+
+
+std::vector<std::pair<int, int>> TiledCpuAccelerator::collisions() const
+{
+    assert(m_objects != nullptr);
+
+    const std::size_t objs = m_objects->size();
+    const std::size_t tile = tileSize();
+    const int threads = omp_get_max_threads();
+
+    std::vector<std::vector<std::pair<int, int>>> toColide(threads);
+
+    for(std::size_t firstI = 0; firstI < objs; firstI += tile)
+    {
+        TRACE_SCOPE("accelerator", "collisions tile row");
+
+        const std::size_t lastI = std::min(firstI + tile, objs);
+
+        #pragma omp parallel for schedule(dynamic)
+        for(std::size_t firstJ = firstI; firstJ < objs; firstJ += tile)
+        {
+            const std::size_t lastJ = std::min(firstJ + tile, objs);
+            const int tid = omp_get_thread_num();
+
+            collisionsFor(firstI, lastI, firstJ, lastJ, toColide[tid]);
+        }
+    }
+
+    std::vector<std::pair<int, int>> result;
+
+    for(int t = 0; t < threads; t++)
+        result.insert(result.end(), toColide[t].begin(), toColide[t].end());
+
+    return result;
+}
+
+
+std::size_t TiledCpuAccelerator::tileSize() const
+{
+    // Memory touched at once: 'I' tile (x, y, mass, radius),
+    // and for each thread: 'J' tile (x, y, mass, radius + forces) and private forces of 'I' tile.
+    const std::size_t threads = omp_get_max_threads();
+    const std::size_t bytesPerObject = 4 * sizeof(BaseType) + threads * (4 * sizeof(BaseType) + sizeof(force_vector_t) + sizeof(XY));
+
+    const std::size_t budgetTile = m_memoryBudget / bytesPerObject;
+
+    // Threads work on different 'J' tiles of the same row, so there need to be at least as many
+    // tiles as threads. Otherwise (budget tile bigger than all objects) calculations would run on one thread.
+    const std::size_t objs = m_objects == nullptr? 0: m_objects->size();
+    const std::size_t parallelTile = (objs + threads - 1) / threads;
+
+    const std::size_t tile = objs == 0? budgetTile: std::min(budgetTile, parallelTile);
+
+    return std::max(tile, min_tile_size);
+}
+
+
+void TiledCpuAccelerator::forcesFor(std::size_t firstI, std::size_t lastI, std::size_t firstJ, std::size_t lastJ,
+                                    std::vector<XY>& forcesI, std::vector<force_vector_t>& forces) const
+{
+    const BaseType G = 6.6732e-11;
+
+    const BaseType* x = m_objects->getX().data();
+    const BaseType* y = m_objects->getY().data();
+    const BaseType* m = m_objects->getMass().data();
+
+    for(std::size_t i = firstI; i < lastI; i++)
+    {
+        const BaseType x1 = x[i];
+        const BaseType y1 = y[i];
+        const BaseType G_m1 = G * m[i];
+
+        XY& fi = forcesI[i - firstI];
+
+        // on diagonal tiles only upper triangle is calculated
+        for(std::size_t j = std::max(firstJ, i + 1); j < lastJ; j++)
+        {
+            const BaseType x_diff = x[j] - x1;
+            const BaseType y_diff = y[j] - y1;
+            const BaseType dist = std::sqrt(x_diff * x_diff + y_diff * y_diff);
+            const BaseType dist2 = dist * dist;
+            const BaseType Fg = G_m1 * (m[j] / dist2);                  // (G * m1) and (m2 / dist2) are here to decrease partial results - for floats "m1 * m2" may be a killer
+
+            const XY force_vector(x_diff / dist * Fg, y_diff / dist * Fg);
+
+            fi += force_vector;
+            forces[j] += -force_vector;         // 'J' tile belongs to this thread only
+        }
+    }
+}
+
+
+void TiledCpuAccelerator::collisionsFor(std::size_t firstI, std::size_t lastI, std::size_t firstJ, std::size_t lastJ,
+                                        std::vector<std::pair<int, int>>& colided) const
+{
+    const BaseType* x = m_objects->getX().data();
+    const BaseType* y = m_objects->getY().data();
+    const BaseType* r = m_objects->getRadius().data();
+
+    for(std::size_t i = firstI; i < lastI; i++)
+        for(std::size_t j = std::max(firstJ, i + 1); j < lastJ; j++)
+        {
+            const BaseType x_diff = x[j] - x[i];
+            const BaseType y_diff = y[j] - y[i];
+            const BaseType dist = std::sqrt(x_diff * x_diff + y_diff * y_diff);
+
+            if ( (r[i] + r[j]) > dist)
+                colided.push_back( std::make_pair(i, j) );
+        }
+}
@@ -0,0 +1,63 @@
+/*
+ * CPU accelerator processing objects in tiles.
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TILEDCPUACCELERATOR_HPP
+#define TILEDCPUACCELERATOR_HPP
+
+#include <vector>
+
+#include "iaccelerator.hpp"
+
+class Objects;
+
+// Accelerator for huge number of objects (which may not fit in memory, see MappedFileArena).
+// Triangle of object pairs is processed in square tiles, tile after tile.
+// Size of tile is chosen so data of tiles processed at once (by all threads) and threads'
+// private buffers fit in given memory budget.
+// Thanks to that, accelerator's memory usage does not depend on number of objects
+// (except for result of forces()) and Objects' columns are read in a sequential manner.
+// Tiles are also never bigger than number of objects / number of threads, so all threads get work.
+class TiledCpuAccelerator: public IAccelerator
+{
+    public:
+        TiledCpuAccelerator(std::size_t memoryBudget = 64 * 1024 * 1024, Objects * = nullptr);
+        TiledCpuAccelerator(const TiledCpuAccelerator &) = delete;
+        ~TiledCpuAccelerator();
+
+        TiledCpuAccelerator& operator=(const TiledCpuAccelerator &) = delete;
+
+        virtual void setObjects(Objects *) override;
+
+        virtual std::vector<force_vector_t> forces() override;
+        virtual std::vector<XY> velocities(const std::vector<force_vector_t>& forces, time_type dt) const override;
+        virtual std::vector<std::pair<int, int>> collisions() const override;
+
+        std::size_t tileSize() const;
+
+    private:
+        Objects* m_objects;
+        std::size_t m_memoryBudget;
+
+        void forcesFor(std::size_t firstI, std::size_t lastI, std::size_t firstJ, std::size_t lastJ,
+                       std::vector<XY>& forcesI, std::vector<force_vector_t>& forces) const;
+        void collisionsFor(std::size_t firstI, std::size_t lastI, std::size_t firstJ, std::size_t lastJ,
+                           std::vector<std::pair<int, int>> &) const;
+};
+
+#endif // TILEDCPUACCELERATOR_HPP
@@ -0,0 +1,369 @@
+// Times forces(), collisions(), velocities() and SimulationEngine::step()
+// for every available accelerator, number of objects and number of threads.
+//
+// usage: accelerators_benchmark [options]
+//   --max-objects N   largest system to test (default 1000000)
+//   --max-threads T   thread counts 1, 2, 4, ... T (default: all cores)
+//   --min-time S      measure each operation for at least S seconds (default 0.5)
+//   --max-time S      skip operations whose single run is expected to take longer (default 30)
+//   --json FILE       write results as JSON (table is always printed to stdout)
+//
+// Interactions are pairs of objects: N * (N - 1) / 2 for forces(), collisions() and step(),
+// N for velocities(). FLOP and byte counts are per interaction estimates (see Operation),
+// so GFLOP/s and GB/s are comparable between accelerators but are not hardware counters.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <thread>
+
+#include <omp.h>
+
+#include "../objects.hpp"
+#include "../simulation_engine.hpp"
+#include "../accelerators/simple_cpu_accelerator.hpp"
+#include "../accelerators/tiled_cpu_accelerator.hpp"
+
+#ifdef GRAVITY_AVX_ACCELERATOR
+#include "../accelerators/avx_accelerator.hpp"
+#include "../accelerators/avx_blocks_accelerator.hpp"
+#endif
+
+#ifdef GRAVITY_OPENCL_ACCELERATOR
+#include "../accelerators/multi_opencl_accelerator.hpp"
+#include "../accelerators/opencl_accelerator.hpp"
+#endif
+
+#if defined(GRAVITY_OPENCL_ACCELERATOR) && defined(GRAVITY_AVX_ACCELERATOR)
+#include "../accelerators/hybrid_accelerator.hpp"
+#endif
+
+
+namespace
+{
+    struct Accelerator
+    {
+        const char* name;
+        std::function<std::unique_ptr<IAccelerator>()> create;
+    };
+
+    struct Operation
+    {
+        const char* name;
+        bool pairs;                 // interactions are pairs of objects (otherwise objects)
+        double flops;               // floating point operations per interaction
+        double bytes;               // object data loaded/stored per interaction (no caches assumed)
+    };
+
+    struct Result
+    {
+        std::string accelerator;
+        std::string operation;
+        std::size_t objects;
+        int threads;
+        double ms;                  // average time of single run
+        double interactions;        // per second
+        double gflops;
+        double bytesPerInteraction;
+        bool skipped;
+    };
+
+    // forces: dx, dy, distance (with sqrt), G*m1, m2/dist², unit vector, scaling and accumulation of both objects
+    // collisions: dx, dy, squared distance, radii sum and comparison
+    // velocities: a = F/m, dv = a * dt (per object)
+    const Operation operations[] =
+    {
+        { "forces",     true,  20.0, 3 * sizeof(BaseType) },         // x, y, mass of second object
+        { "collisions", true,  8.0,  3 * sizeof(BaseType) },         // x, y, radius of second object
+        { "velocities", false, 6.0,  5 * sizeof(BaseType) },         // force (2), mass, velocity (2)
+        { "step",       true,  28.0, 6 * sizeof(BaseType) },         // forces + collisions
+    };
+
+    std::vector<Accelerator> accelerators()
+    {
+        std::vector<Accelerator> result =
+        {
+            { "simple_cpu", []{ return std::make_unique<SimpleCpuAccelerator>(); } },
+            { "tiled_cpu",  []{ return std::make_unique<TiledCpuAccelerator>(); } },
+#ifdef GRAVITY_AVX_ACCELERATOR
+            { "avx",        []{ return std::make_unique<AVXAccelerator>(); } },
+            { "avx_blocks", []{ return std::make_unique<AVXBlocksAccelerator>(); } },
+#endif
+#ifdef GRAVITY_OPENCL_ACCELERATOR
+            { "opencl",     []{ return std::make_unique<OpenCLAccelerator>(); } },
+            { "opencl_multi", []{ return std::make_unique<MultiOpenCLAccelerator>(); } },
+#endif
+#if defined(GRAVITY_OPENCL_ACCELERATOR) && defined(GRAVITY_AVX_ACCELERATOR)
+            { "hybrid",     []{ return std::make_unique<HybridAccelerator>(); } },
+#endif
+        };
+
+        return result;
+    }
+
+    BaseType fRand(BaseType fMin, BaseType fMax)
+    {
+        BaseType f = static_cast<BaseType>(rand()) / RAND_MAX;
+        return fMin + f * (fMax - fMin);
+    }
+
+    // same scenario for each run, sparse enough to make collisions rare
+    bool fill(Objects& objects, std::size_t first, std::size_t count)
+    {
+        srand(3);
+
+        const BaseType range = 5000e6 * std::max<BaseType>(1, std::sqrt(count / 1000.0f));
+
+        for (std::size_t i = first; i < first + count; i++)
+        {
+            const BaseType x = fRand(-range, range);
+            const BaseType y = fRand(-range, range);
+
+            const BaseType v_x = fRand(-5e2, 5e2);
+            const BaseType v_y = fRand(-5e2, 5e2);
+
+            objects.getX()[i] = x;
+            objects.getY()[i] = y;
+            objects.getVX()[i] = v_x;
+            objects.getVY()[i] = v_y;
+            objects.getMass()[i] = 7.347673e22;
+            objects.getRadius()[i] = 1737.1e3;
+        }
+
+        return true;
+    }
+
+    // run operation until at least 'minTime' passes, return average time of one run in ms
+    double measure(const std::function<void()>& operation, double minTime)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        auto end = start;
+        int runs = 0;
+
+        do
+        {
+            operation();
+            runs++;
+
+            end = std::chrono::steady_clock::now();
+        }
+        while(end - start < std::chrono::duration<double>(minTime));
+
+        const std::chrono::duration<double, std::milli> diff = end - start;
+
+        return diff.count() / runs;
+    }
+
+    double interactions(const Operation& operation, std::size_t count)
+    {
+        const double n = static_cast<double>(count);
+
+        return operation.pairs? n * (n - 1.0) / 2.0: n;
+    }
+
+    std::vector<std::size_t> objectCounts(std::size_t max)
+    {
+        // 32, 100, 320, 1000, 3200 ...
+        std::vector<std::size_t> result;
+
+        for(std::size_t decade = 10; decade * 3.2 <= max; decade *= 10)
+        {
+            const std::size_t low = decade * 32 / 10;
+            const std::size_t high = decade * 10;
+
+            result.push_back(low);
+
+            if (high <= max)
+                result.push_back(high);
+        }
+
+        return result;
+    }
+
+    std::vector<int> threadCounts(int max)
+    {
+        std::vector<int> result;
+
+        for(int threads = 1; threads < max; threads *= 2)
+            result.push_back(threads);
+
+        result.push_back(max);
+
+        return result;
+    }
+
+    void printHeader()
+    {
+        std::cout << std::setw(12) << "accelerator"
+                  << std::setw(12) << "operation"
+                  << std::setw(10) << "objects"
+                  << std::setw(8) << "threads"
+                  << std::setw(14) << "time [ms]"
+                  << std::setw(16) << "interactions/s"
+                  << std::setw(10) << "GFLOP/s"
+                  << std::setw(8) << "B/int"
+                  << std::endl;
+    }
+
+    void print(const Result& result)
+    {
+        std::cout << std::setw(12) << result.accelerator
+                  << std::setw(12) << result.operation
+                  << std::setw(10) << result.objects
+                  << std::setw(8) << result.threads;
+
+        if (result.skipped)
+            std::cout << std::setw(14) << "skipped";
+        else
+            std::cout << std::setw(14) << result.ms
+                      << std::setw(16) << result.interactions
+                      << std::setw(10) << result.gflops
+                      << std::setw(8) << result.bytesPerInteraction;
+
+        std::cout << std::endl;
+    }
+
+    void writeJson(std::ostream& stream, const std::vector<Result>& results)
+    {
+        const std::time_t now = std::time(nullptr);
+        char date[32];
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+        stream << "{\n";
+        stream << "  \"date\": \"" << date << "\",\n";
+        stream << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+        stream << "  \"base_type_size\": " << sizeof(BaseType) << ",\n";
+        stream << "  \"results\": [\n";
+
+        for(std::size_t i = 0; i < results.size(); i++)
+        {
+            const Result& r = results[i];
+
+            stream << "    { \"accelerator\": \"" << r.accelerator << "\""
+                   << ", \"operation\": \"" << r.operation << "\""
+                   << ", \"objects\": " << r.objects
+                   << ", \"threads\": " << r.threads;
+
+            if (r.skipped)
+                stream << ", \"skipped\": true }";
+            else
+                stream << ", \"time_ms\": " << r.ms
+                       << ", \"interactions_per_second\": " << r.interactions
+                       << ", \"gflops\": " << r.gflops
+                       << ", \"bytes_per_interaction\": " << r.bytesPerInteraction << " }";
+
+            stream << (i + 1 < results.size()? ",\n": "\n");
+        }
+
+        stream << "  ]\n";
+        stream << "}\n";
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    std::size_t maxObjects = 1000000;
+    int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    double minTime = 0.5;
+    double maxTime = 30.0;
+    std::string jsonPath;
+
+    for(int i = 1; i + 1 < argc; i += 2)
+    {
+        const char* option = argv[i];
+        const char* value = argv[i + 1];
+
+        if (strcmp(option, "--max-objects") == 0)
+            maxObjects = std::strtoul(value, nullptr, 10);
+        else if (strcmp(option, "--max-threads") == 0)
+            maxThreads = std::max(1, std::atoi(value));
+        else if (strcmp(option, "--min-time") == 0)
+            minTime = std::atof(value);
+        else if (strcmp(option, "--max-time") == 0)
+            maxTime = std::atof(value);
+        else if (strcmp(option, "--json") == 0)
+            jsonPath = value;
+        else
+        {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+
+    printHeader();
+
+    for(const Accelerator& accelerator: accelerators())
+        for(const int threads: threadCounts(maxThreads))
+        {
+            omp_set_num_threads(threads);
+
+            // ms per interaction of last measured system, used to predict time of bigger ones
+            std::map<std::string, double> cost;
+
+            for(const std::size_t count: objectCounts(maxObjects))
+            {
+                std::unique_ptr<IAccelerator> acc = accelerator.create();
+                SimulationEngine engine(acc.get(), count);
+                engine.addObjects(count, [count](Objects& objects, std::size_t first) { return fill(objects, first, count); });
+
+                // velocities() does not depend on values of forces
+                const std::vector<force_vector_t> forces(count);
+
+                for(const Operation& operation: operations)
+                {
+                    const double n = interactions(operation, count);
+
+                    Result result = { accelerator.name, operation.name, count, threads, 0.0, 0.0, 0.0, operation.bytes, false };
+
+                    const auto known = cost.find(operation.name);
+                    if (known != cost.end() && known->second * n > maxTime * 1000.0)
+                        result.skipped = true;
+                    else
+                    {
+                        if (strcmp(operation.name, "forces") == 0)
+                            result.ms = measure([&acc]{ acc->forces(); }, minTime);
+                        else if (strcmp(operation.name, "collisions") == 0)
+                            result.ms = measure([&acc]{ acc->collisions(); }, minTime);
+                        else if (strcmp(operation.name, "velocities") == 0)
+                            result.ms = measure([&acc, &forces]{ acc->velocities(forces, 60.0); }, minTime);
+                        else
+                            result.ms = measure([&engine]{ engine.step(); }, minTime);
+
+                        cost[operation.name] = result.ms / n;
+
+                        result.interactions = n / (result.ms / 1000.0);
+                        result.gflops = result.interactions * operation.flops / 1e9;
+                    }
+
+                    results.push_back(result);
+                    print(result);
+                }
+            }
+        }
+
+    if (jsonPath.empty() == false)
+    {
+        std::ofstream file(jsonPath, std::ios_base::out | std::ios_base::trunc);
+        writeJson(file, results);
+
+        if (file.fail())
+        {
+            std::cerr << "Could not open file " << jsonPath << " for writing" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+
+// Compares SoA (Objects) and AoSoA (ObjectsBlocks) layouts
+// by timing forces() and collisions() of AVX accelerators using them.
+//
+// usage: layouts_benchmark [max objects count]
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+#include "../objects.hpp"
+#include "../accelerators/avx_accelerator.hpp"
+#include "../accelerators/avx_blocks_accelerator.hpp"
+
+
+namespace
+{
+    BaseType fRand(BaseType fMin, BaseType fMax)
+    {
+        BaseType f = static_cast<BaseType>(rand()) / RAND_MAX;
+        return fMin + f * (fMax - fMin);
+    }
+
+    void fill(Objects& objects, std::size_t count)
+    {
+        srand(3);
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const BaseType x = fRand(-5000e6, 5000e6);
+            const BaseType y = fRand(-5000e6, 5000e6);
+
+            const BaseType v_x = fRand(-5e2, 5e2);
+            const BaseType v_y = fRand(-5e2, 5e2);
+
+            objects.insert( Object(x, y, 7.347673e22, 1737.1e3, v_x, v_y), i + 1 );
+        }
+    }
+
+    // run operation until at least one second passes, return average time of one run in ms
+    double measure(const std::function<void()>& operation)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        auto end = start;
+        int runs = 0;
+
+        do
+        {
+            operation();
+            runs++;
+
+            end = std::chrono::steady_clock::now();
+        }
+        while(end - start < std::chrono::seconds(1));
+
+        const std::chrono::duration<double, std::milli> diff = end - start;
+
+        return diff.count() / runs;
+    }
+
+    void benchmark(const char* layout, IAccelerator& accelerator, std::size_t count)
+    {
+        const double forces = measure([&accelerator]{ accelerator.forces(); });
+        const double collisions = measure([&accelerator]{ accelerator.collisions(); });
+
+        std::cout << std::setw(10) << count
+                  << std::setw(8) << layout
+                  << std::setw(16) << forces
+                  << std::setw(16) << collisions
+                  << std::endl;
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    const std::size_t max_count = argc > 1? std::strtoul(argv[1], nullptr, 10): 1000000;
+
+    std::cout << std::setw(10) << "objects"
+              << std::setw(8) << "layout"
+              << std::setw(16) << "forces [ms]"
+              << std::setw(16) << "collisions [ms]"
+              << std::endl;
+
+    for(std::size_t count = 1000; count <= max_count; count *= 10)
+    {
+        Objects objects;
+        fill(objects, count);
+
+        AVXAccelerator soa(&objects);
+        AVXBlocksAccelerator aosoa(&objects);
+
+        benchmark("SoA", soa, count);
+        benchmark("AoSoA", aosoa, count);
+    }
+
+    return 0;
+}
@@ -0,0 +1,262 @@
+/*
+ * Saving and restoring of simulation state
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "checkpoint.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "simulation_engine.hpp"
+
+
+namespace
+{
+    const char magic[8] = { 'G', 'R', 'A', 'V', 'C', 'H', 'K', '\0' };
+    const std::uint32_t columns_count = 7;
+
+    struct Header
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t entrySize;        // sizeof(BaseType)
+        std::uint32_t columns;
+        std::uint32_t reserved;
+        std::uint64_t objects;
+        std::uint64_t dataOffset;
+        std::uint64_t dataSize;
+        double dt;
+        std::int64_t nextId;
+        double time;                    // since version 2
+    };
+
+    static_assert(sizeof(Header) <= Checkpoint::Alignment, "Header must fit before data");
+
+
+    // Arena on private mapping of checkpoint file.
+    // Modifications are not written back to file.
+    // File cannot grow, so when more space is needed data goes to anonymous memory.
+    class CheckpointArena: public IObjectsArena
+    {
+        public:
+            CheckpointArena(char* mapping, std::size_t bytes):
+                m_mapping(mapping),
+                m_size(bytes),
+                m_memory()
+            {
+
+            }
+
+            CheckpointArena(const CheckpointArena &) = delete;
+
+            ~CheckpointArena()
+            {
+                if (m_mapping != nullptr)
+                    munmap(m_mapping, m_size);
+            }
+
+            CheckpointArena& operator=(const CheckpointArena &) = delete;
+
+            virtual char* data() override
+            {
+                return m_memory? m_memory->data(): m_mapping;
+            }
+
+            virtual std::size_t size() const override
+            {
+                return m_memory? m_memory->size(): m_size;
+            }
+
+            virtual void resize(std::size_t bytes) override
+            {
+                if (m_memory)
+                    m_memory->resize(bytes);
+                else
+                {
+                    m_memory = std::make_unique<MemoryArena>(bytes);
+                    std::memcpy(m_memory->data(), m_mapping, std::min(m_size, bytes));
+
+                    munmap(m_mapping, m_size);
+                    m_mapping = nullptr;
+                }
+            }
+
+        private:
+            char* m_mapping;
+            std::size_t m_size;                         // size of mapping
+            std::unique_ptr<MemoryArena> m_memory;
+    };
+
+
+    bool writeAll(int fd, const char* data, std::size_t bytes, off_t offset)
+    {
+        while (bytes > 0)
+        {
+            const ssize_t written = pwrite(fd, data, bytes, offset);
+
+            if (written < 0)
+                return false;
+
+            data += written;
+            bytes -= written;
+            offset += written;
+        }
+
+        return true;
+    }
+}
+
+
+bool Checkpoint::save(const SimulationEngine& engine, const std::string& path)
+{
+    const Objects& objects = engine.objects();              // downloads device resident objects
+    const std::size_t count = objects.size();
+
+    // columns in order used by Objects' arena
+    const char* columns[] =
+    {
+        reinterpret_cast<const char *>(objects.m_x.data()),
+        reinterpret_cast<const char *>(objects.m_y.data()),
+        reinterpret_cast<const char *>(objects.m_vx.data()),
+        reinterpret_cast<const char *>(objects.m_vy.data()),
+        reinterpret_cast<const char *>(objects.m_mass.data()),
+        reinterpret_cast<const char *>(objects.m_radius.data()),
+        reinterpret_cast<const char *>(objects.m_id.data()),
+    };
+
+    static_assert(sizeof(columns) / sizeof(columns[0]) == columns_count, "Unexpected number of columns");
+    const std::size_t columnSize = Objects::columnSize(count);
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = Version;
+    header.entrySize = sizeof(BaseType);
+    header.columns = columns_count;
+    header.objects = count;
+    header.dataOffset = Alignment;
+    header.dataSize = columns_count * columnSize;
+    header.dt = engine.m_dt;
+    header.nextId = engine.m_nextId;
+    header.time = engine.m_time;
+
+    const std::string tmpPath = path + ".tmp";
+    const int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd == -1)
+    {
+        std::cerr << "Could not open file " << tmpPath << " for writing" << std::endl;
+        return false;
+    }
+
+    // columns are padded to their size in arena, gaps are left as holes (read as zeros)
+    bool status = writeAll(fd, reinterpret_cast<const char *>(&header), sizeof(header), 0);
+
+    for(std::uint32_t c = 0; status && c < columns_count; c++)
+        status = writeAll(fd, columns[c], count * sizeof(BaseType), header.dataOffset + c * columnSize);
+
+    status = status &&
+             ftruncate(fd, header.dataOffset + header.dataSize) == 0 &&
+             fsync(fd) == 0;
+
+    status = close(fd) == 0 && status;
+    status = status && std::rename(tmpPath.c_str(), path.c_str()) == 0;
+
+    if (status == false)
+    {
+        std::cerr << "Could not write checkpoint " << path << ": " << std::strerror(errno) << std::endl;
+        unlink(tmpPath.c_str());
+    }
+
+    return status;
+}
+
+
+std::unique_ptr<SimulationEngine> Checkpoint::restore(const std::string& path, IAccelerator* accelerator)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd == -1)
+    {
+        std::cerr << "Could not open file " << path << " for reading" << std::endl;
+        return nullptr;
+    }
+
+    Header header;
+    struct stat fileInfo;
+
+    const bool valid = pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+                       fstat(fd, &fileInfo) == 0 &&
+                       std::memcmp(header.magic, magic, sizeof(magic)) == 0 &&
+                       (header.version == Version || header.version == 1) &&
+                       header.entrySize == sizeof(BaseType) &&
+                       header.columns == columns_count &&
+                       header.dataSize == header.columns * Objects::columnSize(header.objects) &&
+                       header.dataOffset % sysconf(_SC_PAGESIZE) == 0 &&
+                       header.dataOffset + header.dataSize <= static_cast<std::uint64_t>(fileInfo.st_size);
+
+    if (valid == false)
+    {
+        std::cerr << path << " is not a valid checkpoint" << std::endl;
+        close(fd);
+
+        return nullptr;
+    }
+
+    std::unique_ptr<IObjectsArena> arena;
+
+    if (header.dataSize == 0)
+        arena = std::make_unique<MemoryArena>(0);
+    else
+    {
+        void* mapping = mmap(nullptr, header.dataSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, header.dataOffset);
+
+        if (mapping == MAP_FAILED)
+        {
+            std::cerr << "Could not map checkpoint " << path << ": " << std::strerror(errno) << std::endl;
+            close(fd);
+
+            return nullptr;
+        }
+
+        // start reading data in background, accelerators will touch all of it anyway
+        madvise(mapping, header.dataSize, MADV_WILLNEED);
+
+        arena = std::make_unique<CheckpointArena>(static_cast<char *>(mapping), header.dataSize);
+    }
+
+    close(fd);                  // mapping keeps file open
+
+    std::unique_ptr<SimulationEngine> engine = std::make_unique<SimulationEngine>(accelerator, std::move(arena), header.objects);
+
+    engine->m_objects.m_size = header.objects;
+    engine->m_dt = header.dt;
+    engine->m_nextId = header.nextId;
+    engine->m_time = header.version >= 2? header.time: 0.0;      // version 1 has no time (data starts after header anyway)
+
+    return engine;
+}
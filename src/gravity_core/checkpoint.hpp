@@ -0,0 +1,54 @@
+/*
+ * Saving and restoring of simulation state
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <memory>
+#include <string>
+
+class SimulationEngine;
+struct IAccelerator;
+
+
+// Binary snapshot of SimulationEngine (objects + engine's state).
+//
+// File layout (native byte order):
+//   header     - magic, format version, objects count, engine's state, offset of data
+//   data       - image of Objects' arena for capacity = objects count,
+//                starts at 'Alignment' boundary so it can be mapped directly into memory
+//
+// Restored engine works on a private (copy on write) mapping of the file,
+// so loading does not depend on number of objects.
+// Data is copied to regular memory when engine needs to grow.
+class Checkpoint
+{
+    public:
+        static const unsigned int Version = 2;             // 2: simulated time (version 1 files are restored with time = 0)
+        static const std::size_t Alignment = 64 * 1024;     // covers page sizes of all common platforms
+
+        // File is written to temporary location first, and renamed when complete.
+        // So there always is a valid checkpoint, even if process dies during save.
+        static bool save(const SimulationEngine &, const std::string& path);
+
+        // returns nullptr on error
+        static std::unique_ptr<SimulationEngine> restore(const std::string& path, IAccelerator *);
+};
+
+#endif // CHECKPOINT_HPP
@@ -0,0 +1,247 @@
+/*
+ * Runner for many independent simulations
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ensemble.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <omp.h>
+
+#include "accelerators/iaccelerator.hpp"
+#include "simulation_engine.hpp"
+
+
+namespace
+{
+    // Queue of simulations (indices) to be run.
+    // Owner takes items from front, other threads steal from back.
+    class WorkQueue
+    {
+        public:
+            WorkQueue(): m_items(), m_mutex() {}
+
+            void push(std::size_t item)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_items.push_back(item);
+            }
+
+            bool pop(std::size_t& item)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                if (m_items.empty())
+                    return false;
+
+                item = m_items.front();
+                m_items.pop_front();
+
+                return true;
+            }
+
+            bool steal(std::size_t& item)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                if (m_items.empty())
+                    return false;
+
+                item = m_items.back();
+                m_items.pop_back();
+
+                return true;
+            }
+
+        private:
+            std::deque<std::size_t> m_items;
+            std::mutex m_mutex;
+    };
+
+
+    // Results collected by one thread. Object columns are filled in order of simulations run.
+    struct WorkerResults
+    {
+        struct Entry
+        {
+            std::size_t simulation;
+            std::size_t first;
+            std::size_t count;
+            int steps;
+        };
+
+        std::vector<Entry> entries;
+        EnsembleResults data;
+    };
+
+
+    template<typename T, typename C>
+    void append(std::vector<T>& to, const C& from)
+    {
+        to.insert(to.end(), from.begin(), from.end());
+    }
+}
+
+
+std::size_t EnsembleResults::simulations() const
+{
+    return steps.size();
+}
+
+
+Ensemble::Ensemble(const AcceleratorFactory& factory):
+    m_acceleratorFactory(factory),
+    m_simulations()
+{
+
+}
+
+
+Ensemble::~Ensemble()
+{
+
+}
+
+
+std::size_t Ensemble::addSimulation(const std::vector<Object>& objects, double duration)
+{
+    m_simulations.push_back( Simulation{objects, duration} );
+
+    return m_simulations.size() - 1;
+}
+
+
+std::size_t Ensemble::size() const
+{
+    return m_simulations.size();
+}
+
+
+EnsembleResults Ensemble::run(unsigned int threads)
+{
+    if (threads == 0)
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    const std::size_t simulations = m_simulations.size();
+
+    // initial split: continuous ranges of simulations for each thread
+    std::vector<WorkQueue> queues(threads);
+    for(unsigned int t = 0; t < threads; t++)
+        for(std::size_t s = t * simulations / threads; s < (t + 1) * simulations / threads; s++)
+            queues[t].push(s);
+
+    std::vector<WorkerResults> workerResults(threads);
+
+    auto runSimulation = [this](std::size_t s, WorkerResults& results)
+    {
+        const Simulation& simulation = m_simulations[s];
+
+        std::unique_ptr<IAccelerator> accelerator = m_acceleratorFactory();
+        SimulationEngine engine(accelerator.get(), simulation.objects.size());
+
+        for(const Object& obj: simulation.objects)
+            engine.addObject(obj);
+
+        const int steps = engine.stepBy(simulation.duration);
+
+        const Objects& objects = engine.objects();
+        EnsembleResults& data = results.data;
+
+        results.entries.push_back( WorkerResults::Entry{s, data.id.size(), objects.size(), steps} );
+
+        append(data.id, objects.getId());
+        append(data.x, objects.getX());
+        append(data.y, objects.getY());
+        append(data.vx, objects.getVX());
+        append(data.vy, objects.getVY());
+        append(data.mass, objects.getMass());
+        append(data.radius, objects.getRadius());
+    };
+
+    auto worker = [&queues, &workerResults, &runSimulation, threads](unsigned int me)
+    {
+        // simulations are run in parallel, do not let accelerators spawn more threads
+        omp_set_num_threads(1);
+
+        for(;;)
+        {
+            std::size_t s = 0;
+            bool found = queues[me].pop(s);
+
+            for(unsigned int v = 1; found == false && v < threads; v++)
+                found = queues[(me + v) % threads].steal(s);
+
+            // no work is produced during run, so when all queues are empty we are done
+            if (found == false)
+                break;
+
+            runSimulation(s, workerResults[me]);
+        }
+    };
+
+    // caller's thread is not used as a worker: omp_set_num_threads() would stay in effect for it
+    std::vector<std::thread> workers;
+    for(unsigned int t = 0; t < threads; t++)
+        workers.emplace_back(worker, t);
+
+    for(std::thread& w: workers)
+        w.join();
+
+    // gather results in simulations' order
+    std::vector<const WorkerResults::Entry *> entries(simulations, nullptr);
+    std::vector<const EnsembleResults *> sources(simulations, nullptr);
+
+    for(const WorkerResults& results: workerResults)
+        for(const WorkerResults::Entry& entry: results.entries)
+        {
+            entries[entry.simulation] = &entry;
+            sources[entry.simulation] = &results.data;
+        }
+
+    EnsembleResults result;
+    result.offsets.reserve(simulations + 1);
+    result.steps.reserve(simulations);
+    result.offsets.push_back(0);
+
+    for(std::size_t s = 0; s < simulations; s++)
+    {
+        const WorkerResults::Entry* entry = entries[s];
+        const EnsembleResults* source = sources[s];
+        assert(entry != nullptr);
+
+        const auto first = entry->first;
+        const auto last = entry->first + entry->count;
+
+        result.offsets.push_back(result.offsets.back() + entry->count);
+        result.steps.push_back(entry->steps);
+
+        result.id.insert(result.id.end(), source->id.begin() + first, source->id.begin() + last);
+        result.x.insert(result.x.end(), source->x.begin() + first, source->x.begin() + last);
+        result.y.insert(result.y.end(), source->y.begin() + first, source->y.begin() + last);
+        result.vx.insert(result.vx.end(), source->vx.begin() + first, source->vx.begin() + last);
+        result.vy.insert(result.vy.end(), source->vy.begin() + first, source->vy.begin() + last);
+        result.mass.insert(result.mass.end(), source->mass.begin() + first, source->mass.begin() + last);
+        result.radius.insert(result.radius.end(), source->radius.begin() + first, source->radius.begin() + last);
+    }
+
+    return result;
+}
@@ -0,0 +1,84 @@
+/*
+ * Runner for many independent simulations
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef ENSEMBLE_HPP
+#define ENSEMBLE_HPP
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "object.hpp"
+
+struct IAccelerator;
+
+
+// Final state of all simulations of ensemble, in columns.
+// Objects of simulation 's' occupy range [offsets[s], offsets[s + 1]) of each object column.
+struct EnsembleResults
+{
+    // per simulation data
+    std::vector<std::size_t> offsets;
+    std::vector<int> steps;
+
+    // per object data
+    std::vector<int> id;
+    std::vector<BaseType> x;
+    std::vector<BaseType> y;
+    std::vector<BaseType> vx;
+    std::vector<BaseType> vy;
+    std::vector<BaseType> mass;
+    std::vector<BaseType> radius;
+
+    std::size_t simulations() const;
+};
+
+
+// Runs many small, independent simulations.
+// Small systems do not benefit from parallel pair loops, so instead
+// whole simulations are distributed between threads (each accelerator is limited to one thread).
+// Each thread has own queue of simulations to run, when it gets empty thread steals work from others.
+class Ensemble
+{
+    public:
+        typedef std::function<std::unique_ptr<IAccelerator>()> AcceleratorFactory;
+
+        Ensemble(const AcceleratorFactory &);
+        Ensemble(const Ensemble &) = delete;
+        ~Ensemble();
+
+        Ensemble& operator=(const Ensemble &) = delete;
+
+        std::size_t addSimulation(const std::vector<Object> &, double duration);    // returns simulation index
+        std::size_t size() const;
+
+        EnsembleResults run(unsigned int threads = 0);                              // 0 = use all cores
+
+    private:
+        struct Simulation
+        {
+            std::vector<Object> objects;
+            double duration;
+        };
+
+        AcceleratorFactory m_acceleratorFactory;
+        std::vector<Simulation> m_simulations;
+};
+
+#endif // ENSEMBLE_HPP
@@ -0,0 +1,210 @@
+/*
+ * Performance counters of simulation engine
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+RollingHistogram::RollingHistogram(std::size_t window):
+    m_samples(std::max<std::size_t>(window, 1), 0.0),
+    m_buckets(),
+    m_next(0),
+    m_count(0),
+    m_sum(0.0),
+    m_last(0.0)
+{
+    m_buckets.fill(0);
+}
+
+
+void RollingHistogram::add(double value)
+{
+    // drop oldest sample when window is full
+    if (m_count == m_samples.size())
+    {
+        const double oldest = m_samples[m_next];
+
+        m_buckets[bucket(oldest)]--;
+        m_sum -= oldest;
+    }
+    else
+        m_count++;
+
+    m_samples[m_next] = value;
+    m_next = (m_next + 1) % m_samples.size();
+
+    m_buckets[bucket(value)]++;
+    m_sum += value;
+    m_last = value;
+}
+
+
+void RollingHistogram::clear()
+{
+    m_buckets.fill(0);
+    m_next = 0;
+    m_count = 0;
+    m_sum = 0.0;
+    m_last = 0.0;
+}
+
+
+RollingHistogram::Summary RollingHistogram::summary() const
+{
+    Summary result;
+
+    if (m_count > 0)
+    {
+        const std::size_t first = (m_next + m_samples.size() - m_count) % m_samples.size();
+        double max = 0.0;
+
+        for(std::size_t i = 0; i < m_count; i++)
+            max = std::max(max, m_samples[(first + i) % m_samples.size()]);
+
+        result.samples = m_count;
+        result.last = m_last;
+        result.mean = m_sum / m_count;
+        result.p50 = std::min(percentile(0.5), max);
+        result.p95 = std::min(percentile(0.95), max);
+        result.max = max;
+    }
+
+    return result;
+}
+
+
+const std::array<std::size_t, RollingHistogram::Buckets>& RollingHistogram::buckets() const
+{
+    return m_buckets;
+}
+
+
+int RollingHistogram::bucket(double value)
+{
+    if (value < 1.0)
+        return 0;
+
+    int exponent = 0;
+    std::frexp(value, &exponent);           // value = m * 2^exponent, m in [0.5, 1)
+
+    return std::min(exponent, Buckets - 1);
+}
+
+
+double RollingHistogram::upperBound(int bucket)
+{
+    return std::ldexp(1.0, bucket);
+}
+
+
+double RollingHistogram::percentile(double p) const
+{
+    assert(m_count > 0);
+
+    const std::size_t rank = static_cast<std::size_t>(std::ceil(p * m_count));
+    std::size_t seen = 0;
+
+    for(int b = 0; b < Buckets; b++)
+    {
+        seen += m_buckets[b];
+
+        if (seen >= rank)
+            return upperBound(b);
+    }
+
+    return upperBound(Buckets - 1);
+}
+
+
+Instrumentation::Instrumentation(std::size_t window):
+    m_enabled(false),
+    m_mutex(),
+    m_histograms(MetricsCount, RollingHistogram(window))
+{
+
+}
+
+
+Instrumentation::~Instrumentation()
+{
+
+}
+
+
+void Instrumentation::setEnabled(bool enabled)
+{
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+
+void Instrumentation::record(Metric metric, double value)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_histograms[metric].add(value);
+}
+
+
+void Instrumentation::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for(RollingHistogram& histogram: m_histograms)
+        histogram.clear();
+}
+
+
+RollingHistogram::Summary Instrumentation::summary(Metric metric) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_histograms[metric].summary();
+}
+
+
+Instrumentation::Snapshot Instrumentation::snapshot() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Snapshot result;
+    for(int m = 0; m < MetricsCount; m++)
+        result[m] = m_histograms[m].summary();
+
+    return result;
+}
+
+
+const char* Instrumentation::name(Metric metric)
+{
+    switch(metric)
+    {
+        case Forces:                return "forces";
+        case Integration:           return "integration";
+        case Retries:               return "dt retries";
+        case CollisionDetection:    return "collisions";
+        case CollisionResolution:   return "merging";
+        case Observers:             return "observers";
+        case TransferOverlap:       return "transfer overlap [%]";
+        case Step:                  return "step";
+        case MetricsCount:          break;
+    }
+
+    return "";
+}
@@ -0,0 +1,149 @@
+/*
+ * Performance counters of simulation engine
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef INSTRUMENTATION_HPP
+#define INSTRUMENTATION_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+
+// Rolling histogram of last 'window' samples.
+// Buckets are logarithmic: bucket 0 is [0, 1), bucket b is [2^(b-1), 2^b).
+class RollingHistogram
+{
+    public:
+        static const int Buckets = 32;
+
+        struct Summary
+        {
+            std::size_t samples = 0;            // in window
+            double last = 0.0;
+            double mean = 0.0;
+            double p50 = 0.0;                   // percentiles are estimated from buckets (upper bound of bucket)
+            double p95 = 0.0;
+            double max = 0.0;
+        };
+
+        explicit RollingHistogram(std::size_t window);
+
+        void add(double);
+        void clear();
+
+        Summary summary() const;
+        const std::array<std::size_t, Buckets>& buckets() const;
+
+        static int bucket(double);
+        static double upperBound(int bucket);
+
+    private:
+        std::vector<double> m_samples;          // ring
+        std::array<std::size_t, Buckets> m_buckets;
+        std::size_t m_next;
+        std::size_t m_count;
+        double m_sum;
+        double m_last;
+
+        double percentile(double) const;
+};
+
+
+// Per phase timing of SimulationEngine::step().
+// Disabled by default: then Scope does not even read the clock.
+// Times are recorded in microseconds. Thread safe: engine may record while other thread reads.
+class Instrumentation
+{
+    public:
+        enum Metric
+        {
+            Forces,                 // IAccelerator::forces()
+            Integration,            // velocities and positions, including dt adjustment retries
+            Retries,                // number of dt adjustments in step (not time)
+            CollisionDetection,     // IAccelerator::collisions()
+            CollisionResolution,    // merging collided objects
+            Observers,              // dispatch of events to observers
+            TransferOverlap,        // % of host <-> device transfers hidden behind computations (not time, pipelined accelerators only)
+            Step,                   // whole step()
+
+            MetricsCount,
+        };
+
+        typedef std::array<RollingHistogram::Summary, MetricsCount> Snapshot;
+
+        // measures time of scope
+        class Scope
+        {
+            public:
+                Scope(Instrumentation& instrumentation, Metric metric):
+                    m_instrumentation(instrumentation.enabled()? &instrumentation: nullptr),
+                    m_metric(metric),
+                    m_start()
+                {
+                    if (m_instrumentation != nullptr)
+                        m_start = std::chrono::steady_clock::now();
+                }
+
+                Scope(const Scope &) = delete;
+                Scope& operator=(const Scope &) = delete;
+
+                ~Scope()
+                {
+                    if (m_instrumentation != nullptr)
+                    {
+                        const std::chrono::duration<double, std::micro> duration = std::chrono::steady_clock::now() - m_start;
+                        m_instrumentation->record(m_metric, duration.count());
+                    }
+                }
+
+            private:
+                Instrumentation* const m_instrumentation;
+                const Metric m_metric;
+                std::chrono::steady_clock::time_point m_start;
+        };
+
+        explicit Instrumentation(std::size_t window = 256);
+        Instrumentation(const Instrumentation &) = delete;
+        ~Instrumentation();
+
+        Instrumentation& operator=(const Instrumentation &) = delete;
+
+        void setEnabled(bool);
+        bool enabled() const
+        {
+            return m_enabled.load(std::memory_order_relaxed);
+        }
+
+        void record(Metric, double value);
+        void clear();
+
+        RollingHistogram::Summary summary(Metric) const;
+        Snapshot snapshot() const;
+
+        static const char* name(Metric);
+
+    private:
+        std::atomic<bool> m_enabled;
+        mutable std::mutex m_mutex;
+        std::vector<RollingHistogram> m_histograms;
+};
+
+#endif // INSTRUMENTATION_HPP
@@ -20,6 +20,8 @@
 #ifndef OBJECT_HPP
 #define OBJECT_HPP
 
+#include <cstddef>
+
 #include "types.hpp"
 
 
@@ -156,6 +158,7 @@ class Object
         Object(BaseType x, BaseType y, BaseType m, BaseType r, BaseType v_x, BaseType v_y, int id);
 
         friend class Objects;
+        template<std::size_t> friend class ObjectsBlocks;
 
     public:
         Object(BaseType x, BaseType y, BaseType m, BaseType r, BaseType v_x = 0.0, BaseType v_y = 0.0);
@@ -20,13 +20,48 @@
 
 #include "objects.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
 
-#define INITIAL_SIZE 10000
+namespace
+{
+    // order of columns in arena
+    enum Columns
+    {
+        X,
+        Y,
+        VX,
+        VY,
+        Mass,
+        Radius,
+        Id,
+
+        ColumnsCount,
+    };
+
+    static_assert(sizeof(BaseType) == sizeof(int), "All columns are expected to have the same entry size");
+}
+
+
+Objects::Objects(): Objects(DefaultCapacity)
+{
+
+}
 
 
-Objects::Objects():
+Objects::Objects(std::size_t capacity, int hints):
+    Objects(createArena(capacity, hints), capacity)
+{
+
+}
+
+
+Objects::Objects(std::unique_ptr<IObjectsArena> arena, std::size_t capacity):
+    m_arena(std::move(arena)),
+    m_capacity(capacity),
+    m_size(0),
     m_x(),
     m_y(),
     m_vx(),
@@ -35,13 +70,10 @@ Objects::Objects():
     m_radius(),
     m_id()
 {
-    m_x.reserve(INITIAL_SIZE);
-    m_y.reserve(INITIAL_SIZE);
-    m_vx.reserve(INITIAL_SIZE);
-    m_vy.reserve(INITIAL_SIZE);
-    m_mass.reserve(INITIAL_SIZE);
-    m_radius.reserve(INITIAL_SIZE);
-    m_id.reserve(INITIAL_SIZE);
+    if (m_arena->size() < ColumnsCount * columnSize(m_capacity))
+        m_arena->resize(ColumnsCount * columnSize(m_capacity));
+
+    updateColumns();
 }
 
 
@@ -61,28 +93,59 @@ Object Objects::operator[](std::size_t idx) const
 
 std::size_t Objects::size() const
 {
-    return m_id.size();
+    return m_size;
+}
+
+
+std::size_t Objects::capacity() const
+{
+    return m_capacity;
+}
+
+
+void Objects::reserve(std::size_t capacity)
+{
+    if (capacity > m_capacity)
+        grow(capacity);
+}
+
+
+void Objects::resize(std::size_t size)
+{
+    if (size > m_capacity)
+        grow(std::max(size, m_capacity * 2));
+
+    if (size > m_size)
+    {
+        const std::size_t bytes = (size - m_size) * sizeof(BaseType);
+
+        std::memset(m_x.data() + m_size, 0, bytes);
+        std::memset(m_y.data() + m_size, 0, bytes);
+        std::memset(m_vx.data() + m_size, 0, bytes);
+        std::memset(m_vy.data() + m_size, 0, bytes);
+        std::memset(m_mass.data() + m_size, 0, bytes);
+        std::memset(m_radius.data() + m_size, 0, bytes);
+        std::memset(m_id.data() + m_size, 0, bytes);
+    }
+
+    m_size = size;
 }
 
 
 std::size_t Objects::insert(const Object& obj, std::size_t id)
 {
-    const std::size_t idx = m_id.size();
+    if (m_size == m_capacity)
+        grow(std::max<std::size_t>(m_capacity * 2, 16));
 
-    m_x.push_back(obj.pos().x);
-    m_y.push_back(obj.pos().y);
-    m_vx.push_back(obj.velocity().x.raw_value());
-    m_vy.push_back(obj.velocity().y.raw_value());
-    m_mass.push_back(obj.mass().raw_value());
-    m_radius.push_back(obj.radius());
-    m_id.push_back(id);
+    const std::size_t idx = m_size++;
 
-    assert(m_x.size() == m_id.size());
-    assert(m_y.size() == m_id.size());
-    assert(m_vx.size() == m_id.size());
-    assert(m_vy.size() == m_id.size());
-    assert(m_mass.size() == m_id.size());
-    assert(m_radius.size() == m_id.size());
+    m_x[idx]      = obj.pos().x;
+    m_y[idx]      = obj.pos().y;
+    m_vx[idx]     = obj.velocity().x.raw_value();
+    m_vy[idx]     = obj.velocity().y.raw_value();
+    m_mass[idx]   = obj.mass().raw_value();
+    m_radius[idx] = obj.radius();
+    m_id[idx]     = id;
 
     return idx;
 }
@@ -90,6 +153,8 @@ std::size_t Objects::insert(const Object& obj, std::size_t id)
 
 void Objects::erase(std::size_t idx)
 {
+    assert(idx < m_size);
+
     const std::size_t last = size() - 1;
 
     m_x[idx]      = m_x[last];
@@ -100,20 +165,7 @@ void Objects::erase(std::size_t idx)
     m_radius[idx] = m_radius[last];
     m_id[idx]     = m_id[last];
 
-    m_x.pop_back();
-    m_y.pop_back();
-    m_vx.pop_back();
-    m_vy.pop_back();
-    m_mass.pop_back();
-    m_radius.pop_back();
-    m_id.pop_back();
-
-    assert(m_x.size() == m_id.size());
-    assert(m_y.size() == m_id.size());
-    assert(m_vx.size() == m_id.size());
-    assert(m_vy.size() == m_id.size());
-    assert(m_mass.size() == m_id.size());
-    assert(m_radius.size() == m_id.size());
+    m_size--;
 }
 
 
@@ -229,13 +281,63 @@ Objects::DataVector& Objects::getRadius()
 }
 
 
-const std::vector<int>& Objects::getId() const
+const Objects::IdVector& Objects::getId() const
 {
     return m_id;
 }
 
 
-std::vector<int>& Objects::getId()
+Objects::IdVector& Objects::getId()
 {
     return m_id;
 }
+
+
+std::unique_ptr<IObjectsArena> Objects::createArena(std::size_t capacity, int hints)
+{
+    return std::make_unique<MemoryArena>(ColumnsCount * columnSize(capacity), hints);
+}
+
+
+std::size_t Objects::columnSize(std::size_t capacity)
+{
+    // keep each column aligned to 64 bytes (cache line, AVX-512 register)
+    const std::size_t bytes = capacity * sizeof(BaseType);
+
+    return (bytes + 63) & (-64);
+}
+
+
+void Objects::grow(std::size_t capacity)
+{
+    assert(capacity > m_capacity);
+
+    const std::size_t oldColumnSize = columnSize(m_capacity);
+    const std::size_t newColumnSize = columnSize(capacity);
+
+    m_arena->resize(ColumnsCount * newColumnSize);
+
+    // Move columns to their new places. Start from the last one, as new places are farther than old ones.
+    char* data = m_arena->data();
+    for(int c = ColumnsCount - 1; c > 0; c--)
+        std::memmove(data + c * newColumnSize, data + c * oldColumnSize, m_size * sizeof(BaseType));
+
+    m_capacity = capacity;
+
+    updateColumns();
+}
+
+
+void Objects::updateColumns()
+{
+    char* data = m_arena->data();
+    const std::size_t column = columnSize(m_capacity);
+
+    m_x      = DataVector(reinterpret_cast<BaseType *>(data + X * column), &m_size);
+    m_y      = DataVector(reinterpret_cast<BaseType *>(data + Y * column), &m_size);
+    m_vx     = DataVector(reinterpret_cast<BaseType *>(data + VX * column), &m_size);
+    m_vy     = DataVector(reinterpret_cast<BaseType *>(data + VY * column), &m_size);
+    m_mass   = DataVector(reinterpret_cast<BaseType *>(data + Mass * column), &m_size);
+    m_radius = DataVector(reinterpret_cast<BaseType *>(data + Radius * column), &m_size);
+    m_id     = IdVector(reinterpret_cast<int *>(data + Id * column), &m_size);
+}
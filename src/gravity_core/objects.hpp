@@ -22,9 +22,11 @@
 
 #include <cstdlib>
 #include <limits>
+#include <memory>
 #include <vector>
 
 #include "object.hpp"
+#include "objects_arena.hpp"
 #include "types.hpp"
 
 class Objects
@@ -84,16 +86,54 @@ class Objects
                 }
         };
 
-        typedef std::vector<BaseType, AlignmentAllocator<BaseType, 64>> DataVector;
+        // view on one column of data kept in arena
+        template<typename T>
+        class Column
+        {
+            public:
+                Column(): m_data(nullptr), m_size(nullptr) {}
+                Column(T* data, const std::size_t* size): m_data(data), m_size(size) {}
+
+                T& operator[](std::size_t idx) { return m_data[idx]; }
+                const T& operator[](std::size_t idx) const { return m_data[idx]; }
+
+                T* data() { return m_data; }
+                const T* data() const { return m_data; }
+
+                std::size_t size() const { return *m_size; }
+                bool empty() const { return *m_size == 0; }
+
+                T* begin() { return m_data; }
+                T* end() { return m_data + *m_size; }
+                const T* begin() const { return m_data; }
+                const T* end() const { return m_data + *m_size; }
+
+            private:
+                T* m_data;
+                const std::size_t* m_size;
+        };
+
+        typedef Column<BaseType> DataVector;
+        typedef Column<int> IdVector;
+
+        static const std::size_t DefaultCapacity = 10000;
 
         Objects();
+        Objects(std::size_t capacity, int hints = MemoryArena::NoHints);        // hints: see MemoryArena::Hints
+        Objects(std::unique_ptr<IObjectsArena>, std::size_t capacity);         // use custom arena
         Objects(const Objects &) = delete;
         ~Objects();
 
         Objects& operator=(const Objects &) = delete;
+
+        static std::unique_ptr<IObjectsArena> createArena(std::size_t capacity, int hints = MemoryArena::NoHints);  // MemoryArena for 'capacity' objects
+
         Object operator[](std::size_t idx) const;              // returns Object for given index (index ≠ Object::id)
 
         std::size_t size() const;
+        std::size_t capacity() const;
+        void reserve(std::size_t);
+        void resize(std::size_t);                              // new entries are zeroed (for bulk filling of columns)
 
         std::size_t insert(const Object &, std::size_t id);    // returns Object's index. Index is valid until next modification of Objects
         void erase(std::size_t idx);                           // erase item at index 'idx'. Last item will overwrite 'idx' and list will shrink
@@ -127,10 +167,17 @@ class Objects
         const DataVector& getRadius() const;
         DataVector& getRadius();
 
-        const std::vector<int>& getId() const;
-        std::vector<int>& getId();
+        const IdVector& getId() const;
+        IdVector& getId();
 
     private:
+        friend class Checkpoint;
+
+        // All columns are kept in one arena, one after another.
+        // Each column occupies space for 'm_capacity' entries (rounded up to cache line).
+        std::unique_ptr<IObjectsArena> m_arena;
+        std::size_t m_capacity;
+        std::size_t m_size;
 
         // objects data
 
@@ -140,7 +187,11 @@ class Objects
         DataVector m_vy;
         DataVector m_mass;
         DataVector m_radius;
-        std::vector<int> m_id;
+        IdVector m_id;
+
+        static std::size_t columnSize(std::size_t capacity);
+        void grow(std::size_t capacity);
+        void updateColumns();
 };
 
 #endif // OBJECTS_HPP
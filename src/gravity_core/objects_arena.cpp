@@ -0,0 +1,226 @@
+/*
+ * Memory for Objects' data
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "objects_arena.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+namespace
+{
+    const std::size_t huge_page_size = 2 * 1024 * 1024;
+
+    char* map(std::size_t bytes)
+    {
+        void* mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (mem == MAP_FAILED)
+            throw std::bad_alloc();
+
+        return static_cast<char *>(mem);
+    }
+
+    std::size_t roundToPages(std::size_t bytes, int hints)
+    {
+        // round up to page size (huge one if requested), mapping cannot be empty
+        const std::size_t page = (hints & IObjectsArena::HugePages)? huge_page_size: sysconf(_SC_PAGESIZE);
+        const std::size_t pages = (bytes + page - 1) / page;
+
+        return std::max<std::size_t>(pages, 1) * page;
+    }
+
+    void advise(char* data, std::size_t bytes, int hints)
+    {
+#ifdef MADV_HUGEPAGE
+        if (hints & IObjectsArena::HugePages)
+            madvise(data, bytes, MADV_HUGEPAGE);
+#endif
+
+        if (hints & IObjectsArena::Sequential)
+            madvise(data, bytes, MADV_SEQUENTIAL);
+    }
+}
+
+
+MemoryArena::MemoryArena(std::size_t bytes, int hints):
+    m_data(nullptr),
+    m_size(bytes),
+    m_mapped(0),
+    m_hints(hints)
+{
+    m_mapped = mappingSize(bytes);
+    m_data = map(m_mapped);
+
+    advise(m_data, m_mapped, m_hints);
+}
+
+
+MemoryArena::~MemoryArena()
+{
+    munmap(m_data, m_mapped);
+}
+
+
+char* MemoryArena::data()
+{
+    return m_data;
+}
+
+
+std::size_t MemoryArena::size() const
+{
+    return m_size;
+}
+
+
+void MemoryArena::resize(std::size_t bytes)
+{
+    const std::size_t mapped = mappingSize(bytes);
+
+    if (mapped != m_mapped)
+    {
+#ifdef MREMAP_MAYMOVE
+        void* mem = mremap(m_data, m_mapped, mapped, MREMAP_MAYMOVE);
+
+        if (mem == MAP_FAILED)
+            throw std::bad_alloc();
+
+        m_data = static_cast<char *>(mem);
+#else
+        char* mem = map(mapped);
+        std::memcpy(mem, m_data, std::min(m_size, bytes));
+        munmap(m_data, m_mapped);
+
+        m_data = mem;
+#endif
+        m_mapped = mapped;
+
+        advise(m_data, m_mapped, m_hints);
+    }
+
+    m_size = bytes;
+}
+
+
+std::size_t MemoryArena::mappingSize(std::size_t bytes) const
+{
+    return roundToPages(bytes, m_hints);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+
+
+MappedFileArena::MappedFileArena(const std::string& path, std::size_t bytes, int hints):
+    m_data(nullptr),
+    m_size(bytes),
+    m_mapped(0),
+    m_file(-1),
+    m_hints(hints & ~HugePages)         // huge pages are not available for regular files
+{
+    m_file = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+
+    if (m_file == -1)
+        throw std::system_error(errno, std::generic_category(), "Could not create " + path);
+
+    unlink(path.c_str());
+
+    m_mapped = mappingSize(bytes);
+
+    void* mem = MAP_FAILED;
+
+    if (ftruncate(m_file, m_mapped) == 0)
+        mem = mmap(nullptr, m_mapped, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+
+    if (mem == MAP_FAILED)
+    {
+        close(m_file);
+        throw std::bad_alloc();
+    }
+
+    m_data = static_cast<char *>(mem);
+
+    advise(m_data, m_mapped, m_hints);
+}
+
+
+MappedFileArena::~MappedFileArena()
+{
+    munmap(m_data, m_mapped);
+    close(m_file);
+}
+
+
+char* MappedFileArena::data()
+{
+    return m_data;
+}
+
+
+std::size_t MappedFileArena::size() const
+{
+    return m_size;
+}
+
+
+void MappedFileArena::resize(std::size_t bytes)
+{
+    const std::size_t mapped = mappingSize(bytes);
+
+    if (mapped != m_mapped)
+    {
+        // grow file before mapping it, shrink it after
+        if (mapped > m_mapped && ftruncate(m_file, mapped) != 0)
+            throw std::bad_alloc();
+
+#ifdef MREMAP_MAYMOVE
+        void* mem = mremap(m_data, m_mapped, mapped, MREMAP_MAYMOVE);
+#else
+        munmap(m_data, m_mapped);
+        void* mem = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+#endif
+
+        if (mem == MAP_FAILED)
+            throw std::bad_alloc();
+
+        if (mapped < m_mapped)
+            ftruncate(m_file, mapped);
+
+        m_data = static_cast<char *>(mem);
+        m_mapped = mapped;
+
+        advise(m_data, m_mapped, m_hints);
+    }
+
+    m_size = bytes;
+}
+
+
+std::size_t MappedFileArena::mappingSize(std::size_t bytes) const
+{
+    return roundToPages(bytes, m_hints);
+}
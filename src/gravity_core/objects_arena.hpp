@@ -0,0 +1,100 @@
+/*
+ * Memory for Objects' data
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OBJECTSARENA_HPP
+#define OBJECTSARENA_HPP
+
+#include <cstddef>
+#include <string>
+
+
+// Single block of memory for all Objects' columns.
+struct IObjectsArena
+{
+    // hints for kernel how memory is going to be used
+    enum Hints
+    {
+        NoHints    = 0,
+        HugePages  = 1,         // ask kernel for transparent huge pages (less TLB misses for big arenas)
+        Sequential = 2,         // data will be accessed sequentially (aggressive read ahead)
+    };
+
+    virtual ~IObjectsArena() = default;
+
+    virtual char* data() = 0;
+    virtual std::size_t size() const = 0;                  // size in bytes
+
+    virtual void resize(std::size_t bytes) = 0;            // works as realloc: content is kept, data() may change
+};
+
+
+// Arena in anonymous memory.
+class MemoryArena: public IObjectsArena
+{
+    public:
+        MemoryArena(std::size_t bytes, int hints = NoHints);
+        MemoryArena(const MemoryArena &) = delete;
+        ~MemoryArena();
+
+        MemoryArena& operator=(const MemoryArena &) = delete;
+
+        virtual char* data() override;
+        virtual std::size_t size() const override;
+
+        virtual void resize(std::size_t bytes) override;
+
+    private:
+        char* m_data;
+        std::size_t m_size;
+        std::size_t m_mapped;
+        int m_hints;
+
+        std::size_t mappingSize(std::size_t) const;
+};
+
+
+// Arena in memory mapped file.
+// Kernel moves data between file and memory as needed,
+// so Objects may be bigger than physical memory (at cost of disk access).
+// File is a scratch space - it is removed from file system right after creation.
+class MappedFileArena: public IObjectsArena
+{
+    public:
+        MappedFileArena(const std::string& path, std::size_t bytes, int hints = Sequential);
+        MappedFileArena(const MappedFileArena &) = delete;
+        ~MappedFileArena();
+
+        MappedFileArena& operator=(const MappedFileArena &) = delete;
+
+        virtual char* data() override;
+        virtual std::size_t size() const override;
+
+        virtual void resize(std::size_t bytes) override;
+
+    private:
+        char* m_data;
+        std::size_t m_size;
+        std::size_t m_mapped;
+        int m_file;
+        int m_hints;
+
+        std::size_t mappingSize(std::size_t) const;
+};
+
+#endif // OBJECTSARENA_HPP
@@ -0,0 +1,239 @@
+/*
+ * Container for Objects with hot data packed in SIMD friendly blocks
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OBJECTSBLOCKS_HPP
+#define OBJECTSBLOCKS_HPP
+
+#include <cassert>
+#include <vector>
+
+#include "objects.hpp"
+
+
+// AoSoA variant of Objects.
+// Data used by pair loops (position, mass and radius) is kept in blocks of 'Width' objects,
+// so one block is a single, aligned piece of memory with one SIMD register worth of data per field.
+// Rarely used data (velocity and id) is kept in separate columns, as in Objects.
+template<std::size_t Width>
+class ObjectsBlocks
+{
+    public:
+        static_assert(Width == 8 || Width == 16, "Block width should match AVX or AVX-512 register");
+
+        struct alignas(64) Block
+        {
+            BaseType x[Width];
+            BaseType y[Width];
+            BaseType mass[Width];
+            BaseType radius[Width];
+        };
+
+        typedef std::vector<Block, Objects::AlignmentAllocator<Block, 64>> BlockVector;
+        typedef std::vector<BaseType, Objects::AlignmentAllocator<BaseType, 64>> DataVector;
+
+        static constexpr std::size_t width = Width;
+
+        ObjectsBlocks(): m_blocks(), m_vx(), m_vy(), m_id(), m_size(0)
+        {
+
+        }
+
+        ObjectsBlocks(const ObjectsBlocks &) = delete;
+        ObjectsBlocks& operator=(const ObjectsBlocks &) = delete;
+
+        Object operator[](std::size_t idx) const                // returns Object for given index (index ≠ Object::id)
+        {
+            const Block& b = m_blocks[idx / Width];
+            const std::size_t l = idx % Width;
+
+            const Object obj(b.x[l], b.y[l], b.mass[l], b.radius[l], m_vx[idx], m_vy[idx], m_id[idx]);
+
+            return obj;
+        }
+
+        std::size_t size() const
+        {
+            return m_size;
+        }
+
+        std::size_t blocks() const
+        {
+            return m_blocks.size();
+        }
+
+        // copy content of Objects
+        void assign(const Objects& objects)
+        {
+            const std::size_t objs = objects.size();
+
+            resize(objs);
+
+            for(std::size_t i = 0; i < objs; i++)
+            {
+                Block& b = m_blocks[i / Width];
+                const std::size_t l = i % Width;
+
+                b.x[l]      = objects.getX()[i];
+                b.y[l]      = objects.getY()[i];
+                b.mass[l]   = objects.getMass()[i];
+                b.radius[l] = objects.getRadius()[i];
+            }
+
+            m_vx.assign(objects.getVX().begin(), objects.getVX().end());
+            m_vy.assign(objects.getVY().begin(), objects.getVY().end());
+            m_id.assign(objects.getId().begin(), objects.getId().end());
+        }
+
+        std::size_t insert(const Object& obj, std::size_t id)   // returns Object's index. Index is valid until next modification
+        {
+            const std::size_t idx = m_size;
+
+            resize(m_size + 1);
+
+            setPos(idx, obj.pos());
+            setMass(idx, obj.mass());
+            setRadius(idx, obj.radius());
+
+            m_vx.push_back(obj.velocity().x.raw_value());
+            m_vy.push_back(obj.velocity().y.raw_value());
+            m_id.push_back(id);
+
+            assert(m_vx.size() == m_size);
+            assert(m_vy.size() == m_size);
+            assert(m_id.size() == m_size);
+
+            return idx;
+        }
+
+        void erase(std::size_t idx)                             // erase item at index 'idx'. Last item will overwrite 'idx' and list will shrink
+        {
+            const std::size_t last = m_size - 1;
+            const Object obj = (*this)[last];
+
+            setPos(idx, obj.pos());
+            setMass(idx, obj.mass());
+            setRadius(idx, obj.radius());
+
+            m_vx[idx] = m_vx[last];
+            m_vy[idx] = m_vy[last];
+            m_id[idx] = m_id[last];
+
+            m_vx.pop_back();
+            m_vy.pop_back();
+            m_id.pop_back();
+
+            resize(last);
+        }
+
+        // hight level access
+        void setPos(std::size_t idx, const XY& xy)
+        {
+            Block& b = m_blocks[idx / Width];
+            b.x[idx % Width] = xy.x;
+            b.y[idx % Width] = xy.y;
+        }
+
+        void setVelocity(std::size_t idx, const XY& vxy)
+        {
+            m_vx[idx] = vxy.x;
+            m_vy[idx] = vxy.y;
+        }
+
+        void setMass(std::size_t idx, mass_type mass)
+        {
+            m_blocks[idx / Width].mass[idx % Width] = mass.raw_value();
+        }
+
+        void setRadius(std::size_t idx, BaseType radius)
+        {
+            m_blocks[idx / Width].radius[idx % Width] = radius;
+        }
+
+        XY getPos(std::size_t idx) const
+        {
+            const Block& b = m_blocks[idx / Width];
+            const XY xy(b.x[idx % Width], b.y[idx % Width]);
+
+            return xy;
+        }
+
+        XY getVelocity(std::size_t idx) const
+        {
+            const XY vxy(m_vx[idx], m_vy[idx]);
+
+            return vxy;
+        }
+        //
+
+        // raw data access for accelerators' purposes
+        const Block& block(std::size_t b) const
+        {
+            return m_blocks[b];
+        }
+
+        const BlockVector& getBlocks() const
+        {
+            return m_blocks;
+        }
+
+        const DataVector& getVX() const
+        {
+            return m_vx;
+        }
+
+        const DataVector& getVY() const
+        {
+            return m_vy;
+        }
+
+        const std::vector<int>& getId() const
+        {
+            return m_id;
+        }
+
+    private:
+        BlockVector m_blocks;
+        DataVector m_vx;
+        DataVector m_vy;
+        std::vector<int> m_id;
+        std::size_t m_size;
+
+        // Change number of objects. Unused lanes of the last block are zeroed,
+        // so they are massless and have no size.
+        void resize(std::size_t objs)
+        {
+            m_size = objs;
+            m_blocks.resize( (objs + Width - 1) / Width );
+
+            if (m_blocks.empty() == false)
+            {
+                Block& b = m_blocks.back();
+
+                for(std::size_t l = objs - (m_blocks.size() - 1) * Width; l < Width; l++)
+                {
+                    b.x[l]      = 0.0;
+                    b.y[l]      = 0.0;
+                    b.mass[l]   = 0.0;
+                    b.radius[l] = 0.0;
+                }
+            }
+        }
+};
+
+#endif // OBJECTSBLOCKS_HPP
@@ -0,0 +1,429 @@
+/*
+ * Loading of initial conditions
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "objects_loader.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "objects.hpp"
+
+
+namespace
+{
+    const char binary_magic[8] = { 'G', 'R', 'A', 'V', 'O', 'B', 'J', '\0' };
+    const std::uint32_t binary_version = 1;
+    const std::size_t columns_count = 6;                // x, y, vx, vy, mass, radius
+
+    struct BinaryHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t entrySize;            // sizeof(BaseType)
+        std::uint64_t count;
+    };
+
+
+    bool isBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+
+    const char* skipBlanks(const char* p, const char* end)
+    {
+        while (p < end && isBlank(*p))
+            p++;
+
+        return p;
+    }
+
+
+    // Calls 'f(begin, end)' for each line describing an object (not empty and not a comment).
+    // Stops when 'f' returns false.
+    template<typename F>
+    bool forEachObjectLine(const char* begin, const char* end, const F& f)
+    {
+        while (begin < end)
+        {
+            const void* nl = std::memchr(begin, '\n', end - begin);
+            const char* eol = nl == nullptr? end: static_cast<const char *>(nl);
+            const char* p = skipBlanks(begin, eol);
+
+            if (p < eol && *p != '#' && f(p, eol) == false)
+                return false;
+
+            begin = eol + 1;
+        }
+
+        return true;
+    }
+
+
+    bool parseLine(const char* p, const char* end, BaseType (&values)[columns_count])
+    {
+        for(std::size_t c = 0; c < columns_count; c++)
+        {
+            p = skipBlanks(p, end);
+
+            if (c > 0)
+            {
+                if (p == end || *p != ',')
+                    return false;
+
+                p = skipBlanks(p + 1, end);
+            }
+
+            const std::from_chars_result result = std::from_chars(p, end, values[c]);
+
+            if (result.ec != std::errc())
+                return false;
+
+            p = result.ptr;
+        }
+
+        return skipBlanks(p, end) == end;
+    }
+
+
+    // Header line contains names of columns: none of its fields is a number.
+    // Other lines which cannot be parsed are malformed objects.
+    bool isHeader(const char* p, const char* end)
+    {
+        while (p < end)
+        {
+            p = skipBlanks(p, end);
+
+            BaseType value;
+            if (std::from_chars(p, end, value).ec == std::errc())
+                return false;
+
+            const void* comma = std::memchr(p, ',', end - p);
+            p = comma == nullptr? end: static_cast<const char *>(comma) + 1;
+        }
+
+        return true;
+    }
+
+
+    // run 'f(0)' ... 'f(count - 1)' in parallel
+    template<typename F>
+    void parallel(std::size_t count, const F& f)
+    {
+        std::vector<std::thread> threads;
+
+        for(std::size_t i = 1; i < count; i++)
+            threads.emplace_back(f, i);
+
+        if (count > 0)
+            f(0);
+
+        for(std::thread& thread: threads)
+            thread.join();
+    }
+}
+
+
+ObjectsLoader::ObjectsLoader(unsigned int threads):
+    m_data(nullptr),
+    m_size(0),
+    m_format(Csv),
+    m_count(0),
+    m_chunks(),
+    m_error(),
+    m_threads(threads == 0? std::max(std::thread::hardware_concurrency(), 1u): threads)
+{
+
+}
+
+
+ObjectsLoader::~ObjectsLoader()
+{
+    close();
+}
+
+
+bool ObjectsLoader::open(const std::string& path, Format format)
+{
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+
+    if (fd == -1)
+    {
+        m_error = "Could not open file " + path + " for reading";
+        return false;
+    }
+
+    struct stat fileInfo;
+    const bool status = fstat(fd, &fileInfo) == 0;
+
+    m_size = status? fileInfo.st_size: 0;
+
+    if (m_size > 0)
+    {
+        void* mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (mapping != MAP_FAILED)
+        {
+            m_data = static_cast<const char *>(mapping);
+
+            // both formats are read from begin to end, once
+            madvise(mapping, m_size, MADV_SEQUENTIAL);
+            madvise(mapping, m_size, MADV_WILLNEED);
+        }
+    }
+
+    ::close(fd);
+
+    if (status == false || (m_size > 0 && m_data == nullptr))
+    {
+        m_error = "Could not map file " + path;
+        m_size = 0;
+
+        return false;
+    }
+
+    m_format = format;
+
+    const bool opened = format == Csv? openCsv(): openBinary();
+
+    if (opened == false)
+        close();
+
+    return opened;
+}
+
+
+void ObjectsLoader::close()
+{
+    if (m_data != nullptr)
+        munmap(const_cast<char *>(m_data), m_size);
+
+    m_data = nullptr;
+    m_size = 0;
+    m_count = 0;
+    m_chunks.clear();
+}
+
+
+std::size_t ObjectsLoader::count() const
+{
+    return m_count;
+}
+
+
+bool ObjectsLoader::load(Objects& objects, std::size_t first)
+{
+    if (first + m_count > objects.size())
+    {
+        m_error = "Not enough space in objects container";
+        return false;
+    }
+
+    return m_format == Csv? loadCsv(objects, first): loadBinary(objects, first);
+}
+
+
+const std::string& ObjectsLoader::error() const
+{
+    return m_error;
+}
+
+
+bool ObjectsLoader::saveBinary(const Objects& objects, const std::string& path)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+    BinaryHeader header;
+    std::memcpy(header.magic, binary_magic, sizeof(header.magic));
+    header.version = binary_version;
+    header.entrySize = sizeof(BaseType);
+    header.count = objects.size();
+
+    const std::size_t bytes = objects.size() * sizeof(BaseType);
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(objects.getX().data()), bytes);
+    file.write(reinterpret_cast<const char *>(objects.getY().data()), bytes);
+    file.write(reinterpret_cast<const char *>(objects.getVX().data()), bytes);
+    file.write(reinterpret_cast<const char *>(objects.getVY().data()), bytes);
+    file.write(reinterpret_cast<const char *>(objects.getMass().data()), bytes);
+    file.write(reinterpret_cast<const char *>(objects.getRadius().data()), bytes);
+
+    file.close();
+
+    return file.fail() == false;
+}
+
+
+bool ObjectsLoader::openCsv()
+{
+    const char* begin = m_data;
+    const char* end = m_data + m_size;
+
+    // skip header if there is one. Malformed first object is not skipped, it is reported by load()
+    forEachObjectLine(begin, end, [&begin](const char* line, const char* eol)
+    {
+        BaseType values[columns_count];
+
+        if (parseLine(line, eol, values) == false && isHeader(line, eol))
+            begin = eol;
+
+        return false;           // first line only
+    });
+
+    // split file into chunks (on lines' boundaries) and count objects in each of them in parallel
+    const std::size_t bytes = end - begin;
+
+    for(unsigned int t = 0; t < m_threads; t++)
+    {
+        const char* chunkBegin = t == 0? begin: m_chunks.back().end;
+        const char* chunkEnd = t + 1 == m_threads? end: begin + bytes * (t + 1) / m_threads;
+
+        if (chunkEnd < chunkBegin)
+            chunkEnd = chunkBegin;
+
+        // move end just after end of line
+        const void* nl = std::memchr(chunkEnd, '\n', end - chunkEnd);
+        chunkEnd = (nl == nullptr || t + 1 == m_threads)? end: static_cast<const char *>(nl) + 1;
+
+        m_chunks.push_back( Chunk{chunkBegin, chunkEnd, 0} );
+    }
+
+    parallel(m_chunks.size(), [this](std::size_t c)
+    {
+        Chunk& chunk = m_chunks[c];
+
+        forEachObjectLine(chunk.begin, chunk.end, [&chunk](const char *, const char *)
+        {
+            chunk.count++;
+            return true;
+        });
+    });
+
+    for(const Chunk& chunk: m_chunks)
+        m_count += chunk.count;
+
+    return true;
+}
+
+
+bool ObjectsLoader::openBinary()
+{
+    BinaryHeader header;
+
+    if (m_size >= sizeof(header))
+        std::memcpy(&header, m_data, sizeof(header));
+
+    const bool valid = m_size >= sizeof(header) &&
+                       std::memcmp(header.magic, binary_magic, sizeof(header.magic)) == 0 &&
+                       header.version == binary_version &&
+                       header.entrySize == sizeof(BaseType) &&
+                       header.count <= (m_size - sizeof(header)) / (columns_count * sizeof(BaseType));
+
+    if (valid)
+        m_count = header.count;
+    else
+        m_error = "Not a valid binary objects file";
+
+    return valid;
+}
+
+
+bool ObjectsLoader::loadCsv(Objects& objects, std::size_t first)
+{
+    // where each chunk's objects go
+    std::vector<std::size_t> offsets(m_chunks.size(), first);
+    for(std::size_t c = 1; c < m_chunks.size(); c++)
+        offsets[c] = offsets[c - 1] + m_chunks[c - 1].count;
+
+    std::vector<const char *> errors(m_chunks.size(), nullptr);
+
+    parallel(m_chunks.size(), [this, &objects, &offsets, &errors](std::size_t c)
+    {
+        std::size_t i = offsets[c];
+
+        forEachObjectLine(m_chunks[c].begin, m_chunks[c].end, [&objects, &i, &errors, c](const char* line, const char* eol)
+        {
+            BaseType values[columns_count];
+
+            if (parseLine(line, eol, values) == false)
+            {
+                errors[c] = line;
+                return false;
+            }
+
+            objects.getX()[i]      = values[0];
+            objects.getY()[i]      = values[1];
+            objects.getVX()[i]     = values[2];
+            objects.getVY()[i]     = values[3];
+            objects.getMass()[i]   = values[4];
+            objects.getRadius()[i] = values[5];
+            i++;
+
+            return true;
+        });
+    });
+
+    for(const char* error: errors)
+        if (error != nullptr)
+        {
+            const std::size_t line = std::count(m_data, error, '\n') + 1;
+            m_error = "Invalid object description in line " + std::to_string(line);
+
+            return false;
+        }
+
+    return true;
+}
+
+
+bool ObjectsLoader::loadBinary(Objects& objects, std::size_t first)
+{
+    const std::size_t bytes = m_count * sizeof(BaseType);
+    const char* column = m_data + sizeof(BinaryHeader);
+
+    BaseType* columns[] =
+    {
+        objects.getX().data(),
+        objects.getY().data(),
+        objects.getVX().data(),
+        objects.getVY().data(),
+        objects.getMass().data(),
+        objects.getRadius().data(),
+    };
+
+    for(BaseType* to: columns)
+    {
+        std::memcpy(to + first, column, bytes);
+        column += bytes;
+    }
+
+    return true;
+}
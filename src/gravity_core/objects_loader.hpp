@@ -0,0 +1,89 @@
+/*
+ * Loading of initial conditions
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OBJECTSLOADER_HPP
+#define OBJECTSLOADER_HPP
+
+#include <string>
+#include <vector>
+
+class Objects;
+
+
+// Reader of files with objects' initial state.
+//
+// Supported formats:
+//   Csv    - one object per line: x, y, vx, vy, mass, radius.
+//            Empty lines and lines starting with '#' are ignored, first line may be a header.
+//            File is parsed by many threads at once, each one working on different part of file.
+//   Binary - header (see saveBinary()) followed by columns: x, y, vx, vy, mass, radius.
+//            Columns are copied directly from memory mapped file.
+//
+// Usage:
+//   ObjectsLoader loader;
+//   if (loader.open(path, ObjectsLoader::Csv))
+//       engine.addObjects(loader.count(), [&loader](Objects& objects, std::size_t first) { return loader.load(objects, first); });
+class ObjectsLoader
+{
+    public:
+        enum Format
+        {
+            Csv,
+            Binary,
+        };
+
+        ObjectsLoader(unsigned int threads = 0);               // 0 = use all cores
+        ObjectsLoader(const ObjectsLoader &) = delete;
+        ~ObjectsLoader();
+
+        ObjectsLoader& operator=(const ObjectsLoader &) = delete;
+
+        bool open(const std::string& path, Format);             // map file and count objects
+        void close();
+
+        std::size_t count() const;
+        bool load(Objects &, std::size_t first);                // fill entries [first, first + count()) of objects. Ids are not touched
+
+        const std::string& error() const;                       // description of last error
+
+        static bool saveBinary(const Objects &, const std::string& path);
+
+    private:
+        struct Chunk
+        {
+            const char* begin;
+            const char* end;
+            std::size_t count;                                  // number of objects in chunk
+        };
+
+        const char* m_data;
+        std::size_t m_size;
+        Format m_format;
+        std::size_t m_count;
+        std::vector<Chunk> m_chunks;
+        std::string m_error;
+        unsigned int m_threads;
+
+        bool openCsv();
+        bool openBinary();
+        bool loadCsv(Objects &, std::size_t first);
+        bool loadBinary(Objects &, std::size_t first);
+};
+
+#endif // OBJECTSLOADER_HPP
@@ -25,16 +25,93 @@
 #include <omp.h>
 
 #include "accelerators/iaccelerator.hpp"
+#include "tracing.hpp"
+
+
+namespace
+{
+    // do not allow too big jumps (precission loss) nor no small ones (performance loss)
+    bool acceptDt(double& dt, BaseType max_travel)
+    {
+        if (max_travel > 100e3)
+            dt = dt * 100e3 / max_travel;
+        else if (max_travel < 1e3)
+            dt = dt * 1e3 / max_travel;
+        else
+            return true;
+
+        return false;
+    }
+}
+
+
+SimulationEventsAdapter::SimulationEventsAdapter(ISimulationEvents* events):
+    m_events(events)
+{
+
+}
+
+
+void SimulationEventsAdapter::objectsCreated(const Objects& objects, std::size_t first, std::size_t count)
+{
+    m_events->objectsCreated(objects, first, count);
+}
+
+
+void SimulationEventsAdapter::objectsColided(const std::vector<Collision>& collisions)
+{
+    for(const Collision& collision: collisions)
+        m_events->objectsColided(collision.survivor, collision.annihilated);
+}
+
+
+void SimulationEventsAdapter::objectsAnnihilated(const std::vector<Object>& objects)
+{
+    for(const Object& object: objects)
+        m_events->objectAnnihilated(object);
+}
+
+
+void SimulationEventsAdapter::objectsUpdated(const Objects& objects)
+{
+    for (std::size_t i = 0; i < objects.size(); i++)
+    {
+        const Object obj = objects[i];
+        m_events->objectUpdated(obj.id(), obj);
+    }
+}
 
 
 SimulationEngine::SimulationEngine(IAccelerator* accelerator):
-    m_objects(),
+    SimulationEngine(accelerator, Objects::DefaultCapacity)
+{
+
+}
+
+
+SimulationEngine::SimulationEngine(IAccelerator* accelerator, std::size_t capacity, int hints):
+    SimulationEngine(accelerator, Objects::createArena(capacity, hints), capacity)
+{
+
+}
+
+
+SimulationEngine::SimulationEngine(IAccelerator* accelerator, std::unique_ptr<IObjectsArena> arena, std::size_t capacity):
+    m_objects(std::move(arena), capacity),
     m_eventObservers(),
+    m_eventAdapters(),
+    m_colided(),
+    m_annihilated(),
     m_accelerator(accelerator),
+    m_instrumentation(),
     m_dt(60.0),
-    m_nextId(1)                        // 0 is reserved for invalid entry
+    m_time(0.0),
+    m_nextId(1),                       // 0 is reserved for invalid entry
+    m_deviceResident(false),
+    m_hostStale(false)
 {
     m_accelerator->setObjects(&m_objects);
+    m_accelerator->setInstrumentation(&m_instrumentation);
 }
 
 
@@ -46,46 +123,115 @@ SimulationEngine::~SimulationEngine()
 
 void SimulationEngine::setAccelerator(IAccelerator* accelerator)
 {
+    synchronize();
+    m_accelerator->setInstrumentation(nullptr);
+
     m_accelerator = accelerator;
     m_accelerator->setObjects(&m_objects);
+    m_accelerator->setInstrumentation(&m_instrumentation);
 }
 
 
-void SimulationEngine::addEventsObserver(ISimulationEvents* observer)
+void SimulationEngine::setDeviceResident(bool resident)
+{
+    synchronize();
+
+    m_deviceResident = resident;
+    m_accelerator->invalidate();
+}
+
+
+bool SimulationEngine::deviceResident() const
+{
+    return m_deviceResident;
+}
+
+
+void SimulationEngine::addEventsObserver(ISimulationBatchEvents* observer)
 {
     m_eventObservers.push_back(observer);
 }
 
 
+void SimulationEngine::addEventsObserver(ISimulationEvents* observer)
+{
+    m_eventAdapters.push_back(std::make_unique<SimulationEventsAdapter>(observer));
+    m_eventObservers.push_back(m_eventAdapters.back().get());
+}
+
+
 int SimulationEngine::addObject(const Object& obj)
 {
     assert(obj.id() == 0);
+
+    synchronize();
+
     const auto idx =  m_objects.insert(obj, m_nextId);
-    const Object addedObj = m_objects[idx];
+    m_accelerator->invalidate();
 
-    for(ISimulationEvents* events: m_eventObservers)
-        events->objectCreated(m_nextId, addedObj);
+    for(ISimulationBatchEvents* events: m_eventObservers)
+        events->objectsCreated(m_objects, idx, 1);
 
     return m_nextId++;
 }
 
 
+int SimulationEngine::addObjects(std::size_t count, const ObjectsFiller& fill)
+{
+    synchronize();
+
+    const std::size_t first = m_objects.size();
+
+    m_objects.resize(first + count);
+
+    if (fill(m_objects, first) == false)
+    {
+        m_objects.resize(first);
+        return 0;
+    }
+
+    const int firstId = m_nextId;
+
+    Objects::IdVector& ids = m_objects.getId();
+    for(std::size_t i = first; i < first + count; i++)
+        ids[i] = m_nextId++;
+
+    m_accelerator->invalidate();
+
+    Instrumentation::Scope observersScope(m_instrumentation, Instrumentation::Observers);
+
+    for(ISimulationBatchEvents* events: m_eventObservers)
+        events->objectsCreated(m_objects, first, count);
+
+    return firstId;
+}
+
+
 int SimulationEngine::stepBy(double dt)
 {
     int steps = 0;
 
     while (dt > 0.0)
     {
-        dt -= step();
+        const double stepDt = advance();
+
+        dt -= stepDt;
+        m_time += stepDt;
         steps++;
     }
 
-    for (std::size_t i = 0; i < m_objects.size(); i++)
-        for(ISimulationEvents* events: m_eventObservers)
-        {
-            const Object obj = m_objects[i];
-            events->objectUpdated(obj.id(), obj);
-        }
+    Instrumentation::Scope observersScope(m_instrumentation, Instrumentation::Observers);
+    TRACE_SCOPE("engine", "observers");
+
+    // without observers device resident objects stay where they are, objects() synchronizes when asked
+    if (m_eventObservers.empty() == false)
+    {
+        synchronize();
+        notifyCollisions();
+
+        for(ISimulationBatchEvents* events: m_eventObservers)
+            events->objectsUpdated(m_objects);
+    }
 
     return steps;
 }
@@ -93,52 +239,115 @@ int SimulationEngine::stepBy(double dt)
 
 double SimulationEngine::step()
 {
+    const double dt = advance();
+    m_time += dt;
+
+    if (m_colided.empty() == false || m_annihilated.empty() == false)
+    {
+        Instrumentation::Scope observersScope(m_instrumentation, Instrumentation::Observers);
+        notifyCollisions();
+    }
+
+    return dt;
+}
+
+
+double SimulationEngine::advance()
+{
+    TRACE_STEP();
+    TRACE_SCOPE("engine", "step");
+    Instrumentation::Scope stepScope(m_instrumentation, Instrumentation::Step);
+
+    if (m_deviceResident)
+    {
+        int retries = 0;
+        bool collisions = false;
+
+        const IAccelerator::DtController accept = [&retries](double& dt, BaseType max_travel)
+        {
+            const bool accepted = acceptDt(dt, max_travel);
+            retries += accepted? 0: 1;
+
+            return accepted;
+        };
+
+        if (m_accelerator->residentStep(m_dt, accept, collisions))
+        {
+            m_hostStale = true;
+
+            TRACE_COUNTER("engine", "dt retries", retries);
+
+            if (m_instrumentation.enabled())
+                m_instrumentation.record(Instrumentation::Retries, retries);
+
+            if (collisions)
+                checkForCollisions();
+
+            return m_dt;
+        }
+    }
+
+    synchronize();
+
     bool optimal = false;
+    int retries = -1;
 
     const std::size_t objs = m_objects.size();
 
     std::vector<XY> v(objs);
     std::vector<XY> pos(objs);
 
-    const std::vector<force_vector_t> forces = m_accelerator->forces();
-
-    do
+    const std::vector<force_vector_t> forces = [this]
     {
-        const std::vector<XY> speeds = m_accelerator->velocities(forces, m_dt);
+        TRACE_SCOPE("engine", "forces");
+        Instrumentation::Scope forcesScope(m_instrumentation, Instrumentation::Forces);
+        return m_accelerator->forces();
+    }();
 
-        // figure out maximum distance made by single object
-        BaseType max_travel = 0.0;
+    // integration with dt adjustments
+    {
+        TRACE_SCOPE("engine", "integration");
+        Instrumentation::Scope integrationScope(m_instrumentation, Instrumentation::Integration);
 
-        for(std::size_t i = 0; i < objs; i++)
+        do
         {
-            Object o = m_objects[i];
+            retries++;
 
-            const XY& dV = speeds[i];
-            v[i] = dV + o.velocity();
-            pos[i] = o.pos() + v[i] * m_dt;
+            const std::vector<XY> speeds = m_accelerator->velocities(forces, m_dt);
 
-            const BaseType travel = utils::distance(pos[i], o.pos());
+            // figure out maximum distance made by single object
+            BaseType max_travel = 0.0;
 
-            if (travel > max_travel)
-                max_travel = travel;
+            for(std::size_t i = 0; i < objs; i++)
+            {
+                Object o = m_objects[i];
+
+                const XY& dV = speeds[i];
+                v[i] = dV + o.velocity();
+                pos[i] = o.pos() + v[i] * m_dt;
+
+                const BaseType travel = utils::distance(pos[i], o.pos());
+
+                if (travel > max_travel)
+                    max_travel = travel;
+            }
+
+            optimal = acceptDt(m_dt, max_travel);
         }
+        while(optimal == false);
 
-        // do not allow too big jumps (precission loss) nor no small ones (performance loss)
-        if (max_travel > 100e3)
-            m_dt = m_dt * 100e3 / max_travel;
-        else if (max_travel < 1e3)
-            m_dt = m_dt * 1e3 / max_travel;
-        else
-            optimal = true;
+        // apply new positions and speeds
+        for(std::size_t i = 0; i < objs; i++)
+        {
+            m_objects.setPos(i, pos[i]);
+            m_objects.setVelocity(i, v[i]);
+        }
     }
-    while(optimal == false);
 
-    // apply new positions and speeds
-    for(std::size_t i = 0; i < objs; i++)
-    {
-        m_objects.setPos(i, pos[i]);
-        m_objects.setVelocity(i, v[i]);
-    }
+    TRACE_COUNTER("engine", "dt retries", retries);
+
+    if (m_instrumentation.enabled())
+        m_instrumentation.record(Instrumentation::Retries, retries);
 
     checkForCollisions();
 
@@ -146,12 +355,32 @@ double SimulationEngine::step()
 }
 
 
+double SimulationEngine::simulatedTime() const
+{
+    return m_time;
+}
+
+
 const Objects& SimulationEngine::objects() const
 {
+    synchronize();
+
     return m_objects;
 }
 
 
+Instrumentation& SimulationEngine::instrumentation()
+{
+    return m_instrumentation;
+}
+
+
+const Instrumentation& SimulationEngine::instrumentation() const
+{
+    return m_instrumentation;
+}
+
+
 std::size_t SimulationEngine::objectCount() const
 {
     return m_objects.size();
@@ -185,16 +414,32 @@ std::size_t SimulationEngine::collide(std::size_t i, std::size_t j)
     m_objects.setMass(heavier, masses);
     m_objects.setRadius(heavier, newRadius);
 
-    for(ISimulationEvents* events: m_eventObservers)
-        events->objectsColided(h, l);
-
-    for(ISimulationEvents* events: m_eventObservers)
-        events->objectAnnihilated(l);
+    // observers are notified once per step()/stepBy(), see notifyCollisions()
+    if (m_eventObservers.empty() == false)
+    {
+        m_colided.push_back( ISimulationBatchEvents::Collision{h, l} );
+        m_annihilated.push_back(l);
+    }
 
     return lighter;
 }
 
 
+void SimulationEngine::notifyCollisions()
+{
+    if (m_colided.empty() == false)
+        for(ISimulationBatchEvents* events: m_eventObservers)
+            events->objectsColided(m_colided);
+
+    if (m_annihilated.empty() == false)
+        for(ISimulationBatchEvents* events: m_eventObservers)
+            events->objectsAnnihilated(m_annihilated);
+
+    m_colided.clear();
+    m_annihilated.clear();
+}
+
+
 void SimulationEngine::checkForCollisions()
 {
     // Container for object to be removed.
@@ -203,7 +448,18 @@ void SimulationEngine::checkForCollisions()
     // (object is erased by being overwriten with last one).
     std::set<std::size_t, std::greater<std::size_t>> toRemove;
 
-    std::vector<std::pair<int, int>> toColide = m_accelerator->collisions();
+    std::vector<std::pair<int, int>> toColide;
+
+    synchronize();
+
+    {
+        TRACE_SCOPE("engine", "collisions");
+        Instrumentation::Scope detectionScope(m_instrumentation, Instrumentation::CollisionDetection);
+        toColide = m_accelerator->collisions();
+    }
+
+    TRACE_SCOPE("engine", "merging");
+    Instrumentation::Scope resolutionScope(m_instrumentation, Instrumentation::CollisionResolution);
 
     for(std::size_t i = 0; i < toColide.size(); i++)
     {
@@ -228,4 +484,19 @@ void SimulationEngine::checkForCollisions()
     // remove destroyed objects (remember to go from farthest objects)
     for(std::size_t i: toRemove)
         m_objects.erase(i);
+
+    if (toColide.empty() == false)
+        m_accelerator->invalidate();
+}
+
+
+void SimulationEngine::synchronize() const
+{
+    if (m_hostStale)
+    {
+        TRACE_SCOPE("engine", "synchronize");
+
+        m_accelerator->synchronize();
+        m_hostStale = false;
+    }
 }
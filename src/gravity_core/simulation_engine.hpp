@@ -23,10 +23,12 @@
 
 
 #include <cmath>
+#include <functional>
 #include <iostream>
 #include <vector>
 #include <memory>
 
+#include "instrumentation.hpp"
 #include "objects.hpp"
 
 struct IAccelerator;
@@ -40,6 +42,50 @@ struct ISimulationEvents
     virtual void objectCreated(int id, const Object &) = 0;
     virtual void objectAnnihilated(const Object &) = 0;
     virtual void objectUpdated(int id, const Object &) = 0;
+
+    // many objects were created at once (entries [first, first + count) of given container)
+    virtual void objectsCreated(const Objects& objects, std::size_t first, std::size_t count)
+    {
+        for(std::size_t i = first; i < first + count; i++)
+            objectCreated(objects.getId()[i], objects[i]);
+    }
+};
+
+
+// Batched observer: gets read-only views of all changes at once instead of a call per object.
+// Arguments are valid during call only.
+// For each stepBy() observers get objectsColided() and objectsAnnihilated() (if there were any collisions)
+// followed by single objectsUpdated() with all objects.
+struct ISimulationBatchEvents
+{
+    struct Collision
+    {
+        Object survivor;                    // state before collision, this one became bigger
+        Object annihilated;
+    };
+
+    virtual ~ISimulationBatchEvents() {}
+
+    virtual void objectsCreated(const Objects &, std::size_t first, std::size_t count) = 0;  // entries [first, first + count)
+    virtual void objectsColided(const std::vector<Collision> &) = 0;
+    virtual void objectsAnnihilated(const std::vector<Object> &) = 0;
+    virtual void objectsUpdated(const Objects &) = 0;
+};
+
+
+// Delivers batched events to per object ISimulationEvents observer
+class SimulationEventsAdapter: public ISimulationBatchEvents
+{
+    public:
+        explicit SimulationEventsAdapter(ISimulationEvents *);
+
+        virtual void objectsCreated(const Objects &, std::size_t first, std::size_t count) override;
+        virtual void objectsColided(const std::vector<Collision> &) override;
+        virtual void objectsAnnihilated(const std::vector<Object> &) override;
+        virtual void objectsUpdated(const Objects &) override;
+
+    private:
+        ISimulationEvents* m_events;
 };
 
 
@@ -47,6 +93,8 @@ class SimulationEngine
 {
     public:
         SimulationEngine(IAccelerator * = nullptr);
+        SimulationEngine(IAccelerator *, std::size_t capacity, int hints = MemoryArena::NoHints);  // see Objects' constructor
+        SimulationEngine(IAccelerator *, std::unique_ptr<IObjectsArena>, std::size_t capacity);    // see Objects' constructor
         SimulationEngine(const SimulationEngine &) = delete;
         ~SimulationEngine();
 
@@ -54,24 +102,53 @@ class SimulationEngine
 
         void setAccelerator(IAccelerator *);
 
-        void addEventsObserver(ISimulationEvents *);
+        // Keep objects in accelerator's memory between steps (when supported, see IAccelerator::residentStep()).
+        // Objects are downloaded only when needed: by objects(), observers and collisions.
+        void setDeviceResident(bool);
+        bool deviceResident() const;
+
+        void addEventsObserver(ISimulationBatchEvents *);
+        void addEventsObserver(ISimulationEvents *);        // wrapped with SimulationEventsAdapter
 
         int addObject(const Object &);
+
+        // Bulk insertion: 'fill' gets objects' container with 'count' new (zeroed) entries starting at given index.
+        // It should fill columns (except ids), and return false on error (nothing is added then).
+        // Observers are notified with single objectsCreated(). Returns id of first object, ids are consecutive.
+        typedef std::function<bool(Objects &, std::size_t first)> ObjectsFiller;
+        int addObjects(std::size_t count, const ObjectsFiller& fill);
         int stepBy(double);
         double step();
 
+        double simulatedTime() const;                       // sum of all steps taken so far (restored from checkpoint)
+
         const Objects& objects() const;
         std::size_t objectCount() const;
 
+        Instrumentation& instrumentation();                 // per phase timings (disabled by default)
+        const Instrumentation& instrumentation() const;
+
     private:
+        friend class Checkpoint;
+
         Objects m_objects;
-        std::vector<ISimulationEvents *> m_eventObservers;
+        std::vector<ISimulationBatchEvents *> m_eventObservers;
+        std::vector<std::unique_ptr<SimulationEventsAdapter>> m_eventAdapters;
+        std::vector<ISimulationBatchEvents::Collision> m_colided;     // not yet delivered to observers
+        std::vector<Object> m_annihilated;
         IAccelerator* m_accelerator;
+        Instrumentation m_instrumentation;
         double m_dt;
+        double m_time;
         int m_nextId;
+        bool m_deviceResident;
+        mutable bool m_hostStale;                   // accelerator has newer objects than m_objects
 
+        double advance();
         std::size_t collide(std::size_t, std::size_t);
+        void notifyCollisions();
         void checkForCollisions();
+        void synchronize() const;
 };
 
 #endif // SIMULATIONENGINE_HPP
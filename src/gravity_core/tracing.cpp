@@ -0,0 +1,278 @@
+/*
+ * Timeline tracing
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "tracing.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+
+namespace Tracing
+{
+    // Buffer of current thread. Buffers are owned by Tracer (which lives till the end of program),
+    // owner only gives it back when thread exits.
+    struct Tracer::ThreadBufferOwner
+    {
+        ThreadBuffer* buffer = nullptr;
+
+        ~ThreadBufferOwner()
+        {
+            if (buffer != nullptr)
+                Tracer::instance().release(buffer);
+        }
+    };
+
+
+    namespace
+    {
+        const std::uint64_t noStep = std::numeric_limits<std::uint64_t>::max();
+    }
+
+
+    Tracer::Tracer():
+        m_active(false),
+        m_step(0),
+        m_windowBegin(noStep),
+        m_windowEnd(noStep),
+        m_buffersMutex(),
+        m_buffers()
+    {
+
+    }
+
+
+    Tracer::~Tracer()
+    {
+
+    }
+
+
+    void Tracer::start()
+    {
+        m_windowBegin = noStep;
+        m_windowEnd = noStep;
+        m_active = true;
+    }
+
+
+    void Tracer::stop()
+    {
+        m_active = false;
+        m_windowBegin = noStep;
+        m_windowEnd = noStep;
+    }
+
+
+    void Tracer::capture(std::uint64_t firstStep, std::uint64_t steps)
+    {
+        const std::uint64_t begin = m_step + firstStep;
+
+        m_active = false;
+
+        if (steps == 0)
+        {
+            stop();
+            return;
+        }
+
+        m_windowEnd = begin + steps;
+        m_windowBegin = begin;
+    }
+
+
+    void Tracer::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_buffersMutex);
+
+        for(auto& buffer: m_buffers)
+            buffer->head = 0;
+    }
+
+
+    void Tracer::stepStarted()
+    {
+        const std::uint64_t step = m_step.fetch_add(1, std::memory_order_relaxed);
+
+        if (step == m_windowBegin.load(std::memory_order_relaxed))
+            m_active = true;
+        else if (step == m_windowEnd.load(std::memory_order_relaxed))
+            stop();
+    }
+
+
+    void Tracer::complete(const char* category, const char* name, std::uint64_t start, std::uint64_t end)
+    {
+        push( Event{category, name, start, end - start, 0.0, 'X'} );
+    }
+
+
+    void Tracer::counter(const char* category, const char* name, double value)
+    {
+        push( Event{category, name, now(), 0, value, 'C'} );
+    }
+
+
+    bool Tracer::exportChromeTrace(const std::string& path) const
+    {
+        std::ofstream file(path, std::ios_base::out | std::ios_base::trunc);
+
+        if (file.fail())
+        {
+            std::cerr << "Could not open file " << path << " for writing" << std::endl;
+            return false;
+        }
+
+        struct ThreadEvents
+        {
+            int tid;
+            std::vector<Event> events;
+        };
+
+        std::vector<ThreadEvents> threads;
+
+        {
+            std::lock_guard<std::mutex> lock(m_buffersMutex);
+
+            for(const auto& buffer: m_buffers)
+            {
+                const std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+                const std::uint64_t first = head > RingSize? head - RingSize: 0;
+
+                ThreadEvents thread = { buffer->tid, {} };
+                for(std::uint64_t i = first; i < head; i++)
+                    thread.events.push_back(buffer->events[i % RingSize]);
+
+                // drop events which could have been overwritten while copying
+                const std::uint64_t headAfter = buffer->head.load(std::memory_order_acquire);
+                const std::uint64_t valid = headAfter > RingSize? headAfter - RingSize: 0;
+                if (valid > first)
+                    thread.events.erase(thread.events.begin(), thread.events.begin() + std::min(valid - first, head - first));
+
+                threads.push_back(std::move(thread));
+            }
+        }
+
+        // timestamps relative to the first event
+        std::uint64_t origin = std::numeric_limits<std::uint64_t>::max();
+        for(const ThreadEvents& thread: threads)
+            for(const Event& event: thread.events)
+                origin = std::min(origin, event.start);
+
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+
+        bool firstEvent = true;
+        auto separator = [&file, &firstEvent]()
+        {
+            if (firstEvent == false)
+                file << ",\n";
+
+            firstEvent = false;
+        };
+
+        for(const ThreadEvents& thread: threads)
+        {
+            separator();
+            file << "{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": " << thread.tid
+                 << ", \"args\": {\"name\": \"thread " << thread.tid << "\"}}";
+
+            for(const Event& event: thread.events)
+            {
+                separator();
+                file << "{\"ph\": \"" << event.type << "\", \"cat\": \"" << event.category << "\", \"name\": \"" << event.name << "\""
+                     << ", \"pid\": 1, \"tid\": " << thread.tid
+                     << ", \"ts\": " << (event.start - origin) / 1000.0;
+
+                if (event.type == 'X')
+                    file << ", \"dur\": " << event.duration / 1000.0;
+                else
+                    file << ", \"args\": {\"value\": " << event.value << "}";
+
+                file << "}";
+            }
+        }
+
+        file << "\n]}\n";
+
+        return file.good();
+    }
+
+
+    std::uint64_t Tracer::now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+
+    Tracer::ThreadBuffer& Tracer::buffer()
+    {
+        thread_local ThreadBufferOwner current;
+
+        if (current.buffer == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(m_buffersMutex);
+
+            // reuse buffer of exited thread, events recorded so far stay in ring
+            for(const auto& buffer: m_buffers)
+                if (buffer->free)
+                {
+                    buffer->free = false;
+                    current.buffer = buffer.get();
+
+                    break;
+                }
+
+            if (current.buffer == nullptr)
+            {
+                std::unique_ptr<ThreadBuffer> buffer = std::make_unique<ThreadBuffer>();
+                buffer->events.resize(RingSize);
+                buffer->head = 0;
+                buffer->tid = static_cast<int>(m_buffers.size()) + 1;
+                buffer->free = false;
+
+                current.buffer = buffer.get();
+                m_buffers.push_back(std::move(buffer));
+            }
+        }
+
+        return *current.buffer;
+    }
+
+
+    void Tracer::release(ThreadBuffer* buffer)
+    {
+        std::lock_guard<std::mutex> lock(m_buffersMutex);
+        buffer->free = true;
+    }
+
+
+    void Tracer::push(const Event& event)
+    {
+        ThreadBuffer& ring = buffer();
+
+        // single producer: only this thread moves head
+        const std::uint64_t head = ring.head.load(std::memory_order_relaxed);
+        ring.events[head % RingSize] = event;
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+}
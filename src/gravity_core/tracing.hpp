@@ -0,0 +1,173 @@
+/*
+ * Timeline tracing
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TRACING_HPP
+#define TRACING_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+// Timeline of engine, accelerators and GUI activity, exported in Chrome trace format
+// (chrome://tracing, https://ui.perfetto.dev).
+//
+// Code is instrumented with TRACE_* macros, which are compiled out unless GRAVITY_TRACING is defined
+// (ENABLE_TRACING cmake option). When compiled in, but not capturing, each macro costs one relaxed atomic load.
+//
+// Each thread writes to its own ring buffer (no locks, no allocations after first event of thread),
+// so oldest events are overwritten when capture is longer than ring.
+// Buffer of exited thread (with its events) is taken over by the next new thread,
+// so number of buffers is limited by number of threads running at once.
+//
+// Usage:
+//   Tracing::Tracer::instance().capture(100, 10);     // record steps 100 - 109 (counted by TRACE_STEP)
+//   ...
+//   Tracing::Tracer::instance().exportChromeTrace("trace.json");
+namespace Tracing
+{
+    class Tracer
+    {
+        public:
+            static const std::size_t RingSize = 64 * 1024;     // events per thread
+
+            static Tracer& instance()
+            {
+                static Tracer tracer;
+                return tracer;
+            }
+
+            Tracer(const Tracer &) = delete;
+            Tracer& operator=(const Tracer &) = delete;
+
+            void start();                                           // capture until stop()
+            void stop();
+            void capture(std::uint64_t firstStep, std::uint64_t steps);    // capture window of steps, counting from now
+            void clear();                                           // drop recorded events
+
+            bool active() const
+            {
+                return m_active.load(std::memory_order_relaxed);
+            }
+
+            void stepStarted();                                     // see TRACE_STEP
+
+            void complete(const char* category, const char* name, std::uint64_t start, std::uint64_t end);
+            void counter(const char* category, const char* name, double value);
+
+            // Write recorded events as Chrome trace JSON.
+            // Should be called when capture is over - events being overwritten during export are skipped.
+            bool exportChromeTrace(const std::string& path) const;
+
+            static std::uint64_t now();                             // ns
+
+        private:
+            struct Event
+            {
+                const char* category;                               // string literals only
+                const char* name;
+                std::uint64_t start;
+                std::uint64_t duration;
+                double value;
+                char type;                                          // Chrome's phase: 'X' complete, 'C' counter
+            };
+
+            struct ThreadBuffer
+            {
+                std::vector<Event> events;
+                std::atomic<std::uint64_t> head;                    // number of events written so far
+                int tid;
+                bool free;                                          // owner thread has exited (guarded by m_buffersMutex)
+            };
+
+            struct ThreadBufferOwner;
+            friend struct ThreadBufferOwner;
+
+            std::atomic<bool> m_active;
+            std::atomic<std::uint64_t> m_step;
+            std::atomic<std::uint64_t> m_windowBegin;
+            std::atomic<std::uint64_t> m_windowEnd;
+
+            mutable std::mutex m_buffersMutex;
+            std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+
+            Tracer();
+            ~Tracer();
+
+            ThreadBuffer& buffer();
+            void release(ThreadBuffer *);
+            void push(const Event &);
+    };
+
+
+    // records time of scope as complete event
+    class Scope
+    {
+        public:
+            Scope(const char* category, const char* name):
+                m_category(category),
+                m_name(name),
+                m_start(Tracer::instance().active()? Tracer::now(): 0)
+            {
+            }
+
+            Scope(const Scope &) = delete;
+            Scope& operator=(const Scope &) = delete;
+
+            ~Scope()
+            {
+                // capture may start or stop in the middle of scope, record only fully captured ones
+                if (m_start != 0 && Tracer::instance().active())
+                    Tracer::instance().complete(m_category, m_name, m_start, Tracer::now());
+            }
+
+        private:
+            const char* m_category;
+            const char* m_name;
+            const std::uint64_t m_start;
+    };
+
+
+    inline void counter(const char* category, const char* name, double value)
+    {
+        Tracer& tracer = Tracer::instance();
+
+        if (tracer.active())
+            tracer.counter(category, name, value);
+    }
+}
+
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#ifdef GRAVITY_TRACING
+#define TRACE_SCOPE(category, name)             Tracing::Scope TRACE_CONCAT(traceScope, __LINE__)(category, name)
+#define TRACE_COUNTER(category, name, value)    Tracing::counter(category, name, value)
+#define TRACE_STEP()                            Tracing::Tracer::instance().stepStarted()
+#else
+#define TRACE_SCOPE(category, name)             static_cast<void>(0)
+#define TRACE_COUNTER(category, name, value)    static_cast<void>(0)
+#define TRACE_STEP()                            static_cast<void>(0)
+#endif
+
+#endif // TRACING_HPP
@@ -0,0 +1,83 @@
+/*
+ * Trajectory files
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "trajectory.hpp"
+
+#include <algorithm>
+
+#include "objects.hpp"
+
+
+namespace
+{
+    template<typename T, typename C>
+    void copy(std::vector<T>& to, const C& from)
+    {
+        std::copy(from.begin(), from.end(), to.begin());
+    }
+}
+
+
+TrajectorySnapshot::TrajectorySnapshot():
+    time(0.0),
+    id(),
+    x(),
+    y(),
+    vx(),
+    vy(),
+    mass(),
+    radius()
+{
+
+}
+
+
+void TrajectorySnapshot::assign(const Objects& objects, double t)
+{
+    time = t;
+
+    resize(objects.size());
+
+    copy(id, objects.getId());
+    copy(x, objects.getX());
+    copy(y, objects.getY());
+    copy(vx, objects.getVX());
+    copy(vy, objects.getVY());
+    copy(mass, objects.getMass());
+    copy(radius, objects.getRadius());
+}
+
+
+void TrajectorySnapshot::resize(std::size_t size)
+{
+    id.resize(size);
+    x.resize(size);
+    y.resize(size);
+    vx.resize(size);
+    vy.resize(size);
+    mass.resize(size);
+    radius.resize(size);
+}
+
+
+std::size_t TrajectorySnapshot::size() const
+{
+    return id.size();
+}
+
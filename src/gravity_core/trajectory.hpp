@@ -0,0 +1,88 @@
+/*
+ * Trajectory files
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TRAJECTORY_HPP
+#define TRAJECTORY_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "types.hpp"
+
+class Objects;
+
+
+// Copy of Objects' columns at given time
+struct TrajectorySnapshot
+{
+    double time;
+
+    std::vector<int> id;
+    std::vector<BaseType> x;
+    std::vector<BaseType> y;
+    std::vector<BaseType> vx;
+    std::vector<BaseType> vy;
+    std::vector<BaseType> mass;
+    std::vector<BaseType> radius;
+
+    TrajectorySnapshot();
+
+    void assign(const Objects &, double time);     // does not allocate when there is enough space already
+    void resize(std::size_t);
+    std::size_t size() const;
+};
+
+
+// Trajectory file layout (native byte order):
+//   file header
+//   chunks, one for each snapshot:
+//     chunk header
+//     data:
+//       Raw   - columns: id, x, y, vx, vy, mass, radius - each one 'objects' entries long
+//       Delta - see TrajectoryEncoder
+namespace TrajectoryFormat
+{
+    const char Magic[8] = { 'G', 'R', 'A', 'V', 'T', 'R', 'J', '\0' };
+    const std::uint32_t Version = 2;                    // version 1 had Raw chunks only
+    const std::uint32_t Columns = 7;
+
+    enum Encoding: std::uint32_t
+    {
+        Raw = 0,                        // independent snapshot (keyframe)
+        Delta = 1,                      // snapshot compressed against previous one
+    };
+
+    struct FileHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t entrySize;        // sizeof(BaseType)
+    };
+
+    struct ChunkHeader
+    {
+        std::uint32_t encoding;
+        std::uint32_t columns;
+        std::uint64_t objects;
+        double time;
+        std::uint64_t bytes;            // size of chunk's data (without header)
+    };
+}
+
+#endif // TRAJECTORY_HPP
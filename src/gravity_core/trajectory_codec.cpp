@@ -0,0 +1,506 @@
+/*
+ * Compression of trajectories
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "trajectory_codec.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace
+{
+    // Delta chunk's data:
+    //   quantization steps for x, y, vx, vy
+    //   compressed residuals of vx, vy, x and y columns, each one as:
+    //     number of 64 bit words, words
+    struct DeltaHeader
+    {
+        BaseType xStep;
+        BaseType yStep;
+        BaseType vxStep;
+        BaseType vyStep;
+    };
+
+    const std::size_t rice_block = 128;             // residuals in block share Rice parameter
+    const unsigned int rice_escape = 24;            // quotients this long are replaced by raw value
+    const double max_residual = 1 << 30;
+
+
+    class BitWriter
+    {
+        public:
+            BitWriter(std::vector<std::uint64_t>& words): m_words(words), m_buffer(0), m_used(0)
+            {
+                m_words.clear();
+            }
+
+            // value has to fit in 'bits' bits (up to 32)
+            void put(std::uint64_t value, unsigned int bits)
+            {
+                m_buffer |= value << m_used;
+                m_used += bits;
+
+                if (m_used >= 64)
+                {
+                    m_words.push_back(m_buffer);
+                    m_used -= 64;
+                    m_buffer = m_used > 0? value >> (bits - m_used): 0;
+                }
+            }
+
+            void flush()
+            {
+                if (m_used > 0)
+                    m_words.push_back(m_buffer);
+
+                m_buffer = 0;
+                m_used = 0;
+            }
+
+        private:
+            std::vector<std::uint64_t>& m_words;
+            std::uint64_t m_buffer;
+            unsigned int m_used;
+    };
+
+
+    class BitReader
+    {
+        public:
+            BitReader(const std::uint64_t* words, std::size_t count): m_words(words), m_bits(count * 64), m_position(0) {}
+
+            // returns next 'bits' bits (up to 32) without consuming them. Bits after end are zeros
+            std::uint64_t peek(unsigned int bits) const
+            {
+                const std::size_t word = m_position / 64;
+                const unsigned int offset = m_position % 64;
+
+                std::uint64_t value = word < m_bits / 64? m_words[word] >> offset: 0;
+
+                if (offset + bits > 64 && word + 1 < m_bits / 64)
+                    value |= m_words[word + 1] << (64 - offset);
+
+                return value & ((std::uint64_t(1) << bits) - 1);
+            }
+
+            bool skip(unsigned int bits)
+            {
+                m_position += bits;
+
+                return m_position <= m_bits;
+            }
+
+            bool get(unsigned int bits, std::uint64_t& value)
+            {
+                value = peek(bits);
+
+                return skip(bits);
+            }
+
+        private:
+            const std::uint64_t* m_words;
+            std::size_t m_bits;
+            std::size_t m_position;
+    };
+
+
+    std::uint32_t zigzag(std::int32_t value)
+    {
+        return (static_cast<std::uint32_t>(value) << 1) ^ static_cast<std::uint32_t>(value >> 31);
+    }
+
+
+    std::int32_t unzigzag(std::uint32_t value)
+    {
+        return static_cast<std::int32_t>(value >> 1) ^ -static_cast<std::int32_t>(value & 1);
+    }
+
+
+    void riceEncode(const std::vector<std::uint32_t>& values, std::vector<std::uint64_t>& words)
+    {
+        BitWriter writer(words);
+
+        for(std::size_t first = 0; first < values.size(); first += rice_block)
+        {
+            const std::size_t last = std::min(first + rice_block, values.size());
+
+            // Rice parameter close to log2 of mean value is near optimal for geometric distribution
+            std::uint64_t sum = 0;
+            for(std::size_t i = first; i < last; i++)
+                sum += values[i];
+
+            const std::uint64_t mean = sum / (last - first);
+            unsigned int k = 0;
+            while (k < 31 && (std::uint64_t(2) << k) <= mean)
+                k++;
+
+            writer.put(k, 5);
+
+            for(std::size_t i = first; i < last; i++)
+            {
+                const std::uint32_t quotient = values[i] >> k;
+
+                if (quotient < rice_escape)
+                {
+                    writer.put((std::uint64_t(1) << quotient) - 1, quotient + 1);      // unary: ones terminated by zero
+                    writer.put(values[i] & ((std::uint64_t(1) << k) - 1), k);
+                }
+                else
+                {
+                    writer.put((std::uint64_t(1) << rice_escape) - 1, rice_escape);
+                    writer.put(values[i], 32);
+                }
+            }
+        }
+
+        writer.flush();
+    }
+
+
+    bool riceDecode(const std::uint64_t* words, std::size_t count, std::vector<std::uint32_t>& values)
+    {
+        BitReader reader(words, count);
+        bool status = true;
+
+        for(std::size_t first = 0; status && first < values.size(); first += rice_block)
+        {
+            const std::size_t last = std::min(first + rice_block, values.size());
+
+            std::uint64_t k = 0;
+            status = reader.get(5, k);
+
+            for(std::size_t i = first; status && i < last; i++)
+            {
+                const std::uint64_t next = reader.peek(32);
+                const unsigned int ones = __builtin_ctzll(~next);          // length of unary part
+
+                std::uint64_t value = 0;
+
+                if (ones < rice_escape)
+                {
+                    std::uint64_t remainder = 0;
+                    status = reader.skip(ones + 1) && reader.get(k, remainder);
+                    value = (std::uint64_t(ones) << k) | remainder;
+                }
+                else
+                    status = reader.skip(rice_escape) && reader.get(32, value);
+
+                values[i] = static_cast<std::uint32_t>(value);
+            }
+        }
+
+        return status;
+    }
+
+
+    // Predictions and restoration are shared by encoder and decoder, so both get exactly the same values
+
+    BaseType restore(BaseType predicted, std::uint32_t residual, BaseType step)
+    {
+        return predicted + static_cast<BaseType>(unzigzag(residual)) * step;
+    }
+
+
+    BaseType predictPosition(BaseType x, BaseType v0, BaseType v1, BaseType dt)
+    {
+        // velocity changes during interval, use mean one
+        return x + (v0 + v1) * BaseType(0.5) * dt;
+    }
+
+
+    // Column restoration from residuals. 'predict(i)' returns prediction for i-th entry.
+    template<typename P>
+    void restoreColumn(const std::vector<std::uint32_t>& residuals, BaseType step, const P& predict, std::vector<BaseType>& column)
+    {
+        for(std::size_t i = 0; i < residuals.size(); i++)
+            column[i] = restore(predict(i), residuals[i], step);
+    }
+
+
+    // Column quantization. Returns false when residuals do not fit in 32 bits.
+    template<typename P>
+    bool quantizeColumn(const std::vector<BaseType>& values, BaseType step, const P& predict, std::vector<std::uint32_t>& residuals)
+    {
+        residuals.resize(values.size());
+
+        for(std::size_t i = 0; i < values.size(); i++)
+        {
+            const double residual = std::nearbyint( (double(values[i]) - predict(i)) / step );
+
+            if ((std::abs(residual) < max_residual) == false)       // also catches NaNs
+                return false;
+
+            residuals[i] = zigzag(static_cast<std::int32_t>(residual));
+        }
+
+        return true;
+    }
+
+
+    template<typename T>
+    void append(std::vector<char>& data, const T* values, std::size_t count)
+    {
+        const char* bytes = reinterpret_cast<const char *>(values);
+
+        data.insert(data.end(), bytes, bytes + count * sizeof(T));
+    }
+
+
+    template<typename T>
+    bool extract(const std::vector<char>& data, std::size_t& offset, T* values, std::size_t count)
+    {
+        const std::size_t bytes = count * sizeof(T);
+
+        if (offset + bytes > data.size())
+            return false;
+
+        std::memcpy(values, data.data() + offset, bytes);
+        offset += bytes;
+
+        return true;
+    }
+
+
+    void appendRaw(std::vector<char>& data, const TrajectorySnapshot& snapshot)
+    {
+        const std::size_t n = snapshot.size();
+
+        data.clear();
+        append(data, snapshot.id.data(), n);
+        append(data, snapshot.x.data(), n);
+        append(data, snapshot.y.data(), n);
+        append(data, snapshot.vx.data(), n);
+        append(data, snapshot.vy.data(), n);
+        append(data, snapshot.mass.data(), n);
+        append(data, snapshot.radius.data(), n);
+    }
+
+
+    bool extractRaw(const std::vector<char>& data, TrajectorySnapshot& snapshot)
+    {
+        const std::size_t n = snapshot.size();
+        std::size_t offset = 0;
+
+        return extract(data, offset, snapshot.id.data(), n) &&
+               extract(data, offset, snapshot.x.data(), n) &&
+               extract(data, offset, snapshot.y.data(), n) &&
+               extract(data, offset, snapshot.vx.data(), n) &&
+               extract(data, offset, snapshot.vy.data(), n) &&
+               extract(data, offset, snapshot.mass.data(), n) &&
+               extract(data, offset, snapshot.radius.data(), n) &&
+               offset == data.size();
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+
+
+TrajectoryEncoder::TrajectoryEncoder(const Config& config):
+    m_config(config),
+    m_previous(),
+    m_current(),
+    m_residuals(),
+    m_bits(),
+    m_sinceKeyframe(0)
+{
+
+}
+
+
+TrajectoryEncoder::~TrajectoryEncoder()
+{
+
+}
+
+
+TrajectoryFormat::Encoding TrajectoryEncoder::encode(const TrajectorySnapshot& snapshot, std::vector<char>& data)
+{
+    if (isDeltaPossible(snapshot) && encodeDelta(snapshot, data))
+    {
+        std::swap(m_previous, m_current);
+        m_sinceKeyframe++;
+
+        return TrajectoryFormat::Delta;
+    }
+    else
+    {
+        appendRaw(data, snapshot);
+
+        m_previous = snapshot;
+        m_sinceKeyframe = 1;
+
+        return TrajectoryFormat::Raw;
+    }
+}
+
+
+bool TrajectoryEncoder::isDeltaPossible(const TrajectorySnapshot& snapshot) const
+{
+    const std::size_t n = snapshot.size();
+
+    const bool lossy = m_config.xError > 0 && m_config.yError > 0 && m_config.vxError > 0 && m_config.vyError > 0;
+
+    return lossy &&
+           m_sinceKeyframe > 0 &&
+           m_sinceKeyframe < m_config.keyframeInterval &&
+           m_previous.size() == n &&
+           std::equal(snapshot.id.begin(), snapshot.id.end(), m_previous.id.begin()) &&
+           std::equal(snapshot.mass.begin(), snapshot.mass.end(), m_previous.mass.begin()) &&
+           std::equal(snapshot.radius.begin(), snapshot.radius.end(), m_previous.radius.begin());
+}
+
+
+bool TrajectoryEncoder::encodeDelta(const TrajectorySnapshot& snapshot, std::vector<char>& data)
+{
+    const std::size_t n = snapshot.size();
+    const BaseType dt = snapshot.time - m_previous.time;
+
+    const DeltaHeader header = { m_config.xError * 2, m_config.yError * 2, m_config.vxError * 2, m_config.vyError * 2 };
+
+    m_current.time = snapshot.time;
+    m_current.resize(n);
+    std::copy(snapshot.id.begin(), snapshot.id.end(), m_current.id.begin());
+    std::copy(snapshot.mass.begin(), snapshot.mass.end(), m_current.mass.begin());
+    std::copy(snapshot.radius.begin(), snapshot.radius.end(), m_current.radius.begin());
+
+    data.clear();
+    append(data, &header, 1);
+
+    const TrajectorySnapshot& previous = m_previous;
+    TrajectorySnapshot& current = m_current;
+
+    auto encode = [this, &data](const std::vector<BaseType>& values, BaseType step, const auto& predict, std::vector<BaseType>& restored)
+    {
+        if (quantizeColumn(values, step, predict, m_residuals) == false)
+            return false;
+
+        // continue with values which decoder will see
+        restoreColumn(m_residuals, step, predict, restored);
+
+        riceEncode(m_residuals, m_bits);
+
+        const std::uint64_t words = m_bits.size();
+        append(data, &words, 1);
+        append(data, m_bits.data(), m_bits.size());
+
+        return true;
+    };
+
+    return encode(snapshot.vx, header.vxStep, [&previous](std::size_t i) { return previous.vx[i]; }, current.vx) &&
+           encode(snapshot.vy, header.vyStep, [&previous](std::size_t i) { return previous.vy[i]; }, current.vy) &&
+           encode(snapshot.x, header.xStep, [&previous, &current, dt](std::size_t i) { return predictPosition(previous.x[i], previous.vx[i], current.vx[i], dt); }, current.x) &&
+           encode(snapshot.y, header.yStep, [&previous, &current, dt](std::size_t i) { return predictPosition(previous.y[i], previous.vy[i], current.vy[i], dt); }, current.y);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+
+
+TrajectoryDecoder::TrajectoryDecoder():
+    m_previous(),
+    m_residuals(),
+    m_hasPrevious(false)
+{
+
+}
+
+
+TrajectoryDecoder::~TrajectoryDecoder()
+{
+
+}
+
+
+bool TrajectoryDecoder::decode(const TrajectoryFormat::ChunkHeader& header, const std::vector<char>& data, TrajectorySnapshot& snapshot)
+{
+    const std::size_t n = header.objects;
+
+    if (header.columns != TrajectoryFormat::Columns)
+        return false;
+
+    bool status = false;
+
+    if (header.encoding == TrajectoryFormat::Raw)
+    {
+        snapshot.time = header.time;
+        snapshot.resize(n);
+
+        status = extractRaw(data, snapshot);
+    }
+    else if (header.encoding == TrajectoryFormat::Delta && m_hasPrevious && m_previous.size() == n)
+    {
+        const TrajectorySnapshot& previous = m_previous;
+        const BaseType dt = header.time - previous.time;
+
+        snapshot.time = header.time;
+        snapshot.resize(n);
+        std::copy(previous.id.begin(), previous.id.end(), snapshot.id.begin());
+        std::copy(previous.mass.begin(), previous.mass.end(), snapshot.mass.begin());
+        std::copy(previous.radius.begin(), previous.radius.end(), snapshot.radius.begin());
+
+        DeltaHeader steps;
+        std::size_t offset = 0;
+        std::vector<std::uint64_t> bits;
+
+        m_residuals.resize(n);
+
+        auto decode = [this, &data, &offset, &bits](BaseType step, const auto& predict, std::vector<BaseType>& column)
+        {
+            std::uint64_t words = 0;
+
+            const bool status = extract(data, offset, &words, 1) &&
+                                words <= (data.size() - offset) / sizeof(std::uint64_t);
+
+            if (status == false)
+                return false;
+
+            bits.resize(words);
+            extract(data, offset, bits.data(), words);
+
+            if (riceDecode(bits.data(), words, m_residuals) == false)
+                return false;
+
+            restoreColumn(m_residuals, step, predict, column);
+
+            return true;
+        };
+
+        status = extract(data, offset, &steps, 1) &&
+                 decode(steps.vxStep, [&previous](std::size_t i) { return previous.vx[i]; }, snapshot.vx) &&
+                 decode(steps.vyStep, [&previous](std::size_t i) { return previous.vy[i]; }, snapshot.vy) &&
+                 decode(steps.xStep, [&previous, &snapshot, dt](std::size_t i) { return predictPosition(previous.x[i], previous.vx[i], snapshot.vx[i], dt); }, snapshot.x) &&
+                 decode(steps.yStep, [&previous, &snapshot, dt](std::size_t i) { return predictPosition(previous.y[i], previous.vy[i], snapshot.vy[i], dt); }, snapshot.y) &&
+                 offset == data.size();
+    }
+
+    m_hasPrevious = status;
+
+    if (status)
+        m_previous = snapshot;
+
+    return status;
+}
+
+
+void TrajectoryDecoder::reset()
+{
+    m_hasPrevious = false;
+}
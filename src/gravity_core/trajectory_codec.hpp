@@ -0,0 +1,94 @@
+/*
+ * Compression of trajectories
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TRAJECTORYCODEC_HPP
+#define TRAJECTORYCODEC_HPP
+
+#include <vector>
+
+#include "trajectory.hpp"
+
+
+// Lossy compression of snapshots.
+//
+// Keyframes are stored as Raw chunks.
+// Between keyframes snapshots are stored as Delta chunks:
+// velocities and positions are predicted from previous snapshot (x + v·Δt),
+// differences between prediction and real values are quantized with step 2·error
+// (so each value is restored with given maximal error) and compressed with adaptive Rice coding.
+// Predictions are made from decoded (not original) values, so errors do not accumulate.
+//
+// Keyframe is emitted every 'keyframeInterval' snapshots and whenever set of objects,
+// their masses or radii change (collisions).
+class TrajectoryEncoder
+{
+    public:
+        struct Config
+        {
+            // maximal errors for x, y, vx and vy columns
+            BaseType xError = 1.0;
+            BaseType yError = 1.0;
+            BaseType vxError = 1e-3;
+            BaseType vyError = 1e-3;
+
+            unsigned int keyframeInterval = 64;
+        };
+
+        TrajectoryEncoder(const Config &);
+        TrajectoryEncoder(const TrajectoryEncoder &) = delete;
+        ~TrajectoryEncoder();
+
+        TrajectoryEncoder& operator=(const TrajectoryEncoder &) = delete;
+
+        TrajectoryFormat::Encoding encode(const TrajectorySnapshot &, std::vector<char>& data);      // returns encoding used for 'data'
+
+    private:
+        const Config m_config;
+        TrajectorySnapshot m_previous;                  // as seen by decoder
+        TrajectorySnapshot m_current;
+        std::vector<std::uint32_t> m_residuals;
+        std::vector<std::uint64_t> m_bits;
+        unsigned int m_sinceKeyframe;
+
+        bool isDeltaPossible(const TrajectorySnapshot &) const;
+        bool encodeDelta(const TrajectorySnapshot &, std::vector<char>& data);
+};
+
+
+// Decoder for chunks produced by TrajectoryEncoder (and raw ones).
+// Snapshots have to be decoded in order, starting from keyframe.
+class TrajectoryDecoder
+{
+    public:
+        TrajectoryDecoder();
+        TrajectoryDecoder(const TrajectoryDecoder &) = delete;
+        ~TrajectoryDecoder();
+
+        TrajectoryDecoder& operator=(const TrajectoryDecoder &) = delete;
+
+        bool decode(const TrajectoryFormat::ChunkHeader &, const std::vector<char>& data, TrajectorySnapshot &);
+        void reset();                                   // forget previous snapshot (before jumping to other keyframe)
+
+    private:
+        TrajectorySnapshot m_previous;
+        std::vector<std::uint32_t> m_residuals;
+        bool m_hasPrevious;
+};
+
+#endif // TRAJECTORYCODEC_HPP
@@ -0,0 +1,124 @@
+/*
+ * Reading of trajectory files
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "trajectory_reader.hpp"
+
+#include <cstring>
+
+
+TrajectoryReader::TrajectoryReader(const std::string& path):
+    m_file(path, std::ios::binary),
+    m_firstChunk(),
+    m_chunk(),
+    m_decoder(),
+    m_headerValid(false),
+    m_good(false)
+{
+    TrajectoryFormat::FileHeader header;
+    m_file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+    m_headerValid = m_file.good() &&
+                    std::memcmp(header.magic, TrajectoryFormat::Magic, sizeof(header.magic)) == 0 &&
+                    header.version >= 1 && header.version <= TrajectoryFormat::Version &&
+                    header.entrySize == sizeof(BaseType);
+
+    m_good = m_headerValid;
+    m_firstChunk = m_file.tellg();
+}
+
+
+TrajectoryReader::~TrajectoryReader()
+{
+
+}
+
+
+bool TrajectoryReader::good() const
+{
+    return m_good;
+}
+
+
+bool TrajectoryReader::next(TrajectorySnapshot& snapshot)
+{
+    TrajectoryFormat::ChunkHeader header;
+
+    if (m_good == false || readHeader(header) == false)
+        return false;
+
+    // compressed data should never be much bigger than raw one, protect against corrupted headers
+    if (header.bytes > 2 * (header.objects + 1) * TrajectoryFormat::Columns * sizeof(BaseType) + 1024)
+    {
+        m_good = false;
+        return false;
+    }
+
+    m_chunk.resize(header.bytes);
+    m_file.read(m_chunk.data(), header.bytes);
+
+    m_good = m_file.good() && m_decoder.decode(header, m_chunk, snapshot);
+
+    return m_good;
+}
+
+
+bool TrajectoryReader::seek(double time)
+{
+    if (m_headerValid == false || m_firstChunk == std::streampos(-1))
+        return false;
+
+    m_file.clear();
+    m_file.seekg(m_firstChunk);
+
+    // walk through chunks' headers only
+    std::streampos keyframe(-1);
+    TrajectoryFormat::ChunkHeader header;
+
+    for(;;)
+    {
+        const std::streampos position = m_file.tellg();
+
+        if (readHeader(header) == false || header.time > time)
+            break;
+
+        if (header.encoding == TrajectoryFormat::Raw)
+            keyframe = position;
+
+        m_file.seekg(header.bytes, std::ios::cur);
+    }
+
+    m_file.clear();
+    m_good = keyframe != std::streampos(-1);
+
+    if (m_good)
+    {
+        m_file.seekg(keyframe);
+        m_decoder.reset();
+    }
+
+    return m_good;
+}
+
+
+bool TrajectoryReader::readHeader(TrajectoryFormat::ChunkHeader& header)
+{
+    m_file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+    return m_file.good() && m_file.gcount() == sizeof(header);
+}
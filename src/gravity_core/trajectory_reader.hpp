@@ -0,0 +1,56 @@
+/*
+ * Reading of trajectory files
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TRAJECTORYREADER_HPP
+#define TRAJECTORYREADER_HPP
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "trajectory.hpp"
+#include "trajectory_codec.hpp"
+
+
+// Sequential reader of trajectory files
+class TrajectoryReader
+{
+    public:
+        TrajectoryReader(const std::string& path);
+        TrajectoryReader(const TrajectoryReader &) = delete;
+        ~TrajectoryReader();
+
+        TrajectoryReader& operator=(const TrajectoryReader &) = delete;
+
+        bool good() const;                          // false when file could not be opened or is not valid
+        bool next(TrajectorySnapshot &);            // read next snapshot. Returns false at the end of file or on error
+        bool seek(double time);                     // go to last keyframe at or before 'time'. Following next() starts there
+
+    private:
+        std::ifstream m_file;
+        std::streampos m_firstChunk;
+        std::vector<char> m_chunk;
+        TrajectoryDecoder m_decoder;
+        bool m_headerValid;                         // file header checked by constructor, seek() cannot fix it
+        bool m_good;
+
+        bool readHeader(TrajectoryFormat::ChunkHeader &);
+};
+
+#endif // TRAJECTORYREADER_HPP
@@ -0,0 +1,258 @@
+/*
+ * Background writer of trajectories
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "trajectory_writer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "objects.hpp"
+
+
+namespace
+{
+    template<typename T>
+    void writeColumn(std::ofstream& file, const std::vector<T>& column)
+    {
+        file.write(reinterpret_cast<const char *>(column.data()), column.size() * sizeof(T));
+    }
+}
+
+
+TrajectoryWriter::TrajectoryWriter(const std::string& path, const Config& config):
+    m_config(config),
+    m_file(path, std::ios::binary | std::ios::trunc),
+    m_ring(std::max<std::size_t>(config.buffers, 1)),
+    m_head(0),
+    m_tail(0),
+    m_queued(0),
+    m_closing(false),
+    m_failed(false),
+    m_nextCapture(0.0),
+    m_decimation(1),
+    m_captured(0),
+    m_dropped(0),
+    m_written(0),
+    m_mutex(),
+    m_queuedCondition(),
+    m_freeCondition(),
+    m_thread(),
+    m_encoder(config.codec),
+    m_chunk()
+{
+    // allocate all memory up front, so capture() does not need to
+    for(TrajectorySnapshot& snapshot: m_ring)
+        snapshot.resize(m_config.capacity);
+
+    TrajectoryFormat::FileHeader header;
+    std::memcpy(header.magic, TrajectoryFormat::Magic, sizeof(header.magic));
+    header.version = TrajectoryFormat::Version;
+    header.entrySize = sizeof(BaseType);
+
+    m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    m_failed = m_file.good() == false;
+
+    m_thread = std::thread(&TrajectoryWriter::writerLoop, this);
+}
+
+
+TrajectoryWriter::~TrajectoryWriter()
+{
+    close();
+}
+
+
+bool TrajectoryWriter::good() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_failed == false;
+}
+
+
+bool TrajectoryWriter::due(double time) const
+{
+    return time >= m_nextCapture;
+}
+
+
+bool TrajectoryWriter::capture(const Objects& objects, double time)
+{
+    if (due(time) == false)
+        return false;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    assert(m_closing == false);
+
+    const std::size_t buffers = m_ring.size();
+
+    if (m_queued == buffers)
+    {
+        switch (m_config.backpressure)
+        {
+            case Block:
+                m_freeCondition.wait(lock, [this, buffers]{ return m_queued < buffers; });
+                break;
+
+            case Decimate:
+                m_decimation *= 2;
+                // fall through
+
+            case Drop:
+                m_dropped++;
+                m_nextCapture = time + m_config.interval * m_decimation;
+                return false;
+        }
+    }
+    else if (m_config.backpressure == Decimate && m_decimation > 1 && m_queued < buffers / 2)
+        m_decimation /= 2;                      // writer keeps up again, go back to requested interval
+
+    TrajectorySnapshot& snapshot = m_ring[m_head];
+
+    // buffer is owned by this thread until it is queued, so copy data without lock
+    lock.unlock();
+    snapshot.assign(objects, time);
+    lock.lock();
+
+    m_head = (m_head + 1) % buffers;
+    m_queued++;
+    m_captured++;
+    m_nextCapture = time + m_config.interval * m_decimation;
+
+    m_queuedCondition.notify_one();
+
+    return true;
+}
+
+
+void TrajectoryWriter::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closing = true;
+    }
+
+    m_queuedCondition.notify_one();
+
+    if (m_thread.joinable())
+        m_thread.join();
+
+    if (m_file.is_open())
+    {
+        m_file.close();
+        m_failed |= m_file.fail();
+    }
+}
+
+
+std::size_t TrajectoryWriter::captured() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_captured;
+}
+
+
+std::size_t TrajectoryWriter::dropped() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_dropped;
+}
+
+
+std::size_t TrajectoryWriter::written() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_written;
+}
+
+
+unsigned int TrajectoryWriter::decimation() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_decimation;
+}
+
+
+void TrajectoryWriter::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for(;;)
+    {
+        m_queuedCondition.wait(lock, [this]{ return m_queued > 0 || m_closing; });
+
+        // write everything what was queued before closing
+        if (m_queued == 0)
+            break;
+
+        const TrajectorySnapshot& snapshot = m_ring[m_tail];
+
+        lock.unlock();
+        const bool status = write(snapshot);
+        lock.lock();
+
+        m_tail = (m_tail + 1) % m_ring.size();
+        m_queued--;
+        m_written += status? 1: 0;
+        m_failed |= !status;
+
+        m_freeCondition.notify_one();
+    }
+}
+
+
+bool TrajectoryWriter::write(const TrajectorySnapshot& snapshot)
+{
+    TrajectoryFormat::ChunkHeader header;
+    header.columns = TrajectoryFormat::Columns;
+    header.objects = snapshot.size();
+    header.time = snapshot.time;
+
+    if (m_config.compress)
+    {
+        header.encoding = m_encoder.encode(snapshot, m_chunk);
+        header.bytes = m_chunk.size();
+
+        m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        m_file.write(m_chunk.data(), m_chunk.size());
+    }
+    else
+    {
+        header.encoding = TrajectoryFormat::Raw;
+        header.bytes = header.objects * header.columns * sizeof(BaseType);
+
+        m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        writeColumn(m_file, snapshot.id);
+        writeColumn(m_file, snapshot.x);
+        writeColumn(m_file, snapshot.y);
+        writeColumn(m_file, snapshot.vx);
+        writeColumn(m_file, snapshot.vy);
+        writeColumn(m_file, snapshot.mass);
+        writeColumn(m_file, snapshot.radius);
+    }
+
+    return m_file.good();
+}
@@ -0,0 +1,108 @@
+/*
+ * Background writer of trajectories
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TRAJECTORYWRITER_HPP
+#define TRAJECTORYWRITER_HPP
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "trajectory.hpp"
+#include "trajectory_codec.hpp"
+
+class Objects;
+
+
+// Writes snapshots of objects to trajectory file (see TrajectoryFormat).
+// capture() only copies columns into one of preallocated buffers,
+// disk is accessed by separate thread, so simulation is not slowed down by I/O.
+class TrajectoryWriter
+{
+    public:
+        // What to do when all buffers are waiting for being written
+        enum Backpressure
+        {
+            Drop,           // skip snapshot
+            Block,          // wait for writer thread
+            Decimate,       // skip snapshot and lower capture frequency until writer catches up
+        };
+
+        struct Config
+        {
+            double interval = 0.0;                  // simulated time between snapshots (0 = capture each call)
+            std::size_t buffers = 4;                // size of snapshots ring
+            std::size_t capacity = 0;               // expected number of objects (for preallocation)
+            Backpressure backpressure = Drop;
+
+            bool compress = false;                  // use TrajectoryEncoder (lossy)
+            TrajectoryEncoder::Config codec;
+        };
+
+        TrajectoryWriter(const std::string& path, const Config &);
+        TrajectoryWriter(const TrajectoryWriter &) = delete;
+        ~TrajectoryWriter();
+
+        TrajectoryWriter& operator=(const TrajectoryWriter &) = delete;
+
+        bool good() const;                                      // false when file could not be opened or written
+
+        bool due(double time) const;                            // true if capture() at given time would take snapshot (or drop it)
+        bool capture(const Objects &, double time);             // take snapshot if its time has come. Returns true if snapshot was queued
+        void close();                                           // write all pending snapshots and close file
+
+        std::size_t captured() const;
+        std::size_t dropped() const;                            // snapshots lost due to backpressure
+        std::size_t written() const;
+        unsigned int decimation() const;                        // current interval multiplier (Decimate mode)
+
+    private:
+        const Config m_config;
+        std::ofstream m_file;
+
+        std::vector<TrajectorySnapshot> m_ring;
+        std::size_t m_head;                                     // next buffer to fill
+        std::size_t m_tail;                                     // next buffer to write
+        std::size_t m_queued;
+        bool m_closing;
+        bool m_failed;
+
+        double m_nextCapture;
+        unsigned int m_decimation;
+        std::size_t m_captured;
+        std::size_t m_dropped;
+        std::size_t m_written;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_queuedCondition;
+        std::condition_variable m_freeCondition;
+        std::thread m_thread;
+
+        // used by writer thread only
+        TrajectoryEncoder m_encoder;
+        std::vector<char> m_chunk;
+
+        void writerLoop();
+        bool write(const TrajectorySnapshot &);
+};
+
+#endif // TRAJECTORYWRITER_HPP
@@ -0,0 +1,91 @@
+/*
+ * Lock-free triple buffer for handing latest state between two threads
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <array>
+#include <atomic>
+
+
+// Single producer, single consumer exchange of the latest value.
+// Writer fills back() and publish()es it, reader calls update() and reads front().
+// Neither side blocks nor allocates: buffers are only swapped by index. When writer publishes
+// faster than reader consumes, older unread values are overwritten (dropped), never queued.
+template<typename T>
+class TripleBuffer
+{
+    public:
+        TripleBuffer():
+            m_buffers(),
+            m_back(0),
+            m_middle(1),
+            m_front(2)
+        {
+
+        }
+
+        TripleBuffer(const TripleBuffer &) = delete;
+        TripleBuffer& operator=(const TripleBuffer &) = delete;
+
+        // writer side
+        T& back()
+        {
+            return m_buffers[m_back];
+        }
+
+        void publish()
+        {
+            const unsigned previous = m_middle.exchange(m_back | Fresh, std::memory_order_acq_rel);
+            m_back = previous & IndexMask;
+        }
+
+        // reader side. Returns true when front() was replaced with newer value
+        bool update()
+        {
+            if ((m_middle.load(std::memory_order_relaxed) & Fresh) == 0)
+                return false;
+
+            const unsigned previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+            m_front = previous & IndexMask;
+
+            return true;
+        }
+
+        T& front()
+        {
+            return m_buffers[m_front];
+        }
+
+        const T& front() const
+        {
+            return m_buffers[m_front];
+        }
+
+    private:
+        static const unsigned Fresh = 4;            // middle buffer was published and not yet taken by reader
+        static const unsigned IndexMask = 3;
+
+        std::array<T, 3> m_buffers;
+        unsigned m_back;                            // owned by writer
+        std::atomic<unsigned> m_middle;             // index | Fresh
+        unsigned m_front;                           // owned by reader
+};
+
+#endif // TRIPLE_BUFFER_HPP
@@ -1,9 +1,13 @@
 
 #include <gmock/gmock.h>
 
+#include <omp.h>
+
 #include "../simulation_engine.hpp"
 #include "../accelerators/simple_cpu_accelerator.hpp"
 #include "../accelerators/avx_accelerator.hpp"
+#include "../accelerators/avx_blocks_accelerator.hpp"
+#include "../accelerators/tiled_cpu_accelerator.hpp"
 #include "../accelerators/opencl_accelerator.hpp"
 
 
@@ -103,12 +107,12 @@ TEST_F(AcceleratorsTestScenario1, SimpleCpuAccelerator)
     accelerator.setObjects(&objects);
 
     // verify forces correctness
-    const std::vector<XY> forces = accelerator.forces();
+    const std::vector<force_vector_t> forces = accelerator.forces();
 
     for(std::size_t i = 0; i < forces.size(); i++)
     {
-        EXPECT_DOUBLE_EQ( forces[i].x, forces_expected[i].x );
-        EXPECT_DOUBLE_EQ( forces[i].y, forces_expected[i].y );
+        EXPECT_DOUBLE_EQ( forces[i].x.raw_value(), forces_expected[i].x );
+        EXPECT_DOUBLE_EQ( forces[i].y.raw_value(), forces_expected[i].y );
     }
 
     // verify velocities for Δt = 0
@@ -138,12 +142,12 @@ TEST_F(AcceleratorsTestScenario1, AVXAccelerator)
     accelerator.setObjects(&objects);
 
     // verify forces correctness
-    const std::vector<XY> forces = accelerator.forces();
+    const std::vector<force_vector_t> forces = accelerator.forces();
 
     for(std::size_t i = 0; i < forces.size(); i++)
     {
-        EXPECT_DOUBLE_EQ( forces[i].x, forces_expected[i].x );
-        EXPECT_DOUBLE_EQ( forces[i].y, forces_expected[i].y );
+        EXPECT_DOUBLE_EQ( forces[i].x.raw_value(), forces_expected[i].x );
+        EXPECT_DOUBLE_EQ( forces[i].y.raw_value(), forces_expected[i].y );
     }
 
     // verify velocities for Δt = 0
@@ -164,3 +168,107 @@ TEST_F(AcceleratorsTestScenario1, AVXAccelerator)
         EXPECT_DOUBLE_EQ( velocities1[i].y, velocities1_expected[i].y );
     }
 }
+
+
+TEST_F(AcceleratorsTestScenario1, AVXAcceleratorRows)
+{
+    AVXAccelerator accelerator;
+
+    accelerator.setObjects(&objects);
+
+    // part of objects only (order of summation differs from forces(), so allow small relative error)
+    const std::size_t first = 5;
+    const std::size_t last = 20;
+    std::vector<force_vector_t> forces(last - first);
+
+    accelerator.forcesOn(first, last, forces.data());
+
+    for(std::size_t i = first; i < last; i++)
+    {
+        EXPECT_NEAR( forces[i - first].x.raw_value(), forces_expected[i].x, std::abs(forces_expected[i].x) * 1e-5 );
+        EXPECT_NEAR( forces[i - first].y.raw_value(), forces_expected[i].y, std::abs(forces_expected[i].y) * 1e-5 );
+    }
+}
+
+
+TEST_F(AcceleratorsTestScenario1, AVXBlocksAccelerator)
+{
+    AVXBlocksAccelerator accelerator;
+
+    accelerator.setObjects(&objects);
+
+    // verify forces correctness (order of summation differs from other accelerators, so allow small relative error)
+    const std::vector<force_vector_t> forces = accelerator.forces();
+
+    for(std::size_t i = 0; i < forces.size(); i++)
+    {
+        EXPECT_NEAR( forces[i].x.raw_value(), forces_expected[i].x, std::abs(forces_expected[i].x) * 1e-5 );
+        EXPECT_NEAR( forces[i].y.raw_value(), forces_expected[i].y, std::abs(forces_expected[i].y) * 1e-5 );
+    }
+
+    // verify velocities for Δt = 1
+    const std::vector<XY> velocities1 = accelerator.velocities(forces, 1);
+
+    for(std::size_t i = 0; i < velocities1.size(); i++)
+    {
+        EXPECT_NEAR( velocities1[i].x, velocities1_expected[i].x, std::abs(velocities1_expected[i].x) * 1e-5 );
+        EXPECT_NEAR( velocities1[i].y, velocities1_expected[i].y, std::abs(velocities1_expected[i].y) * 1e-5 );
+    }
+
+    // no collisions in this scenario
+    EXPECT_TRUE( accelerator.collisions().empty() );
+
+    // move 3rd object onto 20th one (different blocks) and 5th onto 6th (same block)
+    objects.setPos(3, objects.getPos(20));
+    objects.setPos(5, objects.getPos(6));
+
+    const std::vector<std::pair<int, int>> colided = accelerator.collisions();
+
+    ASSERT_EQ(colided.size(), 2);
+    EXPECT_THAT(colided, testing::UnorderedElementsAre(std::make_pair(3, 20), std::make_pair(5, 6)));
+}
+
+
+TEST_F(AcceleratorsTestScenario1, TiledCpuAccelerator)
+{
+    // tiny memory budget, so objects are split into many tiles
+    TiledCpuAccelerator accelerator(1);
+
+    accelerator.setObjects(&objects);
+
+    ASSERT_LT(accelerator.tileSize(), objects.size());
+
+    // verify forces correctness (order of summation differs from other accelerators, so allow small relative error)
+    const std::vector<force_vector_t> forces = accelerator.forces();
+
+    for(std::size_t i = 0; i < forces.size(); i++)
+    {
+        EXPECT_NEAR( forces[i].x.raw_value(), forces_expected[i].x, std::abs(forces_expected[i].x) * 1e-5 );
+        EXPECT_NEAR( forces[i].y.raw_value(), forces_expected[i].y, std::abs(forces_expected[i].y) * 1e-5 );
+    }
+
+    // no collisions in this scenario
+    EXPECT_TRUE( accelerator.collisions().empty() );
+
+    // move 3rd object onto 20th one (different tiles) and 5th onto 6th (same tile)
+    objects.setPos(3, objects.getPos(20));
+    objects.setPos(5, objects.getPos(6));
+
+    const std::vector<std::pair<int, int>> colided = accelerator.collisions();
+
+    ASSERT_EQ(colided.size(), 2);
+    EXPECT_THAT(colided, testing::UnorderedElementsAre(std::make_pair(3, 20), std::make_pair(5, 6)));
+}
+
+
+TEST_F(AcceleratorsTestScenario1, TiledCpuAcceleratorKeepsAllThreadsBusy)
+{
+    // default budget would fit all objects in one tile
+    TiledCpuAccelerator accelerator;
+    accelerator.setObjects(&objects);
+
+    const std::size_t threads = omp_get_max_threads();
+    const std::size_t perThread = (objects.size() + threads - 1) / threads;
+
+    EXPECT_LE(accelerator.tileSize(), std::max<std::size_t>(perThread, 8));
+}
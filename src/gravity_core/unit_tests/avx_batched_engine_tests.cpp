@@ -0,0 +1,79 @@
+
+#include <gmock/gmock.h>
+
+#include "../simulation_engine.hpp"
+#include "../accelerators/avx_batched_engine.hpp"
+#include "../accelerators/simple_cpu_accelerator.hpp"
+#include "scoped_omp_threads.hpp"
+
+
+namespace
+{
+    std::vector<Object> moons(int count, BaseType distance)
+    {
+        std::vector<Object> objects;
+        objects.push_back( Object(0, 0, 5.9736e24, 6371e3) );
+
+        for(int i = 1; i < count; i++)
+            objects.push_back( Object(distance * i, 0, 7.347673e22,  1737.1e3, 0, 1.022e3 * (i%2? 1: -1)) );
+
+        return objects;
+    }
+}
+
+
+TEST(AVXBatchedEngineTest, MatchesSimulationEngine)
+{
+    AVXBatchedEngine batched(12);
+
+    // each lane has different system, some of them with collisions
+    std::vector<std::vector<Object>> systems;
+    std::vector<double> durations;
+    for(int l = 0; l < AVXBatchedEngine::Lanes; l++)
+    {
+        systems.push_back( moons(5 + l, l % 3 == 0? 6e6: 38440e3) );
+        durations.push_back( 3600 * (1 + l % 4) );
+
+        batched.setObjects(l, systems.back());
+    }
+
+    const std::vector<int> steps = batched.stepBy(durations);
+
+    const ScopedOmpThreads singleThread(1);
+
+    for(int l = 0; l < AVXBatchedEngine::Lanes; l++)
+    {
+        SimpleCpuAccelerator accelerator;
+        SimulationEngine engine(&accelerator);
+
+        for(const Object& obj: systems[l])
+            engine.addObject(obj);
+
+        EXPECT_EQ(steps[l], engine.stepBy(durations[l]));
+
+        // SimulationEngine reorders objects when collision happens, so compare by id
+        Objects lane;
+        batched.objects(l, lane);
+
+        const Objects& expected = engine.objects();
+        ASSERT_EQ(lane.size(), expected.size());
+        ASSERT_EQ(batched.objectCount(l), expected.size());
+
+        for(std::size_t i = 0; i < expected.size(); i++)
+        {
+            std::size_t j = 0;
+            while(j < lane.size() && lane.getId()[j] != expected.getId()[i])
+                j++;
+
+            ASSERT_LT(j, lane.size());
+
+            // SimulationEngine mixes doubles into some of calculations, so allow small error
+            EXPECT_NEAR(lane.getX()[j], expected.getX()[i], std::abs(expected.getX()[i]) * 1e-4 + 1.0);
+            EXPECT_NEAR(lane.getY()[j], expected.getY()[i], std::abs(expected.getY()[i]) * 1e-4 + 1.0);
+            EXPECT_NEAR(lane.getVX()[j], expected.getVX()[i], std::abs(expected.getVX()[i]) * 1e-4 + 1e-3);
+            EXPECT_NEAR(lane.getVY()[j], expected.getVY()[i], std::abs(expected.getVY()[i]) * 1e-4 + 1e-3);
+            EXPECT_FLOAT_EQ(lane.getMass()[j], expected.getMass()[i]);
+            EXPECT_FLOAT_EQ(lane.getRadius()[j], expected.getRadius()[i]);
+        }
+    }
+}
@@ -0,0 +1,115 @@
+
+#include <gmock/gmock.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "../checkpoint.hpp"
+#include "../simulation_engine.hpp"
+#include "../accelerators/simple_cpu_accelerator.hpp"
+#include "scoped_omp_threads.hpp"
+
+
+namespace
+{
+    void expectEqual(const Objects& lhs, const Objects& rhs)
+    {
+        ASSERT_EQ(lhs.size(), rhs.size());
+
+        for(std::size_t i = 0; i < lhs.size(); i++)
+        {
+            EXPECT_EQ(lhs.getId()[i], rhs.getId()[i]);
+            EXPECT_EQ(lhs.getX()[i], rhs.getX()[i]);
+            EXPECT_EQ(lhs.getY()[i], rhs.getY()[i]);
+            EXPECT_EQ(lhs.getVX()[i], rhs.getVX()[i]);
+            EXPECT_EQ(lhs.getVY()[i], rhs.getVY()[i]);
+            EXPECT_EQ(lhs.getMass()[i], rhs.getMass()[i]);
+            EXPECT_EQ(lhs.getRadius()[i], rhs.getRadius()[i]);
+        }
+    }
+}
+
+
+TEST(CheckpointTest, RestoresEngineState)
+{
+    const std::string path = "checkpoint_test.bin";
+
+    const ScopedOmpThreads singleThread(1);
+
+    SimpleCpuAccelerator accelerator;
+    SimulationEngine engine(&accelerator);
+
+    engine.addObject( Object(0, 0, 5.9736e24, 6371e3) );
+    for(int i = 1; i < 50; i++)
+        engine.addObject( Object(384400e3 * i / 10, 0, 7.347673e22, 1737.1e3, 0, 1.022e3 * (i % 2? 1: -1)) );
+
+    engine.stepBy(3600);
+
+    ASSERT_TRUE(Checkpoint::save(engine, path));
+
+    SimpleCpuAccelerator restoredAccelerator;
+    std::unique_ptr<SimulationEngine> restored = Checkpoint::restore(path, &restoredAccelerator);
+    std::remove(path.c_str());
+
+    ASSERT_NE(restored, nullptr);
+    expectEqual(restored->objects(), engine.objects());
+
+    // both engines continue the same way
+    EXPECT_EQ(restored->stepBy(3600), engine.stepBy(3600));
+    expectEqual(restored->objects(), engine.objects());
+
+    // restored engine can grow beyond checkpoint and keeps assigning unique ids
+    const Object obj(1e10, 1e10, 1e20, 1e3);
+    EXPECT_EQ(restored->addObject(obj), engine.addObject(obj));
+    expectEqual(restored->objects(), engine.objects());
+}
+
+
+TEST(CheckpointTest, ContinuesSimulatedTime)
+{
+    const std::string path = "checkpoint_test_time.bin";
+
+    const ScopedOmpThreads singleThread(1);
+
+    SimpleCpuAccelerator accelerator;
+    SimulationEngine engine(&accelerator);
+
+    engine.addObject( Object(0, 0, 5.9736e24, 6371e3) );
+    engine.addObject( Object(384400e3, 0, 7.347673e22, 1737.1e3, 0, 1.022e3) );
+
+    EXPECT_EQ(engine.simulatedTime(), 0.0);
+
+    engine.stepBy(20000);
+    const double saved = engine.simulatedTime();
+    EXPECT_GE(saved, 20000.0);
+
+    ASSERT_TRUE(Checkpoint::save(engine, path));
+
+    SimpleCpuAccelerator restoredAccelerator;
+    std::unique_ptr<SimulationEngine> restored = Checkpoint::restore(path, &restoredAccelerator);
+    std::remove(path.c_str());
+
+    ASSERT_NE(restored, nullptr);
+    EXPECT_EQ(restored->simulatedTime(), saved);
+
+    // time keeps counting from checkpoint
+    restored->stepBy(5000);
+    engine.stepBy(5000);
+
+    EXPECT_EQ(restored->simulatedTime(), engine.simulatedTime());
+    EXPECT_GE(restored->simulatedTime(), saved + 5000.0);
+}
+
+
+TEST(CheckpointTest, RejectsInvalidFiles)
+{
+    const std::string path = "checkpoint_test_invalid.bin";
+
+    std::ofstream(path) << "definitely not a checkpoint";
+
+    SimpleCpuAccelerator accelerator;
+    EXPECT_EQ(Checkpoint::restore(path, &accelerator), nullptr);
+    EXPECT_EQ(Checkpoint::restore(path + ".missing", &accelerator), nullptr);
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,69 @@
+
+#include <gmock/gmock.h>
+
+#include "../ensemble.hpp"
+#include "../simulation_engine.hpp"
+#include "../accelerators/simple_cpu_accelerator.hpp"
+#include "scoped_omp_threads.hpp"
+
+
+namespace
+{
+    std::vector<Object> moons(int count)
+    {
+        std::vector<Object> objects;
+        objects.push_back( Object(0, 0, 5.9736e24, 6371e3) );
+
+        for(int i = 1; i < count; i++)
+            objects.push_back( Object(384400e3 * i/10, 0, 7.347673e22,  1737.1e3, 0, 1.022e3 * (i%2? 1: -1)) );
+
+        return objects;
+    }
+}
+
+
+TEST(EnsembleTest, MatchesStandaloneSimulations)
+{
+    Ensemble ensemble([]{ return std::make_unique<SimpleCpuAccelerator>(); });
+
+    for(int s = 0; s < 40; s++)
+        ensemble.addSimulation(moons(2 + s % 7), 3600 * (1 + s % 3));
+
+    ASSERT_EQ(ensemble.size(), 40);
+
+    const EnsembleResults results = ensemble.run(3);
+
+    ASSERT_EQ(results.simulations(), 40);
+    ASSERT_EQ(results.offsets.size(), 41);
+
+    // ensemble runs each simulation with one thread, do the same here to get identical results
+    const ScopedOmpThreads singleThread(1);
+
+    for(int s = 0; s < 40; s++)
+    {
+        SimpleCpuAccelerator accelerator;
+        SimulationEngine engine(&accelerator);
+
+        for(const Object& obj: moons(2 + s % 7))
+            engine.addObject(obj);
+
+        const int steps = engine.stepBy(3600 * (1 + s % 3));
+        const Objects& objects = engine.objects();
+
+        EXPECT_EQ(results.steps[s], steps);
+        ASSERT_EQ(results.offsets[s + 1] - results.offsets[s], objects.size());
+
+        for(std::size_t i = 0; i < objects.size(); i++)
+        {
+            const std::size_t r = results.offsets[s] + i;
+
+            EXPECT_EQ(results.id[r], objects.getId()[i]);
+            EXPECT_EQ(results.x[r], objects.getX()[i]);
+            EXPECT_EQ(results.y[r], objects.getY()[i]);
+            EXPECT_EQ(results.vx[r], objects.getVX()[i]);
+            EXPECT_EQ(results.vy[r], objects.getVY()[i]);
+            EXPECT_EQ(results.mass[r], objects.getMass()[i]);
+            EXPECT_EQ(results.radius[r], objects.getRadius()[i]);
+        }
+    }
+}
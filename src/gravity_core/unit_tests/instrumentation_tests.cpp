@@ -0,0 +1,107 @@
+
+#include <gmock/gmock.h>
+
+#include "../instrumentation.hpp"
+#include "../simulation_engine.hpp"
+#include "../accelerators/simple_cpu_accelerator.hpp"
+
+
+namespace
+{
+    void addMoons(SimulationEngine& engine)
+    {
+        engine.addObject( Object(0, 0, 5.9736e24, 6371e3) );
+
+        for(int i = 1; i < 8; i++)
+            engine.addObject( Object(384400e3 * i/10, 0, 7.347673e22,  1737.1e3, 0, 1.022e3) );
+    }
+}
+
+
+TEST(RollingHistogramTest, BucketsAreLogarithmic)
+{
+    EXPECT_EQ(RollingHistogram::bucket(0.0), 0);
+    EXPECT_EQ(RollingHistogram::bucket(0.99), 0);
+    EXPECT_EQ(RollingHistogram::bucket(1.0), 1);
+    EXPECT_EQ(RollingHistogram::bucket(1.99), 1);
+    EXPECT_EQ(RollingHistogram::bucket(2.0), 2);
+    EXPECT_EQ(RollingHistogram::bucket(1000.0), 10);
+    EXPECT_EQ(RollingHistogram::bucket(1e30), RollingHistogram::Buckets - 1);
+}
+
+
+TEST(RollingHistogramTest, KeepsOnlyLastSamples)
+{
+    RollingHistogram histogram(4);
+
+    for(double v: {1000.0, 1000.0, 1000.0, 1000.0})
+        histogram.add(v);
+
+    for(double v: {3.0, 3.0, 3.0, 5.0})
+        histogram.add(v);
+
+    const RollingHistogram::Summary summary = histogram.summary();
+
+    EXPECT_EQ(summary.samples, 4);
+    EXPECT_DOUBLE_EQ(summary.last, 5.0);
+    EXPECT_DOUBLE_EQ(summary.mean, 3.5);
+    EXPECT_DOUBLE_EQ(summary.max, 5.0);
+    EXPECT_DOUBLE_EQ(summary.p50, 4.0);                 // upper bound of [2, 4) bucket
+    EXPECT_DOUBLE_EQ(summary.p95, 5.0);                 // clamped to max
+
+    EXPECT_EQ(histogram.buckets()[RollingHistogram::bucket(1000.0)], 0);
+    EXPECT_EQ(histogram.buckets()[RollingHistogram::bucket(3.0)], 3);
+}
+
+
+TEST(InstrumentationTest, RecordsNothingWhenDisabled)
+{
+    SimpleCpuAccelerator accelerator;
+    SimulationEngine engine(&accelerator);
+    addMoons(engine);
+
+    engine.stepBy(3600);
+
+    const Instrumentation::Snapshot snapshot = engine.instrumentation().snapshot();
+
+    for(const RollingHistogram::Summary& summary: snapshot)
+        EXPECT_EQ(summary.samples, 0);
+}
+
+
+TEST(InstrumentationTest, RecordsEachPhaseOfStep)
+{
+    SimpleCpuAccelerator accelerator;
+    SimulationEngine engine(&accelerator);
+    addMoons(engine);
+
+    // fast object: 60s of initial dt makes it travel too far, so dt needs to be adjusted
+    engine.addObject( Object(-384400e3, 0, 7.347673e22,  1737.1e3, 0, 5e3) );
+
+    engine.instrumentation().setEnabled(true);
+
+    const int steps = engine.stepBy(3600);
+
+    const Instrumentation::Snapshot snapshot = engine.instrumentation().snapshot();
+
+    EXPECT_EQ(snapshot[Instrumentation::Step].samples, steps);
+    EXPECT_EQ(snapshot[Instrumentation::Forces].samples, steps);
+    EXPECT_EQ(snapshot[Instrumentation::Integration].samples, steps);
+    EXPECT_EQ(snapshot[Instrumentation::Retries].samples, steps);
+    EXPECT_EQ(snapshot[Instrumentation::CollisionDetection].samples, steps);
+    EXPECT_EQ(snapshot[Instrumentation::CollisionResolution].samples, steps);
+    EXPECT_EQ(snapshot[Instrumentation::Observers].samples, 1);
+
+    EXPECT_GT(snapshot[Instrumentation::Retries].max, 0.0);
+
+    // phases are parts of step
+    const double phases = snapshot[Instrumentation::Forces].mean +
+                          snapshot[Instrumentation::Integration].mean +
+                          snapshot[Instrumentation::CollisionDetection].mean +
+                          snapshot[Instrumentation::CollisionResolution].mean;
+
+    EXPECT_LE(phases, snapshot[Instrumentation::Step].mean);
+
+    engine.instrumentation().clear();
+    EXPECT_EQ(engine.instrumentation().summary(Instrumentation::Step).samples, 0);
+}
@@ -0,0 +1,81 @@
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+#include <gmock/gmock.h>
+
+#include "../objects.hpp"
+#include "../accelerators/multi_opencl_accelerator.hpp"
+#include "../accelerators/simple_cpu_accelerator.hpp"
+
+
+namespace
+{
+    // random cloud with some overlapping pairs
+    void fill(Objects& objects, int count)
+    {
+        std::mt19937 generator(1);
+        std::uniform_real_distribution<BaseType> position(-1e12, 1e12);
+
+        for(int i = 0; i < count; i++)
+        {
+            const BaseType x = position(generator);
+            const BaseType y = position(generator);
+
+            objects.insert( Object(x, y, 5.9736e24, 6371e3), i );
+
+            if (i % 100 == 0)
+                objects.insert( Object(x + 1000e3, y, 7.347673e22, 1737.1e3), ++i );
+        }
+    }
+}
+
+
+TEST(MultiOpenCLAcceleratorTest, SubDevicesMatchCpu)
+{
+    // two devices made of one CPU with device fission
+    const std::vector<boost::compute::device> devices = MultiOpenCLAccelerator::cpuSubDevices(2);
+
+    if (devices.size() < 2)
+        GTEST_SKIP() << "no CPU OpenCL device supporting device fission";
+
+    Objects objects;
+    fill(objects, 3000);
+
+    MultiOpenCLAccelerator multi(&objects, devices);
+    SimpleCpuAccelerator cpu(&objects);
+
+    const std::vector<force_vector_t> expected = cpu.forces();
+
+    // split is rebalanced in the meantime, results must not change
+    for(int step = 0; step < 2 * MultiOpenCLAccelerator::RebalanceInterval + 1; step++)
+    {
+        const std::vector<force_vector_t> forces = multi.forces();
+
+        ASSERT_EQ(forces.size(), expected.size());
+
+        for(std::size_t i = 0; i < forces.size(); i++)
+        {
+            const double x = expected[i].x.raw_value();
+            const double y = expected[i].y.raw_value();
+            const double tolerance = 1e-3 * std::sqrt(x * x + y * y);
+
+            EXPECT_NEAR(forces[i].x.raw_value(), x, tolerance);
+            EXPECT_NEAR(forces[i].y.raw_value(), y, tolerance);
+        }
+    }
+
+    const std::vector<double> shares = multi.shares();
+    ASSERT_EQ(shares.size(), 2);
+    EXPECT_GT(shares[0], 0.0);
+    EXPECT_GT(shares[1], 0.0);
+    EXPECT_NEAR(std::accumulate(shares.begin(), shares.end(), 0.0), 1.0, 1e-9);
+
+    std::vector<std::pair<int, int>> expectedCollisions = cpu.collisions();
+    std::sort(expectedCollisions.begin(), expectedCollisions.end());
+
+    EXPECT_FALSE(expectedCollisions.empty());
+    EXPECT_EQ(multi.collisions(), expectedCollisions);
+}
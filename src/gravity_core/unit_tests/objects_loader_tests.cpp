@@ -0,0 +1,150 @@
+
+#include <gmock/gmock.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "../objects_loader.hpp"
+#include "../simulation_engine.hpp"
+#include "../accelerators/simple_cpu_accelerator.hpp"
+
+
+namespace
+{
+    struct SimulationEventsMock: ISimulationEvents
+    {
+        MOCK_METHOD2(objectsColided, void(const Object &, const Object &));
+        MOCK_METHOD2(objectCreated, void(int, const Object &));
+        MOCK_METHOD1(objectAnnihilated, void(const Object &));
+        MOCK_METHOD2(objectUpdated, void(int, const Object &));
+        MOCK_METHOD3(objectsCreated, void(const Objects &, std::size_t, std::size_t));
+    };
+
+    void expectObject(const Objects& objects, std::size_t i, int id, BaseType v)
+    {
+        EXPECT_EQ(objects.getId()[i], id);
+        EXPECT_EQ(objects.getX()[i], v);
+        EXPECT_EQ(objects.getY()[i], -v);
+        EXPECT_EQ(objects.getVX()[i], v / 4);
+        EXPECT_EQ(objects.getVY()[i], 0.5);
+        EXPECT_EQ(objects.getMass()[i], BaseType(1e20));
+        EXPECT_EQ(objects.getRadius()[i], v + 1);
+    }
+}
+
+
+TEST(ObjectsLoaderTest, LoadsCsvInParallel)
+{
+    const std::string path = "objects_loader_test.csv";
+
+    {
+        std::ofstream file(path);
+        file << "x, y, vx, vy, mass, radius\n";
+        file << "# comment\n\n";
+
+        for(int i = 0; i < 1000; i++)
+            file << i << "," << -i << ", " << i / 4.0 << " ,0.5,1e20,\t" << i + 1 << (i % 7 == 0? "\r\n": "\n");
+    }
+
+    SimpleCpuAccelerator accelerator;
+    SimulationEngine engine(&accelerator);
+    engine.addObject( Object(0, 0, 1, 1) );
+
+    SimulationEventsMock events;
+    engine.addEventsObserver(&events);
+
+    EXPECT_CALL(events, objectsCreated(testing::Ref(engine.objects()), 1, 1000)).Times(1);
+
+    ObjectsLoader loader(4);
+    ASSERT_TRUE(loader.open(path, ObjectsLoader::Csv));
+    EXPECT_EQ(loader.count(), 1000);
+
+    const int firstId = engine.addObjects(loader.count(), [&loader](Objects& objects, std::size_t first)
+    {
+        return loader.load(objects, first);
+    });
+
+    EXPECT_EQ(firstId, 2);
+    ASSERT_EQ(engine.objectCount(), 1001);
+
+    for(int i = 0; i < 1000; i++)
+        expectObject(engine.objects(), i + 1, i + 2, i);
+
+    std::remove(path.c_str());
+}
+
+
+TEST(ObjectsLoaderTest, ReportsInvalidCsvLine)
+{
+    const std::string path = "objects_loader_invalid_test.csv";
+
+    std::ofstream(path) << "1,2,3,4,5,6\n1,2,3,4,5,6\n1,2,3,x,5,6\n";
+
+    SimpleCpuAccelerator accelerator;
+    SimulationEngine engine(&accelerator);
+
+    ObjectsLoader loader(2);
+    ASSERT_TRUE(loader.open(path, ObjectsLoader::Csv));
+
+    const int firstId = engine.addObjects(loader.count(), [&loader](Objects& objects, std::size_t first)
+    {
+        return loader.load(objects, first);
+    });
+
+    EXPECT_EQ(firstId, 0);
+    EXPECT_EQ(engine.objectCount(), 0);
+    EXPECT_EQ(loader.error(), "Invalid object description in line 3");
+
+    std::remove(path.c_str());
+}
+
+
+TEST(ObjectsLoaderTest, ReportsInvalidFirstCsvLine)
+{
+    const std::string path = "objects_loader_invalid_first_test.csv";
+
+    // malformed first object is not mistaken for a header
+    std::ofstream(path) << "# comment\n1,2,3,4,5\n1,2,3,4,5,6\n";
+
+    Objects objects;
+
+    ObjectsLoader loader(1);
+    ASSERT_TRUE(loader.open(path, ObjectsLoader::Csv));
+    ASSERT_EQ(loader.count(), 2);
+
+    objects.resize(loader.count());
+    EXPECT_FALSE(loader.load(objects, 0));
+    EXPECT_EQ(loader.error(), "Invalid object description in line 2");
+
+    std::remove(path.c_str());
+}
+
+
+TEST(ObjectsLoaderTest, LoadsBinary)
+{
+    const std::string path = "objects_loader_test.bin";
+
+    Objects source;
+    for(int i = 0; i < 1000; i++)
+        source.insert( Object(i, -i, 1e20, i + 1, i / 4.0, 0.5), 0 );
+
+    ASSERT_TRUE(ObjectsLoader::saveBinary(source, path));
+
+    SimpleCpuAccelerator accelerator;
+    SimulationEngine engine(&accelerator);
+
+    ObjectsLoader loader;
+    ASSERT_TRUE(loader.open(path, ObjectsLoader::Binary));
+    ASSERT_EQ(loader.count(), 1000);
+
+    EXPECT_EQ(engine.addObjects(loader.count(), [&loader](Objects& objects, std::size_t first) { return loader.load(objects, first); }), 1);
+
+    ASSERT_EQ(engine.objectCount(), 1000);
+
+    for(int i = 0; i < 1000; i++)
+        expectObject(engine.objects(), i, i + 1, i);
+
+    EXPECT_FALSE(loader.open(path + ".missing", ObjectsLoader::Binary));
+
+    std::remove(path.c_str());
+}
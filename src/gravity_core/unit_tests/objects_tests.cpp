@@ -0,0 +1,133 @@
+
+#include <gmock/gmock.h>
+
+#include <fstream>
+
+#include "../objects.hpp"
+#include "../objects_blocks.hpp"
+
+
+TEST(ObjectsTest, GrowsKeepingData)
+{
+    Objects objects(3, MemoryArena::HugePages);
+
+    EXPECT_EQ(objects.capacity(), 3);
+
+    for(int i = 0; i < 1000; i++)
+        objects.insert( Object(i, -i, 1e20 + i, 1e3 + i, i * 2, -i * 2), i + 1 );
+
+    EXPECT_GE(objects.capacity(), 1000);
+    ASSERT_EQ(objects.size(), 1000);
+    ASSERT_EQ(objects.getX().size(), 1000);
+
+    for(int i = 0; i < 1000; i++)
+    {
+        EXPECT_EQ(objects.getId()[i], i + 1);
+        EXPECT_EQ(objects.getX()[i], i);
+        EXPECT_EQ(objects.getY()[i], -i);
+        EXPECT_EQ(objects.getVX()[i], i * 2);
+        EXPECT_EQ(objects.getVY()[i], -i * 2);
+        EXPECT_EQ(objects.getMass()[i], BaseType(1e20 + i));
+        EXPECT_EQ(objects.getRadius()[i], BaseType(1e3 + i));
+    }
+
+    // columns are aligned for aligned SIMD loads
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(objects.getMass().data()) % 64, 0);
+
+    objects.erase(0);
+
+    EXPECT_EQ(objects.size(), 999);
+    EXPECT_EQ(objects.getId()[0], 1000);
+    EXPECT_EQ(objects.getRadius()[0], BaseType(1e3 + 999));
+}
+
+
+TEST(ObjectsTest, WorksOnMappedFile)
+{
+    const std::string path = "objects_test_arena.bin";
+
+    Objects objects(std::make_unique<MappedFileArena>(path, 0), 10);
+
+    for(int i = 0; i < 100000; i++)
+        objects.insert( Object(i, -i, 1e20 + i, 1e3 + i, i * 2, -i * 2), i + 1 );
+
+    ASSERT_EQ(objects.size(), 100000);
+
+    for(int i = 0; i < 100000; i++)
+    {
+        EXPECT_EQ(objects.getId()[i], i + 1);
+        EXPECT_EQ(objects.getX()[i], i);
+        EXPECT_EQ(objects.getVY()[i], -i * 2);
+        EXPECT_EQ(objects.getRadius()[i], BaseType(1e3 + i));
+    }
+
+    // file is used as scratch space only
+    EXPECT_FALSE(std::ifstream(path).good());
+}
+
+
+TEST(ObjectsBlocksTest, MirrorsObjects)
+{
+    Objects objects;
+    ObjectsBlocks<8> blocks;
+
+    for(int i = 0; i < 21; i++)
+    {
+        const Object obj(i * 10.0, -i * 10.0, 1e20 + i, 1e3 + i, i, -i);
+
+        objects.insert(obj, i + 1);
+        blocks.insert(obj, i + 1);
+    }
+
+    ASSERT_EQ(blocks.size(), 21);
+    EXPECT_EQ(blocks.blocks(), 3);
+
+    // erase from the middle, from the last block and the last one
+    for(std::size_t idx: {4, 17, 18})
+    {
+        objects.erase(idx);
+        blocks.erase(idx);
+    }
+
+    ASSERT_EQ(blocks.size(), objects.size());
+
+    for(std::size_t i = 0; i < objects.size(); i++)
+    {
+        const Object o = objects[i];
+        const Object b = blocks[i];
+
+        EXPECT_EQ(b.id(), o.id());
+        EXPECT_EQ(b.pos().x, o.pos().x);
+        EXPECT_EQ(b.pos().y, o.pos().y);
+        EXPECT_EQ(b.mass().raw_value(), o.mass().raw_value());
+        EXPECT_EQ(b.radius(), o.radius());
+        EXPECT_EQ(b.velocity().x.raw_value(), o.velocity().x.raw_value());
+        EXPECT_EQ(b.velocity().y.raw_value(), o.velocity().y.raw_value());
+    }
+
+    // lanes after last object are empty (there are none when last block is full)
+    const std::size_t used = blocks.size() % blocks.width;
+    if (used != 0)
+    {
+        const auto& last = blocks.block(blocks.blocks() - 1);
+        for(std::size_t l = used; l < blocks.width; l++)
+        {
+            EXPECT_EQ(last.mass[l], 0.0);
+            EXPECT_EQ(last.radius[l], 0.0);
+        }
+    }
+
+    // assignment gives the same result
+    ObjectsBlocks<16> assigned;
+    assigned.assign(objects);
+
+    ASSERT_EQ(assigned.size(), objects.size());
+    EXPECT_EQ(assigned.blocks(), 2);
+
+    for(std::size_t i = 0; i < objects.size(); i++)
+    {
+        EXPECT_EQ(assigned[i].id(), objects[i].id());
+        EXPECT_EQ(assigned.getPos(i).x, objects.getPos(i).x);
+        EXPECT_EQ(assigned.getVelocity(i).y, objects.getVelocity(i).y);
+    }
+}
@@ -0,0 +1,189 @@
+
+#include <cmath>
+#include <random>
+
+#include <gmock/gmock.h>
+
+#include "../simulation_engine.hpp"
+#include "../accelerators/opencl_accelerator.hpp"
+#include "../accelerators/simple_cpu_accelerator.hpp"
+
+#ifdef GRAVITY_AVX_ACCELERATOR
+#include "../accelerators/hybrid_accelerator.hpp"
+#endif
+
+
+namespace
+{
+    bool haveDevice()
+    {
+        return boost::compute::system::device_count() > 0;
+    }
+
+
+    void addObjects(SimulationEngine& engine)
+    {
+        engine.addObject( Object(0, 0, 5.9736e24, 6371e3) );
+
+        for(int i = 1; i < 40; i++)
+            engine.addObject( Object(384400e3 * i/10, 0, 7.347673e22,  1737.1e3, 0, 1.022e3 * (i % 2? 1: -1)) );
+
+        // pair on collision course
+        engine.addObject( Object(-200000e3, 0, 7.347673e22,  1737.1e3, 0, 0) );
+        engine.addObject( Object(-200000e3, 20000e3, 7.347673e22,  1737.1e3, 0, -2e3) );
+    }
+
+
+    // random cloud
+    void fill(Objects& objects, std::size_t count)
+    {
+        std::mt19937 generator(1);
+        std::uniform_real_distribution<BaseType> position(-1e12, 1e12);
+
+        for(std::size_t i = 0; i < count; i++)
+            objects.insert( Object(position(generator), position(generator), 5.9736e24, 6371e3), i + 1 );
+    }
+
+
+    // first forces.size() entries of expected
+    void expectNear(const std::vector<force_vector_t>& forces, const std::vector<force_vector_t>& expected)
+    {
+        ASSERT_LE(forces.size(), expected.size());
+
+        for(std::size_t i = 0; i < forces.size(); i++)
+        {
+            const double x = expected[i].x.raw_value();
+            const double y = expected[i].y.raw_value();
+            const double tolerance = 1e-3 * std::sqrt(x * x + y * y);
+
+            EXPECT_NEAR(forces[i].x.raw_value(), x, tolerance) << "object " << i;
+            EXPECT_NEAR(forces[i].y.raw_value(), y, tolerance) << "object " << i;
+        }
+    }
+
+
+    // device computes in different order, so results are close but not equal
+    void expectNear(const Objects& objects, const Objects& expected)
+    {
+        const double positionTolerance = 1e-3 * 384400e3;
+        const double velocityTolerance = 1e-2 * 1.022e3;
+
+        ASSERT_EQ(objects.size(), expected.size());
+
+        for(std::size_t i = 0; i < expected.size(); i++)
+        {
+            EXPECT_EQ(objects.getId()[i], expected.getId()[i]);
+            EXPECT_NEAR(objects.getX()[i], expected.getX()[i], positionTolerance);
+            EXPECT_NEAR(objects.getY()[i], expected.getY()[i], positionTolerance);
+            EXPECT_NEAR(objects.getVX()[i], expected.getVX()[i], velocityTolerance);
+            EXPECT_NEAR(objects.getVY()[i], expected.getVY()[i], velocityTolerance);
+            EXPECT_EQ(objects.getMass()[i], expected.getMass()[i]);
+        }
+    }
+}
+
+
+TEST(OpenCLAcceleratorTest, ResidentStepMatchesCpu)
+{
+    if (haveDevice() == false)
+        GTEST_SKIP() << "no OpenCL device";
+
+    SimpleCpuAccelerator cpu;
+    SimulationEngine engine(&cpu);
+    addObjects(engine);
+
+    OpenCLAccelerator opencl;
+    SimulationEngine residentEngine(&opencl);
+    residentEngine.setDeviceResident(true);
+    addObjects(residentEngine);
+
+    // objects() downloads device state between rounds, following steps continue on swapped buffers
+    for(int round = 0; round < 4; round++)
+    {
+        engine.stepBy(3600);
+        residentEngine.stepBy(3600);
+
+        expectNear(residentEngine.objects(), engine.objects());
+    }
+
+    EXPECT_LT(engine.objectCount(), 42u);                       // collision happened
+    EXPECT_EQ(residentEngine.objectCount(), engine.objectCount());
+}
+
+
+TEST(OpenCLAcceleratorTest, PipelinedForcesMatchCpu)
+{
+    if (haveDevice() == false)
+        GTEST_SKIP() << "no OpenCL device";
+
+    // single chunk, exactly PipelineChunks chunks of minimal size, and chunks bigger than minimal with uneven last one
+    const std::size_t pipelined = OpenCLAccelerator::PipelineChunks * OpenCLAccelerator::MinChunkSize;
+    const std::size_t counts[] = { OpenCLAccelerator::MinChunkSize / 2 + 3, pipelined, 3 * pipelined + 1001 };
+
+    for(const std::size_t count: counts)
+    {
+        SCOPED_TRACE(count);
+
+        Objects objects;
+        fill(objects, count);
+
+        SimpleCpuAccelerator cpu(&objects);
+        OpenCLAccelerator opencl(&objects);
+
+        const std::vector<force_vector_t> expected = cpu.forces();
+
+        const std::vector<force_vector_t> forces = opencl.forces();
+        ASSERT_EQ(forces.size(), count);
+        expectNear(forces, expected);
+
+        // part of rows only (as HybridAccelerator does), boundaries not aligned to chunks nor work groups
+        const std::size_t rowsSet[] = { 1, OpenCLAccelerator::MinChunkSize + 17, count / 2 + 3, count - 1 };
+
+        for(const std::size_t rows: rowsSet)
+        {
+            if (rows >= count)
+                continue;
+
+            SCOPED_TRACE(rows);
+
+            opencl.enqueueForces(rows);
+            const std::vector<force_vector_t> part = opencl.finishForces();
+
+            ASSERT_EQ(part.size(), rows);
+            expectNear(part, expected);
+        }
+    }
+}
+
+
+#ifdef GRAVITY_AVX_ACCELERATOR
+
+TEST(OpenCLAcceleratorTest, HybridForcesMatchCpu)
+{
+    if (haveDevice() == false)
+        GTEST_SKIP() << "no OpenCL device";
+
+    Objects objects;
+    fill(objects, 20 * OpenCLTuner::MaxGroupSize + 101);
+
+    SimpleCpuAccelerator cpu(&objects);
+    HybridAccelerator hybrid(&objects);
+
+    const std::vector<force_vector_t> expected = cpu.forces();
+
+    // split moves between steps, merged results must not change
+    for(int step = 0; step < 10; step++)
+    {
+        SCOPED_TRACE(step);
+
+        const std::vector<force_vector_t> forces = hybrid.forces();
+
+        ASSERT_EQ(forces.size(), expected.size());
+        expectNear(forces, expected);
+
+        EXPECT_GE(hybrid.deviceShare(), HybridAccelerator::MinShare);
+        EXPECT_LE(hybrid.deviceShare(), 1.0 - HybridAccelerator::MinShare);
+    }
+}
+
+#endif
@@ -0,0 +1,106 @@
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <gmock/gmock.h>
+
+#include "../accelerators/disk_cache.hpp"
+#include "../accelerators/opencl_program_cache.hpp"
+#include "../accelerators/opencl_tuner.hpp"
+
+
+// None of these needs OpenCL device
+
+
+TEST(OpenCLCacheTest, HashIsStable)
+{
+    // FNV-1a reference values: file names of cached programs must not change between builds
+    EXPECT_EQ(OpenCLProgramCache::hash(""), 0xcbf29ce484222325ull);
+    EXPECT_EQ(OpenCLProgramCache::hash("a"), 0xaf63dc4c8601ec8cull);
+    EXPECT_EQ(OpenCLProgramCache::hash("foobar"), 0x85944171f73967e8ull);
+}
+
+
+TEST(OpenCLCacheTest, ProgramFileMatchesItsKeyOnly)
+{
+    const std::vector<unsigned char> binary = { 0x7f, 'E', 'L', 'F', '\n', 0, 1, 2 };
+    const std::string file = OpenCLProgramCache::serialize("device\tdriver\t-DUNROLL=4", binary);
+
+    std::istringstream matching(file);
+    EXPECT_EQ(OpenCLProgramCache::deserialize(matching, "device\tdriver\t-DUNROLL=4"), binary);
+
+    // other program (hash collision of file name) is not loaded
+    std::istringstream otherKey(file);
+    EXPECT_TRUE(OpenCLProgramCache::deserialize(otherKey, "device\tdriver\t-DUNROLL=8").empty());
+
+    // file of other format version
+    std::string oldFormat = file;
+    oldFormat[oldFormat.find('\n') - 1]++;
+
+    std::istringstream otherMagic(oldFormat);
+    EXPECT_TRUE(OpenCLProgramCache::deserialize(otherMagic, "device\tdriver\t-DUNROLL=4").empty());
+
+    // incomplete file
+    std::istringstream truncated(file.substr(0, file.size() - 1));
+    EXPECT_TRUE(OpenCLProgramCache::deserialize(truncated, "device\tdriver\t-DUNROLL=4").empty());
+
+    std::istringstream empty;
+    EXPECT_TRUE(OpenCLProgramCache::deserialize(empty, "device\tdriver\t-DUNROLL=4").empty());
+}
+
+
+TEST(OpenCLCacheTest, TunerCacheKeepsOneEntryPerDeviceAndBucket)
+{
+    const OpenCLTuner::Config first = { 64, 128, 4 };
+    const OpenCLTuner::Config second = { 128, 256, 8 };
+    const OpenCLTuner::Config other = { 32, 32, 1 };
+
+    std::istringstream initial("GPU\t10\t64\t128\t4\n"
+                               "CPU\t10\t32\t32\t1\n"
+                               "broken line\n"
+                               "GPU\t12\t64\t128\t4\n");
+
+    std::istringstream updated(OpenCLTuner::updateCache(initial, "GPU", 10, second));
+    const std::string content = updated.str();
+
+    // replaced entry is not duplicated, damaged lines are dropped
+    EXPECT_EQ(content, "CPU\t10\t32\t32\t1\n"
+                       "GPU\t12\t64\t128\t4\n"
+                       "GPU\t10\t128\t256\t8\n");
+
+    const std::map<std::size_t, OpenCLTuner::Config> gpu = OpenCLTuner::parseCache(updated, "GPU");
+    ASSERT_EQ(gpu.size(), 2);
+    EXPECT_EQ(gpu.at(10), second);
+    EXPECT_EQ(gpu.at(12), first);
+
+    std::istringstream again(content);
+    const std::map<std::size_t, OpenCLTuner::Config> cpu = OpenCLTuner::parseCache(again, "CPU");
+    ASSERT_EQ(cpu.size(), 1);
+    EXPECT_EQ(cpu.at(10), other);
+
+    // later entries win
+    std::istringstream repeated("GPU\t10\t64\t128\t4\nGPU\t10\t128\t256\t8\n");
+    EXPECT_EQ(OpenCLTuner::parseCache(repeated, "GPU").at(10), second);
+}
+
+
+TEST(OpenCLCacheTest, WritesWholeFiles)
+{
+    const std::string directory = "opencl_cache_test";
+    const std::string path = directory + "/nested/file.bin";
+    const std::string content("binary\0content\n", 15);
+
+    ASSERT_TRUE(DiskCache::write(path, content));
+    ASSERT_TRUE(DiskCache::write(path, content));               // replaces existing file
+
+    std::ifstream file(path, std::ios_base::binary);
+    std::stringstream stored;
+    stored << file.rdbuf();
+
+    EXPECT_EQ(stored.str(), content);
+
+    std::remove(path.c_str());
+    std::remove((directory + "/nested").c_str());
+    std::remove(directory.c_str());
+}
@@ -0,0 +1,206 @@
+
+#include <algorithm>
+
+#include <gmock/gmock.h>
+
+#include "../simulation_engine.hpp"
+#include "../accelerators/simple_cpu_accelerator.hpp"
+
+
+namespace
+{
+    void copyObjects(const Objects& from, Objects& to)
+    {
+        to.resize(from.size());
+
+        std::copy(from.getX().begin(), from.getX().end(), to.getX().begin());
+        std::copy(from.getY().begin(), from.getY().end(), to.getY().begin());
+        std::copy(from.getVX().begin(), from.getVX().end(), to.getVX().begin());
+        std::copy(from.getVY().begin(), from.getVY().end(), to.getVY().begin());
+        std::copy(from.getMass().begin(), from.getMass().end(), to.getMass().begin());
+        std::copy(from.getRadius().begin(), from.getRadius().end(), to.getRadius().begin());
+        std::copy(from.getId().begin(), from.getId().end(), to.getId().begin());
+    }
+
+
+    // Keeps own copy of objects ("device memory") and steps it the same way engine does on host
+    class ShadowAccelerator: public IAccelerator
+    {
+        public:
+            ShadowAccelerator():
+                uploads(0),
+                downloads(0),
+                m_host(nullptr),
+                m_hostAccelerator(),
+                m_shadow(),
+                m_shadowAccelerator(&m_shadow),
+                m_valid(false)
+            {
+            }
+
+            virtual void setObjects(Objects* objects) override
+            {
+                m_hostAccelerator.setObjects(objects);
+
+                m_host = objects;
+                m_valid = false;
+            }
+
+            virtual std::vector<force_vector_t> forces() override
+            {
+                return m_hostAccelerator.forces();
+            }
+
+            virtual std::vector<XY> velocities(const std::vector<force_vector_t>& forces, time_type dt) const override
+            {
+                return m_hostAccelerator.velocities(forces, dt);
+            }
+
+            virtual std::vector<std::pair<int, int>> collisions() const override
+            {
+                return m_hostAccelerator.collisions();
+            }
+
+            virtual bool residentStep(double& dt, const DtController& accept, bool& collisions) override
+            {
+                if (m_valid == false)
+                {
+                    copyObjects(*m_host, m_shadow);
+                    m_valid = true;
+                    uploads++;
+                }
+
+                const std::size_t objs = m_shadow.size();
+                const std::vector<force_vector_t> forces = m_shadowAccelerator.forces();
+
+                std::vector<XY> v(objs);
+                std::vector<XY> pos(objs);
+                BaseType max_travel = 0.0;
+
+                do
+                {
+                    const std::vector<XY> speeds = m_shadowAccelerator.velocities(forces, dt);
+
+                    max_travel = 0.0;
+                    for(std::size_t i = 0; i < objs; i++)
+                    {
+                        const Object o = m_shadow[i];
+
+                        v[i] = speeds[i] + o.velocity();
+                        pos[i] = o.pos() + v[i] * dt;
+
+                        max_travel = std::max(max_travel, utils::distance(pos[i], o.pos()));
+                    }
+                }
+                while(accept(dt, max_travel) == false);
+
+                for(std::size_t i = 0; i < objs; i++)
+                {
+                    m_shadow.setPos(i, pos[i]);
+                    m_shadow.setVelocity(i, v[i]);
+                }
+
+                collisions = m_shadowAccelerator.collisions().empty() == false;
+
+                return true;
+            }
+
+            virtual void synchronize() override
+            {
+                copyObjects(m_shadow, *m_host);
+                downloads++;
+            }
+
+            virtual void invalidate() override
+            {
+                m_valid = false;
+            }
+
+            int uploads;
+            int downloads;
+
+        private:
+            Objects* m_host;
+            SimpleCpuAccelerator m_hostAccelerator;
+            Objects m_shadow;
+            SimpleCpuAccelerator m_shadowAccelerator;
+            bool m_valid;
+    };
+
+
+    void addObjects(SimulationEngine& engine)
+    {
+        engine.addObject( Object(0, 0, 5.9736e24, 6371e3) );
+
+        for(int i = 1; i < 8; i++)
+            engine.addObject( Object(384400e3 * i/10, 0, 7.347673e22,  1737.1e3, 0, 1.022e3) );
+
+        // pair on collision course
+        engine.addObject( Object(-200000e3, 0, 7.347673e22,  1737.1e3, 0, 0) );
+        engine.addObject( Object(-200000e3, 20000e3, 7.347673e22,  1737.1e3, 0, -2e3) );
+    }
+}
+
+
+TEST(ResidentStepTest, MatchesRegularStep)
+{
+    SimpleCpuAccelerator accelerator;
+    SimulationEngine engine(&accelerator);
+    addObjects(engine);
+
+    ShadowAccelerator residentAccelerator;
+    SimulationEngine residentEngine(&residentAccelerator);
+    residentEngine.setDeviceResident(true);
+    addObjects(residentEngine);
+
+    engine.stepBy(4 * 3600);
+    residentEngine.stepBy(4 * 3600);
+
+    const Objects& objects = engine.objects();
+    const Objects& residentObjects = residentEngine.objects();
+
+    EXPECT_LT(objects.size(), 10u);                             // collision happened
+    ASSERT_EQ(objects.size(), residentObjects.size());
+
+    for(std::size_t i = 0; i < objects.size(); i++)
+    {
+        EXPECT_EQ(objects.getId()[i], residentObjects.getId()[i]);
+        EXPECT_EQ(objects.getX()[i], residentObjects.getX()[i]);
+        EXPECT_EQ(objects.getY()[i], residentObjects.getY()[i]);
+        EXPECT_EQ(objects.getVX()[i], residentObjects.getVX()[i]);
+        EXPECT_EQ(objects.getVY()[i], residentObjects.getVY()[i]);
+        EXPECT_EQ(objects.getMass()[i], residentObjects.getMass()[i]);
+    }
+}
+
+
+TEST(ResidentStepTest, DownloadsOnlyWhenNeeded)
+{
+    ShadowAccelerator accelerator;
+    SimulationEngine engine(&accelerator);
+    engine.setDeviceResident(true);
+
+    engine.addObject( Object(0, 0, 5.9736e24, 6371e3) );
+    engine.addObject( Object(384400e3, 0, 7.347673e22,  1737.1e3, 0, 1.022e3) );
+
+    for(int i = 0; i < 10; i++)
+        engine.step();
+
+    EXPECT_EQ(accelerator.uploads, 1);
+    EXPECT_EQ(accelerator.downloads, 0);
+
+    // nobody observes engine, so stepBy() has no reason to download
+    engine.stepBy(3600);
+    EXPECT_EQ(accelerator.downloads, 0);
+
+    engine.objects();
+    engine.objects();
+    EXPECT_EQ(accelerator.downloads, 1);
+
+    // host modification makes accelerator reload objects
+    engine.addObject( Object(-384400e3, 0, 7.347673e22,  1737.1e3, 0, 1.022e3) );
+    engine.step();
+
+    EXPECT_EQ(accelerator.uploads, 2);
+    EXPECT_EQ(engine.objectCount(), 3u);
+}
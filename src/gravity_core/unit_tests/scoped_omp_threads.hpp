@@ -0,0 +1,30 @@
+
+#ifndef SCOPED_OMP_THREADS_HPP
+#define SCOPED_OMP_THREADS_HPP
+
+#include <omp.h>
+
+
+// Sets number of OpenMP threads for the scope, restores previous value on exit,
+// so tests do not affect each other.
+class ScopedOmpThreads
+{
+    public:
+        explicit ScopedOmpThreads(int threads): m_previous(omp_get_max_threads())
+        {
+            omp_set_num_threads(threads);
+        }
+
+        ScopedOmpThreads(const ScopedOmpThreads &) = delete;
+        ScopedOmpThreads& operator=(const ScopedOmpThreads &) = delete;
+
+        ~ScopedOmpThreads()
+        {
+            omp_set_num_threads(m_previous);
+        }
+
+    private:
+        const int m_previous;
+};
+
+#endif // SCOPED_OMP_THREADS_HPP
@@ -0,0 +1,85 @@
+#include <gmock/gmock.h>
+
+#include "../simulation_engine.hpp"
+#include "../accelerators/simple_cpu_accelerator.hpp"
+
+
+namespace
+{
+    struct SimulationEventsMock: ISimulationEvents
+    {
+        MOCK_METHOD2(objectsColided, void(const Object &, const Object &));
+        MOCK_METHOD2(objectCreated, void(int, const Object &));
+        MOCK_METHOD1(objectAnnihilated, void(const Object &));
+        MOCK_METHOD2(objectUpdated, void(int, const Object &));
+    };
+
+    struct SimulationBatchEventsMock: ISimulationBatchEvents
+    {
+        MOCK_METHOD3(objectsCreated, void(const Objects &, std::size_t, std::size_t));
+        MOCK_METHOD1(objectsColided, void(const std::vector<Collision> &));
+        MOCK_METHOD1(objectsAnnihilated, void(const std::vector<Object> &));
+        MOCK_METHOD1(objectsUpdated, void(const Objects &));
+    };
+
+    // earth with moon inside (collision in first step) and distant, moving moon
+    void addObjects(SimulationEngine& engine)
+    {
+        engine.addObject( Object(0, 0, 5.9736e24, 6371e3) );
+        engine.addObject( Object(1000e3, 0, 7.347673e22, 1737.1e3, 0, 1.022e3) );
+        engine.addObject( Object(384400e3, 0, 7.347673e22, 1737.1e3, 0, 1.022e3) );
+    }
+}
+
+
+TEST(SimulationEventsTest, BatchObserverGetsOneCallPerStepBy)
+{
+    SimpleCpuAccelerator accelerator;
+    SimulationEngine engine(&accelerator);
+
+    SimulationBatchEventsMock events;
+    engine.addEventsObserver(&events);
+
+    EXPECT_CALL(events, objectsCreated(testing::Ref(engine.objects()), testing::_, 1)).Times(3);
+    addObjects(engine);
+
+    testing::InSequence sequence;
+
+    EXPECT_CALL(events, objectsColided(testing::SizeIs(1))).WillOnce(testing::Invoke([](const std::vector<ISimulationBatchEvents::Collision>& collisions)
+    {
+        EXPECT_EQ(collisions[0].survivor.id(), 1);
+        EXPECT_EQ(collisions[0].annihilated.id(), 2);
+    }));
+    EXPECT_CALL(events, objectsAnnihilated(testing::SizeIs(1)));
+    EXPECT_CALL(events, objectsUpdated(testing::Ref(engine.objects()))).WillOnce(testing::Invoke([](const Objects& objects)
+    {
+        EXPECT_EQ(objects.size(), 2);
+    }));
+
+    EXPECT_GT(engine.stepBy(3600), 1);
+
+    // no collisions anymore
+    EXPECT_CALL(events, objectsUpdated(testing::Ref(engine.objects()))).Times(1);
+
+    engine.stepBy(3600);
+}
+
+
+TEST(SimulationEventsTest, AdapterDeliversPerObjectEvents)
+{
+    SimpleCpuAccelerator accelerator;
+    SimulationEngine engine(&accelerator);
+
+    SimulationEventsMock events;
+    engine.addEventsObserver(&events);
+
+    EXPECT_CALL(events, objectCreated(testing::_, testing::_)).Times(3);
+    addObjects(engine);
+
+    EXPECT_CALL(events, objectsColided(testing::Property(&Object::id, 1), testing::Property(&Object::id, 2))).Times(1);
+    EXPECT_CALL(events, objectAnnihilated(testing::Property(&Object::id, 2))).Times(1);
+    EXPECT_CALL(events, objectUpdated(1, testing::Property(&Object::id, 1))).Times(1);
+    EXPECT_CALL(events, objectUpdated(3, testing::Property(&Object::id, 3))).Times(1);
+
+    engine.stepBy(3600);
+}
@@ -0,0 +1,143 @@
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <gmock/gmock.h>
+
+#include "../tracing.hpp"
+#include "../simulation_engine.hpp"
+#include "../accelerators/simple_cpu_accelerator.hpp"
+
+
+namespace
+{
+    std::string readFile(const std::string& path)
+    {
+        std::ifstream file(path);
+        std::stringstream content;
+        content << file.rdbuf();
+
+        return content.str();
+    }
+
+    std::size_t occurrences(const std::string& text, const std::string& pattern)
+    {
+        std::size_t result = 0;
+
+        for(std::size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+            result++;
+
+        return result;
+    }
+}
+
+
+TEST(TracingTest, RecordsNothingWhenNotCapturing)
+{
+    Tracing::Tracer& tracer = Tracing::Tracer::instance();
+    tracer.stop();
+    tracer.clear();
+
+    Tracing::Tracer::instance().complete("test", "direct", 1, 2);     // direct calls record regardless of state
+    {
+        Tracing::Scope scope("test", "scope");
+    }
+    Tracing::counter("test", "counter", 1.0);
+
+    ASSERT_TRUE(tracer.exportChromeTrace("tracing_test_idle.json"));
+    const std::string json = readFile("tracing_test_idle.json");
+
+    EXPECT_EQ(occurrences(json, "\"name\": \"direct\""), 1);
+    EXPECT_EQ(occurrences(json, "\"name\": \"scope\""), 0);
+    EXPECT_EQ(occurrences(json, "\"name\": \"counter\""), 0);
+}
+
+
+TEST(TracingTest, ExportsChromeTraceFormat)
+{
+    Tracing::Tracer& tracer = Tracing::Tracer::instance();
+    tracer.clear();
+    tracer.start();
+
+    {
+        Tracing::Scope scope("test", "outer");
+        Tracing::counter("test", "value", 42.0);
+    }
+
+    tracer.stop();
+
+    ASSERT_TRUE(tracer.exportChromeTrace("tracing_test_format.json"));
+    const std::string json = readFile("tracing_test_format.json");
+
+    EXPECT_EQ(json.find("{\"displayTimeUnit\": \"ms\", \"traceEvents\": ["), 0);
+    EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+    EXPECT_EQ(occurrences(json, "\"ph\": \"M\""), 1);                               // one thread used
+    EXPECT_EQ(occurrences(json, "\"ph\": \"X\", \"cat\": \"test\", \"name\": \"outer\""), 1);
+    EXPECT_EQ(occurrences(json, "\"ph\": \"C\", \"cat\": \"test\", \"name\": \"value\""), 1);
+    EXPECT_EQ(occurrences(json, "\"args\": {\"value\": 42.000}"), 1);
+    EXPECT_EQ(occurrences(json, "{"), occurrences(json, "}"));
+}
+
+
+TEST(TracingTest, ReusesBuffersOfExitedThreads)
+{
+    Tracing::Tracer& tracer = Tracing::Tracer::instance();
+
+    auto threadsInTrace = [&tracer]
+    {
+        tracer.exportChromeTrace("tracing_test_threads.json");
+        return occurrences(readFile("tracing_test_threads.json"), "\"name\": \"thread_name\"");
+    };
+
+    std::thread([]{ Tracing::Tracer::instance().complete("test", "thread", 1, 2); }).join();
+    const std::size_t threads = threadsInTrace();
+
+    // one thread at a time: all of them use the same buffer
+    for(int i = 0; i < 10; i++)
+        std::thread([]{ Tracing::Tracer::instance().complete("test", "thread", 1, 2); }).join();
+
+    EXPECT_EQ(threadsInTrace(), threads);
+}
+
+
+#ifdef GRAVITY_TRACING
+
+namespace
+{
+    void addMoons(SimulationEngine& engine)
+    {
+        engine.addObject( Object(0, 0, 5.9736e24, 6371e3) );
+
+        for(int i = 1; i < 8; i++)
+            engine.addObject( Object(384400e3 * i/10, 0, 7.347673e22,  1737.1e3, 0, 1.022e3) );
+    }
+}
+
+
+TEST(TracingTest, CapturesWindowOfSteps)
+{
+    SimpleCpuAccelerator accelerator;
+    SimulationEngine engine(&accelerator);
+    addMoons(engine);
+
+    Tracing::Tracer& tracer = Tracing::Tracer::instance();
+    tracer.stop();
+    tracer.clear();
+    tracer.capture(2, 3);
+
+    for(int i = 0; i < 10; i++)
+        engine.step();
+
+    EXPECT_FALSE(tracer.active());
+
+    ASSERT_TRUE(tracer.exportChromeTrace("tracing_test_window.json"));
+    const std::string json = readFile("tracing_test_window.json");
+
+    EXPECT_EQ(occurrences(json, "\"cat\": \"engine\", \"name\": \"step\""), 3);
+    EXPECT_EQ(occurrences(json, "\"cat\": \"engine\", \"name\": \"forces\""), 3);
+    EXPECT_EQ(occurrences(json, "\"cat\": \"engine\", \"name\": \"collisions\""), 3);
+    EXPECT_GE(occurrences(json, "\"cat\": \"accelerator\", \"name\": \"forces worker\""), 3);
+}
+
+#endif
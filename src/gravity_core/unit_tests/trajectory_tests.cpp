@@ -0,0 +1,237 @@
+
+#include <gmock/gmock.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+
+#include "../objects.hpp"
+#include "../trajectory_reader.hpp"
+#include "../trajectory_writer.hpp"
+
+
+TEST(TrajectoryTest, WritesSnapshotsAtRequestedInterval)
+{
+    const std::string path = "trajectory_test.bin";
+
+    Objects objects;
+    for(int i = 0; i < 100; i++)
+        objects.insert( Object(i, -i, 1e20 + i, 1e3 + i, i * 2, -i * 2), i + 1 );
+
+    TrajectoryWriter::Config config;
+    config.interval = 10.0;
+    config.buffers = 2;
+    config.capacity = 100;
+    config.backpressure = TrajectoryWriter::Block;      // no snapshot can be lost
+
+    {
+        TrajectoryWriter writer(path, config);
+
+        for(int t = 0; t <= 100; t += 5)
+        {
+            objects.getX()[0] = t;
+            writer.capture(objects, t);
+
+            // objects disappear in time
+            if (t % 20 == 15)
+                objects.erase(objects.size() - 1);
+        }
+
+        writer.close();
+
+        EXPECT_TRUE(writer.good());
+        EXPECT_EQ(writer.captured(), 11);
+        EXPECT_EQ(writer.written(), 11);
+        EXPECT_EQ(writer.dropped(), 0);
+    }
+
+    TrajectoryReader reader(path);
+    ASSERT_TRUE(reader.good());
+
+    TrajectorySnapshot snapshot;
+    for(int s = 0; s <= 10; s++)
+    {
+        ASSERT_TRUE(reader.next(snapshot));
+
+        const std::size_t expectedSize = 100 - (s * 10 + 4) / 20;
+
+        EXPECT_EQ(snapshot.time, s * 10.0);
+        ASSERT_EQ(snapshot.size(), expectedSize);
+        EXPECT_EQ(snapshot.x[0], s * 10.0);
+
+        for(std::size_t i = 1; i < expectedSize; i++)
+        {
+            EXPECT_EQ(snapshot.id[i], i + 1);
+            EXPECT_EQ(snapshot.x[i], i);
+            EXPECT_EQ(snapshot.y[i], -BaseType(i));
+            EXPECT_EQ(snapshot.vx[i], i * 2);
+            EXPECT_EQ(snapshot.vy[i], -BaseType(i * 2));
+            EXPECT_EQ(snapshot.mass[i], BaseType(1e20 + i));
+            EXPECT_EQ(snapshot.radius[i], BaseType(1e3 + i));
+        }
+    }
+
+    EXPECT_FALSE(reader.next(snapshot));
+
+    std::remove(path.c_str());
+}
+
+
+TEST(TrajectoryTest, CompressedSnapshotsStayWithinErrorBounds)
+{
+    const std::string path = "trajectory_compressed_test.bin";
+    const double dt = 600.0;
+
+    // objects moving with constant accelerations
+    Objects objects;
+    for(int i = 0; i < 500; i++)
+        objects.insert( Object(384400e3 + i * 1e6, -1e8 + i * 2e5, 1e20 + i, 1e3, 1.022e3 * (i % 2? 1: -1), 50.0 * (i % 5)), i + 1 );
+
+    TrajectoryWriter::Config config;
+    config.buffers = 1;
+    config.backpressure = TrajectoryWriter::Block;
+    config.compress = true;
+    config.codec.keyframeInterval = 16;
+
+    std::vector<TrajectorySnapshot> expected(40);
+
+    {
+        TrajectoryWriter writer(path, config);
+
+        for(std::size_t s = 0; s < expected.size(); s++)
+        {
+            for(std::size_t i = 0; i < objects.size(); i++)
+            {
+                objects.getVX()[i] += 1e-3 * (i % 3) * dt;
+                objects.getVY()[i] -= 2e-3 * (i % 4) * dt;
+                objects.getX()[i] += objects.getVX()[i] * dt;
+                objects.getY()[i] += objects.getVY()[i] * dt;
+            }
+
+            // change of objects set forces keyframe
+            if (s == 25)
+                objects.erase(10);
+
+            expected[s].assign(objects, s * dt);
+            writer.capture(objects, s * dt);
+        }
+
+        writer.close();
+        EXPECT_TRUE(writer.good());
+    }
+
+    // compressed file should be much smaller than raw snapshots
+    std::size_t rawSize = 0;
+    for(const TrajectorySnapshot& s: expected)
+        rawSize += s.size() * TrajectoryFormat::Columns * sizeof(BaseType);
+
+    EXPECT_LT(std::ifstream(path, std::ios::binary | std::ios::ate).tellg(), rawSize / 3);
+
+    auto verify = [&config](const TrajectorySnapshot& actual, const TrajectorySnapshot& original)
+    {
+        ASSERT_EQ(actual.size(), original.size());
+        EXPECT_EQ(actual.time, original.time);
+
+        // precision of floats is also a limit
+        auto near = [](BaseType a, BaseType b, BaseType error)
+        {
+            EXPECT_NEAR(a, b, error + std::abs(b) * 2.5e-7);
+        };
+
+        for(std::size_t i = 0; i < original.size(); i++)
+        {
+            EXPECT_EQ(actual.id[i], original.id[i]);
+            EXPECT_EQ(actual.mass[i], original.mass[i]);
+            EXPECT_EQ(actual.radius[i], original.radius[i]);
+
+            near(actual.x[i], original.x[i], config.codec.xError);
+            near(actual.y[i], original.y[i], config.codec.yError);
+            near(actual.vx[i], original.vx[i], config.codec.vxError);
+            near(actual.vy[i], original.vy[i], config.codec.vyError);
+        }
+    };
+
+    TrajectoryReader reader(path);
+    ASSERT_TRUE(reader.good());
+
+    TrajectorySnapshot snapshot;
+    for(std::size_t s = 0; s < expected.size(); s++)
+    {
+        ASSERT_TRUE(reader.next(snapshot));
+        verify(snapshot, expected[s]);
+    }
+
+    EXPECT_FALSE(reader.next(snapshot));
+
+    // random access: decoding starts from closest keyframe
+    ASSERT_TRUE(reader.seek(21 * dt));
+    ASSERT_TRUE(reader.next(snapshot));
+    verify(snapshot, expected[16]);
+    ASSERT_TRUE(reader.next(snapshot));
+    verify(snapshot, expected[17]);
+
+    ASSERT_TRUE(reader.seek(27 * dt));
+    ASSERT_TRUE(reader.next(snapshot));
+    verify(snapshot, expected[25]);
+
+    std::remove(path.c_str());
+}
+
+
+TEST(TrajectoryTest, SeekDoesNotAcceptCorruptedFileHeader)
+{
+    const std::string path = "trajectory_corrupted_test.bin";
+
+    Objects objects;
+    for(int i = 0; i < 10; i++)
+        objects.insert( Object(i * 1e6, 0, 1e20, 1e3), i + 1 );
+
+    {
+        TrajectoryWriter::Config config;
+        config.backpressure = TrajectoryWriter::Block;
+
+        TrajectoryWriter writer(path, config);
+        for(int s = 0; s < 3; s++)
+            writer.capture(objects, s * 60.0);
+
+        writer.close();
+        ASSERT_TRUE(writer.good());
+    }
+
+    // damage magic, version and entry size in turn
+    const std::streamoff offsets[] =
+    {
+        offsetof(TrajectoryFormat::FileHeader, magic),
+        offsetof(TrajectoryFormat::FileHeader, version),
+        offsetof(TrajectoryFormat::FileHeader, entrySize),
+    };
+
+    for(const std::streamoff offset: offsets)
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+
+        char original;
+        file.seekg(offset);
+        file.get(original);
+        file.seekp(offset);
+        file.put(static_cast<char>(original + 100));
+        file.flush();
+
+        TrajectoryReader reader(path);
+        TrajectorySnapshot snapshot;
+
+        EXPECT_FALSE(reader.good());
+        EXPECT_FALSE(reader.seek(60.0));
+        EXPECT_FALSE(reader.good());
+        EXPECT_FALSE(reader.next(snapshot));
+
+        file.seekp(offset);
+        file.put(original);
+    }
+
+    // restored file is fine again
+    TrajectoryReader reader(path);
+    EXPECT_TRUE(reader.seek(60.0));
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,104 @@
+
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include "../triple_buffer.hpp"
+
+
+TEST(TripleBufferTest, ReaderSeesOnlyPublishedValues)
+{
+    TripleBuffer<int> buffer;
+
+    EXPECT_FALSE(buffer.update());
+
+    buffer.back() = 5;
+    EXPECT_FALSE(buffer.update());
+
+    buffer.publish();
+    EXPECT_TRUE(buffer.update());
+    EXPECT_EQ(buffer.front(), 5);
+
+    // nothing new
+    EXPECT_FALSE(buffer.update());
+    EXPECT_EQ(buffer.front(), 5);
+}
+
+
+TEST(TripleBufferTest, StaleValuesAreDropped)
+{
+    TripleBuffer<int> buffer;
+
+    for(int i = 1; i <= 3; i++)
+    {
+        buffer.back() = i;
+        buffer.publish();
+    }
+
+    EXPECT_TRUE(buffer.update());
+    EXPECT_EQ(buffer.front(), 3);
+    EXPECT_FALSE(buffer.update());
+}
+
+
+TEST(TripleBufferTest, BuffersAreReused)
+{
+    TripleBuffer<std::vector<int>> buffer;
+
+    std::vector<const int *> data;
+    for(int i = 0; i < 3; i++)
+    {
+        buffer.back().assign(16, i);
+        data.push_back(buffer.back().data());
+        buffer.publish();
+        buffer.update();
+    }
+
+    // after warm up writer gets back buffers with already allocated storage
+    for(int i = 0; i < 12; i++)
+    {
+        std::vector<int>& back = buffer.back();
+        EXPECT_EQ(back.size(), 16);
+        EXPECT_THAT(data, testing::Contains(back.data()));
+
+        back.assign(16, i);
+        buffer.publish();
+
+        if (i % 3)
+            buffer.update();
+    }
+}
+
+
+TEST(TripleBufferTest, ConcurrentReaderSeesConsistentIncreasingValues)
+{
+    const int values = 100000;
+    TripleBuffer<std::vector<int>> buffer;
+
+    std::thread writer([&buffer]
+    {
+        for(int i = 1; i <= values; i++)
+        {
+            buffer.back().assign(8, i);
+            buffer.publish();
+        }
+    });
+
+    int last = 0;
+    while(last < values)
+    {
+        if (buffer.update())
+        {
+            const std::vector<int>& front = buffer.front();
+
+            ASSERT_EQ(front.size(), 8);
+            EXPECT_GT(front.front(), last);
+            EXPECT_THAT(front, testing::Each(front.front()));
+
+            last = front.front();
+        }
+    }
+
+    writer.join();
+}
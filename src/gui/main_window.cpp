@@ -35,7 +35,9 @@ MainWindow::MainWindow():
 
     connect(&m_controller, &SimulationController::fpsUpdated, ui->simulationInfo, &SimulationInfoWidget::updateFps);
     connect(&m_controller, &SimulationController::objectCountUpdated, ui->simulationInfo, &SimulationInfoWidget::updateObjectCount);
+    connect(&m_controller, &SimulationController::instrumentationUpdated, ui->simulationInfo, &SimulationInfoWidget::updateInstrumentation);
     connect(&m_scene, &ObjectsScene::objectDataUpdated, ui->simulationInfo, &SimulationInfoWidget::updateObjectData);
+    connect(&m_scene, &ObjectsScene::objectDataCleared, ui->simulationInfo, &SimulationInfoWidget::clearObjectData);
     m_controller.beginSimulation();
 }
 
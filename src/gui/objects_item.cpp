@@ -0,0 +1,169 @@
+/*
+ * Scene item drawing all objects at once
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "objects_item.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+#include "objects_snapshot.hpp"
+
+
+ObjectsItem::ObjectsItem():
+    QGraphicsItem(),
+    m_snapshot(nullptr),
+    m_bounds(),
+    m_outline(Qt::red),
+    m_fill(Qt::SolidPattern),
+    m_point(Qt::red),
+    m_points()
+{
+    m_outline.setWidthF(10e6);
+
+    m_point.setCosmetic(true);
+    m_point.setWidth(2);
+
+    // exposedRect is used for culling
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+
+ObjectsItem::~ObjectsItem()
+{
+
+}
+
+
+void ObjectsItem::setSnapshot(const ObjectsSnapshot* snapshot)
+{
+    m_snapshot = snapshot;
+
+    const QRectF bounds = this->bounds();
+    if (bounds != m_bounds)
+    {
+        prepareGeometryChange();
+        m_bounds = bounds;
+    }
+
+    update();
+}
+
+
+const ObjectsSnapshot* ObjectsItem::snapshot() const
+{
+    return m_snapshot;
+}
+
+
+int ObjectsItem::objectAt(const QPointF& point, qreal tolerance) const
+{
+    if (m_snapshot == nullptr)
+        return -1;
+
+    int result = -1;
+    qreal closest = std::numeric_limits<qreal>::max();
+
+    for(std::size_t i = 0; i < m_snapshot->size(); i++)
+    {
+        const qreal dx = m_snapshot->x[i] - point.x();
+        const qreal dy = m_snapshot->y[i] - point.y();
+        const qreal dist = std::sqrt(dx * dx + dy * dy);
+
+        if (dist <= m_snapshot->radius[i] + tolerance && dist < closest)
+        {
+            closest = dist;
+            result = static_cast<int>(i);
+        }
+    }
+
+    return result;
+}
+
+
+QRectF ObjectsItem::boundingRect() const
+{
+    return m_bounds;
+}
+
+
+void ObjectsItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget *)
+{
+    if (m_snapshot == nullptr)
+        return;
+
+    const QRectF& exposed = option->exposedRect;
+    const qreal pixelsPerUnit = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    const qreal outline = m_outline.widthF() / 2;
+
+    painter->setPen(m_outline);
+    painter->setBrush(m_fill);
+
+    m_points.clear();
+
+    for(std::size_t i = 0; i < m_snapshot->size(); i++)
+    {
+        const qreal x = m_snapshot->x[i];
+        const qreal y = m_snapshot->y[i];
+        const qreal r = m_snapshot->radius[i];
+        const qreal extent = r + outline;
+
+        if (x + extent < exposed.left() || x - extent > exposed.right() ||
+            y + extent < exposed.top()  || y - extent > exposed.bottom())
+            continue;
+
+        // sub pixel objects are collected and drawn as points in one call
+        if (extent * pixelsPerUnit < 1.0)
+            m_points.emplace_back(x, y);
+        else
+            painter->drawEllipse(QPointF(x, y), r, r);
+    }
+
+    painter->setPen(m_point);
+    painter->drawPoints(m_points.data(), static_cast<int>(m_points.size()));
+}
+
+
+QRectF ObjectsItem::bounds() const
+{
+    if (m_snapshot == nullptr || m_snapshot->size() == 0)
+        return QRectF();
+
+    qreal left = std::numeric_limits<qreal>::max();
+    qreal top = std::numeric_limits<qreal>::max();
+    qreal right = std::numeric_limits<qreal>::lowest();
+    qreal bottom = std::numeric_limits<qreal>::lowest();
+
+    for(std::size_t i = 0; i < m_snapshot->size(); i++)
+    {
+        const qreal r = m_snapshot->radius[i];
+
+        left = std::min<qreal>(left, m_snapshot->x[i] - r);
+        right = std::max<qreal>(right, m_snapshot->x[i] + r);
+        top = std::min<qreal>(top, m_snapshot->y[i] - r);
+        bottom = std::max<qreal>(bottom, m_snapshot->y[i] + r);
+    }
+
+    const qreal outline = m_outline.widthF() / 2;
+
+    return QRectF(QPointF(left, top), QPointF(right, bottom)).adjusted(-outline, -outline, outline, outline);
+}
@@ -0,0 +1,63 @@
+/*
+ * Scene item drawing all objects at once
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OBJECTSITEM_HPP
+#define OBJECTSITEM_HPP
+
+#include <vector>
+
+#include <QBrush>
+#include <QGraphicsItem>
+#include <QPen>
+
+struct ObjectsSnapshot;
+
+
+// Draws all objects of snapshot in one paint() instead of keeping item per object.
+// Objects outside of exposed area are skipped, objects smaller than a pixel are drawn as points.
+class ObjectsItem: public QGraphicsItem
+{
+    public:
+        ObjectsItem();
+        ObjectsItem(const ObjectsItem &) = delete;
+        ~ObjectsItem();
+        ObjectsItem& operator=(const ObjectsItem &) = delete;
+
+        // snapshot is not copied, it needs to stay valid until next call
+        void setSnapshot(const ObjectsSnapshot *);
+        const ObjectsSnapshot* snapshot() const;
+
+        // index of object closest to point and not further than its radius + tolerance, -1 when none
+        int objectAt(const QPointF &, qreal tolerance) const;
+
+        virtual QRectF boundingRect() const override;
+        virtual void paint(QPainter *, const QStyleOptionGraphicsItem *, QWidget *) override;
+
+    private:
+        const ObjectsSnapshot* m_snapshot;
+        QRectF m_bounds;
+        QPen m_outline;
+        QBrush m_fill;
+        QPen m_point;
+        std::vector<QPointF> m_points;          // reused between paint()s
+
+        QRectF bounds() const;
+};
+
+#endif // OBJECTSITEM_HPP
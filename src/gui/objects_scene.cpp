@@ -19,21 +19,30 @@
 
 #include "objects_scene.hpp"
 
-#include <cassert>
+#include <algorithm>
 
-#include <QColor>
-#include <QGraphicsItem>
-#include <QPen>
 #include <QGraphicsSceneMouseEvent>
+#include <QGraphicsView>
+#include <QPen>
+#include <QStyleOptionGraphicsItem>
+
+#include "objects_item.hpp"
+#include "objects_snapshot.hpp"
 
-ObjectsScene::ObjectsScene(): m_objects(), track_id(0)
+ObjectsScene::ObjectsScene(): m_objects(nullptr), track_id(0), track_index(0)
 {
+    // all objects are drawn by one item which moves every frame: BSP index would be rebuilt for nothing
+    setItemIndexMethod(QGraphicsScene::NoIndex);
+
     const BaseType grid = 400e6;
     QPen pen;
     pen.setWidth(10e6);
 
     addLine(-grid, 0, grid, 0, pen);
     addLine(0, -grid, 0, grid, pen);
+
+    m_objects = new ObjectsItem;
+    addItem(m_objects);
 }
 
 
@@ -43,106 +52,66 @@ ObjectsScene::~ObjectsScene()
 }
 
 
-void ObjectsScene::addObject(int id, const Object& obj)
+void ObjectsScene::setSnapshot(const ObjectsSnapshot* snapshot)
 {
-    const XY& p = obj.pos();
-    const QPointF position(p.x, p.y);
-
-    BaseType radius = obj.radius();
-
-    QGraphicsItem* item = createItem(radius);
-    item->setPos(position);
-    item->setData(ObjectData::Id, id);
-    item->setData(ObjectData::Radius, radius);
-
-    m_objects.insert( std::make_pair(id, item) );
+    m_objects->setSnapshot(snapshot);
 }
 
 
-void ObjectsScene::updatePosition(int id, const XY& pos)
-{
-    const QPointF position(pos.x, pos.y);
-
-    auto obj = m_objects.find(id);
-    assert(obj != m_objects.end());
-
-    obj->second->setPos(position);
-}
-
-
-void ObjectsScene::updateRadius(int id, BaseType r)
-{
-    auto obj = m_objects.find(id);
-    assert(obj != m_objects.end());
-
-    QGraphicsItem* item = createItem(r);
-    item->setData(ObjectData::Id, id);
-    item->setData(ObjectData::Radius, r);
-
-    const QPointF pos = obj->second->pos();
-    item->setPos(pos);
-
-    // swap items
-    removeItem(obj->second);
-    delete obj->second;
-    obj->second = item;
-}
-
-void ObjectsScene::updateMass(int id, mass_type m)
+void ObjectsScene::mousePressEvent(QGraphicsSceneMouseEvent *event)
 {
-    auto obj = m_objects.find(id);
-    assert(obj != m_objects.end());
-
-    obj->second->setData(ObjectData::Mass, m.raw_value());
-}
+    // few pixels of tolerance, so also tiny objects can be picked
+    const QList<QGraphicsView *> views = this->views();
+    const qreal pixelsPerUnit = views.isEmpty()? 0.0: QStyleOptionGraphicsItem::levelOfDetailFromTransform(views.front()->transform());
+    const qreal tolerance = pixelsPerUnit > 0.0? 4.0 / pixelsPerUnit: 0.0;
 
+    const int index = m_objects->objectAt(event->scenePos(), tolerance);
 
-void ObjectsScene::removeObject(int id)
-{
-    auto obj = m_objects.find(id);
-    assert(obj != m_objects.end());
-
-    if (id == track_id)
+    if (index < 0)
     {
         track_id = 0;
-        emit objectDataUpdated(nullptr);
+        emit objectDataCleared();
     }
-
-    removeItem(obj->second);
-
-    m_objects.erase(obj);
-}
-
-
-QGraphicsItem* ObjectsScene::createItem(BaseType radius)
-{
-    const QSizeF size(2 * radius, 2 * radius);
-    const QRectF rect(QPointF(-radius, -radius), size);
-    QPen pen(Qt::red);
-    pen.setWidthF(10e6);
-
-    QGraphicsItem* item = addEllipse(rect, pen, QBrush(Qt::SolidPattern));
-
-    return item;
-}
-
-void ObjectsScene::mousePressEvent(QGraphicsSceneMouseEvent *event)
-{
-    const QGraphicsItem *item = itemAt(event->scenePos(), QTransform());
-    if (item != nullptr)
-        track_id = item->data(ObjectData::Id).toInt();
     else
-        track_id = 0;
-
-    emit objectDataUpdated(item);
+    {
+        track_id = m_objects->snapshot()->id[index];
+        track(index);
+    }
 }
 
 void ObjectsScene::updateTrackInfo(void)
 {
     if (track_id)
     {
-        auto obj = m_objects.find(track_id);
-        assert(obj != m_objects.end());
-        emit objectDataUpdated(obj->second);
+        const ObjectsSnapshot* snapshot = m_objects->snapshot();
+
+        // objects move in snapshot only when others are annihilated, so last position is a good guess
+        if (track_index < snapshot->size() && snapshot->id[track_index] == track_id)
+            track(track_index);
+        else
+        {
+            const auto it = std::find(snapshot->id.cbegin(), snapshot->id.cend(), track_id);
+
+            if (it == snapshot->id.cend())
+            {
+                // annihilated
+                track_id = 0;
+                emit objectDataCleared();
+            }
+            else
+                track(it - snapshot->id.cbegin());
+        }
     }
 }
+
+
+void ObjectsScene::track(std::size_t index)
+{
+    const ObjectsSnapshot* snapshot = m_objects->snapshot();
+
+    track_index = index;
+    emit objectDataUpdated(track_id,
+                           XY(snapshot->x[index], snapshot->y[index]),
+                           snapshot->mass[index],
+                           snapshot->radius[index]);
+}
@@ -20,11 +20,12 @@
 #ifndef OBJECTSSCENE_HPP
 #define OBJECTSSCENE_HPP
 
-#include <unordered_map>
-
 #include <QGraphicsScene>
 
-#include "simulation_engine.hpp"
+#include "object.hpp"
+
+class ObjectsItem;
+struct ObjectsSnapshot;
 
 class ObjectsScene: public QGraphicsScene
 {
@@ -36,21 +37,19 @@ class ObjectsScene: public QGraphicsScene
         ~ObjectsScene();
         ObjectsScene& operator=(const ObjectsScene &) = delete;
 
-        void addObject(int id, const Object &);
-        void updatePosition(int id, const XY &);
-        void updateRadius(int id, BaseType r);
-        void updateMass(int id, mass_type m);
+        void setSnapshot(const ObjectsSnapshot *);          // not copied, see ObjectsItem::setSnapshot()
         void updateTrackInfo(void);
-        void removeObject(int id);
     signals:
-        void objectDataUpdated(const QGraphicsItem *);
+        void objectDataUpdated(int id, const XY& pos, BaseType mass, BaseType radius);
+        void objectDataCleared();
     protected:
         virtual void mousePressEvent(QGraphicsSceneMouseEvent *) override;
     private:
-        std::unordered_map<int, QGraphicsItem *> m_objects;
+        ObjectsItem* m_objects;
         int track_id;
+        std::size_t track_index;                            // where tracked object was last time
 
-        QGraphicsItem* createItem(BaseType);
+        void track(std::size_t index);
 };
 
 #endif // OBJECTSSCENE_HPP
@@ -0,0 +1,37 @@
+/*
+ * Columnar snapshot of simulated objects
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "objects_snapshot.hpp"
+
+
+void ObjectsSnapshot::assign(const Objects& objects)
+{
+    // vectors keep their capacity
+    id.assign(objects.getId().begin(), objects.getId().end());
+    x.assign(objects.getX().begin(), objects.getX().end());
+    y.assign(objects.getY().begin(), objects.getY().end());
+    mass.assign(objects.getMass().begin(), objects.getMass().end());
+    radius.assign(objects.getRadius().begin(), objects.getRadius().end());
+}
+
+
+std::size_t ObjectsSnapshot::size() const
+{
+    return id.size();
+}
@@ -0,0 +1,43 @@
+/*
+ * Columnar snapshot of simulated objects
+ * Copyright (C) 2016  Michał Walenciak <MichalWalenciak@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OBJECTSSNAPSHOT_HPP
+#define OBJECTSSNAPSHOT_HPP
+
+#include <vector>
+
+#include "objects.hpp"
+
+
+// State of all objects after last stepBy(), in columns.
+// Snapshots are kept in TripleBuffer and refilled in place, so once number of objects settles
+// handing them over to GUI does not allocate.
+struct ObjectsSnapshot
+{
+    std::vector<int> id;
+    std::vector<BaseType> x;
+    std::vector<BaseType> y;
+    std::vector<BaseType> mass;
+    std::vector<BaseType> radius;
+
+    void assign(const Objects &);
+    std::size_t size() const;
+};
+
+#endif // OBJECTSSNAPSHOT_HPP
@@ -23,6 +23,7 @@
 #include <cassert>
 
 #include "objects_scene.hpp"
+#include "tracing.hpp"
 
 bool equal(BaseType l, BaseType r)
 {
@@ -36,78 +37,29 @@ BaseType fRand(BaseType fMin, BaseType fMax)
 }
 
 
-Tick::Tick():
-    colided(),
-    created(),
-    annihilated(),
-    updated(),
-    colidedMutex(),
-    createdMutex(),
-    annihilatedMutex(),
-    updatedMutex()
-{
-
-}
-
-
-
-Tick::Tick(const Tick& other):
-    colided(),
-    created(),
-    annihilated(),
-    updated(),
-    colidedMutex(),
-    createdMutex(),
-    annihilatedMutex(),
-    updatedMutex()
-{
-    *this = other;
-}
-
-
-Tick& Tick::operator=(const Tick& other)
-{
-    std::lock_guard<std::mutex> lockColided(other.colidedMutex);
-    std::lock_guard<std::mutex> lockCreated(other.createdMutex);
-    std::lock_guard<std::mutex> lockAnnihilated(other.annihilatedMutex);
-    std::lock_guard<std::mutex> lockUpdated(other.updatedMutex);
-
-    colided = other.colided;
-    created = other.created;
-    annihilated = other.annihilated;
-    updated = other.updated;
-
-    return *this;
-}
-
-
-void Tick::clear()
-{
-    std::lock_guard<std::mutex> lockColided(colidedMutex);
-    std::lock_guard<std::mutex> lockCreated(createdMutex);
-    std::lock_guard<std::mutex> lockAnnihilated(annihilatedMutex);
-    std::lock_guard<std::mutex> lockUpdated(updatedMutex);
-
-    colided.clear();
-    created.clear();
-    annihilated.clear();
-    updated.clear();
-}
-
-
 SimulationController::SimulationController():
     m_accelerator(),
     m_engine(&m_accelerator),
     m_stepTimer(),
     m_calculationsThread(),
-    m_tickData(),
+    m_snapshots(),
+    m_sceneUpdatePending(false),
     m_scene(nullptr),
     m_fps(0),
-    m_framesCounter(0)
+    m_framesCounter(0),
+    m_tracePath(qgetenv("GRAVITY_TRACE"))
 {
-    qRegisterMetaType<Tick>();
+    // GRAVITY_TRACE=file.json records timeline of steps [GRAVITY_TRACE_FIRST_STEP, +GRAVITY_TRACE_STEPS)
+    if (m_tracePath.isEmpty() == false)
+    {
+        bool ok = false;
+        const int steps = qEnvironmentVariableIntValue("GRAVITY_TRACE_STEPS", &ok);
+
+        Tracing::Tracer::instance().capture(qEnvironmentVariableIntValue("GRAVITY_TRACE_FIRST_STEP"), ok? steps: 1000);
+    }
 
     m_engine.addEventsObserver(this);
+    m_engine.instrumentation().setEnabled(true);
 
     QTimer* fpsTimer = new QTimer(this);
     fpsTimer->setInterval(1000);
@@ -118,6 +70,7 @@ SimulationController::SimulationController():
         m_framesCounter = 0;
 
         emit fpsUpdated(m_fps);
+        emit instrumentationUpdated(m_engine.instrumentation().snapshot());
     });
 
     fpsTimer->start();
@@ -128,7 +81,7 @@ SimulationController::SimulationController():
     connect(&m_stepTimer, &QTimer::timeout, this, &SimulationController::tick, Qt::DirectConnection);  // make sure tick will be called from calculations thread
     connect(&m_calculationsThread, SIGNAL(started()), &m_stepTimer, SLOT(start()));
     connect(&m_calculationsThread, SIGNAL(finished()), &m_stepTimer, SLOT(stop()));
-    connect(this, &SimulationController::tickData, this, &SimulationController::updateScene);          // inter-thread communication signal
+    connect(this, &SimulationController::snapshotPublished, this, &SimulationController::updateScene);  // inter-thread communication signal
 }
 
 
@@ -136,6 +89,12 @@ SimulationController::~SimulationController()
 {
     m_calculationsThread.quit();
     m_calculationsThread.wait();
+
+    if (m_tracePath.isEmpty() == false)
+    {
+        Tracing::Tracer::instance().stop();
+        Tracing::Tracer::instance().exportChromeTrace(m_tracePath.toStdString());
+    }
 }
 
 
@@ -214,22 +173,9 @@ void SimulationController::beginSimulation()
     }
 #endif
 
-
-    // for performance checks
-#if 0
-    for(int i = 0; i < 150; i++)
-        m_engine.step();
-
-    exit(0);
-#endif
-
     // before starting simulation update scene
-    const auto& objects = m_engine.objects();
-    for (std::size_t i = 0; i < objects.size(); i++)
-    {
-        const Object obj = objects[i];
-        m_scene->addObject(obj.id(), obj);
-    }
+    objectsUpdated(m_engine.objects());
+    updateScene();
 
     m_calculationsThread.start();
 }
@@ -243,9 +189,10 @@ int SimulationController::fps() const
 
 void SimulationController::tick()
 {
+    TRACE_SCOPE("gui", "tick");
+
     const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-    m_tickData.clear();
     const int steps = m_engine.stepBy(1800);
     m_framesCounter++;
 
@@ -255,60 +202,54 @@ void SimulationController::tick()
 
     std::cout << "Tick time: " << diff_ms << ", steps: " << steps << std::endl;
 
-    emit tickData(m_tickData);
+    // Notify GUI only when it has consumed previous notification: when it is slower than
+    // calculations, intermediate snapshots are overwritten in m_snapshots instead of being queued.
+    if (m_sceneUpdatePending.exchange(true) == false)
+        emit snapshotPublished();
 }
 
 
-void SimulationController::updateScene(const Tick& data)
+void SimulationController::updateScene()
 {
-    for(const auto& objs: data.colided)
-    {
-        const Object& obj = objs.first;
-        m_scene->updateRadius(obj.id(), obj.radius());
-    }
+    TRACE_SCOPE("gui", "updateScene");
 
-    for(const Object& obj: data.created)
-        m_scene->addObject(obj.id(), obj);
+    m_sceneUpdatePending = false;           // before update(), so snapshot published meanwhile triggers next call
 
-    for(const Object& obj: data.annihilated)
-        m_scene->removeObject(obj.id());
+    if (m_snapshots.update() == false)
+        return;
 
-    for(const Object& obj: data.updated)
-    {
-        const auto id = obj.id();
-        m_scene->updatePosition(id, obj.pos());
-        m_scene->updateMass(id, obj.mass());
-    }
+    // front snapshot stays untouched until next update(), so scene may draw it directly
+    const ObjectsSnapshot& snapshot = m_snapshots.front();
+    m_scene->setSnapshot(&snapshot);
 
     m_scene->updateTrackInfo();
 
-    emit objectCountUpdated(data.updated.size());
+    emit objectCountUpdated(snapshot.size());
 }
 
 
-void SimulationController::objectsColided(const Object& obj1, const Object& obj2)
+// Scene draws complete snapshot (see updateScene()), so separate
+// creation, collision and annihilation events are not needed.
+void SimulationController::objectsCreated(const Objects &, std::size_t, std::size_t)
 {
-    std::lock_guard<std::mutex> lockColided(m_tickData.colidedMutex);
-    m_tickData.colided.push_back( std::make_pair(obj1, obj2) );
+
 }
 
 
-void SimulationController::objectCreated(int, const Object& obj)
+void SimulationController::objectsColided(const std::vector<Collision> &)
 {
-    std::lock_guard<std::mutex> lockCreated(m_tickData.createdMutex);
-    m_tickData.created.push_back( obj );
+
 }
 
 
-void SimulationController::objectAnnihilated(const Object& obj)
+void SimulationController::objectsAnnihilated(const std::vector<Object> &)
 {
-    std::lock_guard<std::mutex> lockAnnihilated(m_tickData.annihilatedMutex);
-    m_tickData.annihilated.push_back( obj );
+
 }
 
 
-void SimulationController::objectUpdated(int, const Object& obj)
+void SimulationController::objectsUpdated(const Objects& objects)
 {
-    std::lock_guard<std::mutex> lockUpdated(m_tickData.updatedMutex);
-    m_tickData.updated.push_back( obj );
+    m_snapshots.back().assign(objects);
+    m_snapshots.publish();
 }
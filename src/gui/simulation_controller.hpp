@@ -21,41 +21,21 @@
 #define SIMULATIONCONTROLLER_HPP
 
 #include <atomic>
-#include <deque>
-#include <mutex>
+#include <vector>
 
+#include <QString>
 #include <QTimer>
 #include <QThread>
 
 #include "simulation_engine.hpp"
+#include "triple_buffer.hpp"
+#include "objects_snapshot.hpp"
 
 #include "accelerators/avx_accelerator.hpp"
 
 class ObjectsScene;
 
-struct Tick
-{
-    std::deque< std::pair<Object, Object> > colided;
-    std::deque<Object> created;
-    std::deque<Object> annihilated;
-    std::deque<Object> updated;
-
-    mutable std::mutex colidedMutex;
-    mutable std::mutex createdMutex;
-    mutable std::mutex annihilatedMutex;
-    mutable std::mutex updatedMutex;
-
-    Tick();
-    Tick(const Tick &);
-    Tick& operator=(const Tick &);
-
-    void clear();
-};
-
-Q_DECLARE_METATYPE(Tick)
-
-
-class SimulationController: public QObject, ISimulationEvents
+class SimulationController: public QObject, ISimulationBatchEvents
 {
 	Q_OBJECT
 
@@ -75,24 +55,27 @@ class SimulationController: public QObject, ISimulationEvents
         SimulationEngine m_engine;
         QTimer m_stepTimer;
         QThread m_calculationsThread;
-        Tick m_tickData;
+        TripleBuffer<ObjectsSnapshot> m_snapshots;
+        std::atomic<bool> m_sceneUpdatePending;     // snapshotPublished() was emitted and not handled yet
         ObjectsScene* m_scene;
         int m_fps;
         std::atomic<int> m_framesCounter;
+        QString m_tracePath;
 
         void tick();
-        void updateScene(const Tick &);
+        void updateScene();
 
-        // ISimulationEvents:
-        virtual void objectsColided(const Object&, const Object&) override;
-        virtual void objectCreated(int id, const Object &) override;
-        virtual void objectAnnihilated(const Object &) override;
-        virtual void objectUpdated(int id, const Object &) override;
+        // ISimulationBatchEvents:
+        virtual void objectsCreated(const Objects &, std::size_t first, std::size_t count) override;
+        virtual void objectsColided(const std::vector<Collision> &) override;
+        virtual void objectsAnnihilated(const std::vector<Object> &) override;
+        virtual void objectsUpdated(const Objects &) override;
 
     signals:
         void fpsUpdated(int);
         void objectCountUpdated(int);
-        void tickData(const Tick &);
+        void instrumentationUpdated(const Instrumentation::Snapshot &);
+        void snapshotPublished();
 };
 
 #endif // SIMULATIONCONTROLLER_HPP
@@ -23,6 +23,7 @@
 
 #include <QGridLayout>
 #include <QLabel>
+#include <QGroupBox>
 
 
 SimulationInfoWidget::SimulationInfoWidget(QWidget* p):
@@ -58,6 +59,23 @@ SimulationInfoWidget::SimulationInfoWidget(QWidget* p):
     mainLayout->addWidget(m_objRadiusValue, 4, 1);
     mainLayout->addWidget(massLabel, 5, 0);
     mainLayout->addWidget(m_objMassValue, 5, 1);
+
+    // step phases: mean / p95 / max of last steps
+    QGroupBox* performanceBox = new QGroupBox(tr("step phases [ms] (mean / p95 / max)"), this);
+    QGridLayout* performanceLayout = new QGridLayout(performanceBox);
+
+    for(int m = 0; m < Instrumentation::MetricsCount; m++)
+    {
+        const Instrumentation::Metric metric = static_cast<Instrumentation::Metric>(m);
+
+        QLabel* metricLabel = new QLabel(QString("%1:").arg(Instrumentation::name(metric)), performanceBox);
+        m_metricValues[m] = new QLabel(performanceBox);
+
+        performanceLayout->addWidget(metricLabel, m, 0);
+        performanceLayout->addWidget(m_metricValues[m], m, 1);
+    }
+
+    mainLayout->addWidget(performanceBox, 6, 0, 1, 2);
 }
 
 
@@ -78,27 +96,36 @@ void SimulationInfoWidget::updateObjectCount(int count)
     m_objCountValue->setText(QString::number(count));
 }
 
-void SimulationInfoWidget::updateObjectData(const QGraphicsItem *item)
+void SimulationInfoWidget::updateObjectData(int id, const XY& pos, BaseType mass, BaseType radius)
 {
-    if (item == nullptr)
-    {
-        m_objIDValue->setText(QString(""));
-        m_objPosValue->setText(QString(""));
-        m_objRadiusValue->setText(QString(""));
-        m_objMassValue->setText(QString(""));
-    }
-    else
+    m_objIDValue->setText(QString::number(id));
+    m_objPosValue->setText(QString("%1, %2").arg(pos.x, 0, 'g', 2)
+                       .arg(pos.y, 0, 'g', 2));
+    m_objRadiusValue->setText(QString::number(radius, 'g', 3));
+    m_objMassValue->setText(QString::number(mass, 'g', 3));
+}
+
+
+void SimulationInfoWidget::clearObjectData()
+{
+    m_objIDValue->setText(QString(""));
+    m_objPosValue->setText(QString(""));
+    m_objRadiusValue->setText(QString(""));
+    m_objMassValue->setText(QString(""));
+}
+
+
+void SimulationInfoWidget::updateInstrumentation(const Instrumentation::Snapshot& snapshot)
+{
+    for(int m = 0; m < Instrumentation::MetricsCount; m++)
     {
-        const int id = item->data(ObjectData::Id).toInt();
-        const QPointF pos = item->pos();
-        const BaseType mass = item->data(ObjectData::Mass).value<BaseType>();
-        const BaseType radius = item->data(ObjectData::Radius).value<BaseType>();
-
-        m_objIDValue->setText(QString::number(id));
-        m_objPosValue->setText(QString("%1, %2").arg(pos.x(), 0, 'g', 2)
-                           .arg(pos.y(), 0, 'g', 2));
-        m_objRadiusValue->setText(QString::number(radius, 'g', 3));
-        m_objMassValue->setText(QString::number(mass, 'g', 3));
+        const RollingHistogram::Summary& summary = snapshot[m];
+
+        // times are in microseconds, retries and overlap are plain numbers
+        const double scale = m == Instrumentation::Retries || m == Instrumentation::TransferOverlap? 1.0: 1e-3;
+
+        m_metricValues[m]->setText(QString("%1 / %2 / %3").arg(summary.mean * scale, 0, 'g', 3)
+                                                           .arg(summary.p95 * scale, 0, 'g', 3)
+                                                           .arg(summary.max * scale, 0, 'g', 3));
     }
 }
-
@@ -21,9 +21,10 @@
 #define SIMULATIONINFOWIDGET_HPP
 
 #include <QWidget>
-#include <QGraphicsItem>
 #include <QGroupBox>
 
+#include "instrumentation.hpp"
+#include "object.hpp"
 #include "types.hpp"
 
 class QLabel;
@@ -39,7 +40,9 @@ class SimulationInfoWidget: public QWidget
 
         void updateFps(int);
         void updateObjectCount(int);
-		void updateObjectData(const QGraphicsItem *);
+        void updateObjectData(int id, const XY& pos, BaseType mass, BaseType radius);
+        void clearObjectData();
+        void updateInstrumentation(const Instrumentation::Snapshot &);
 
     private:
         QLabel* m_fpsValue;
@@ -48,6 +51,7 @@ class SimulationInfoWidget: public QWidget
         QLabel* m_objPosValue;
         QLabel* m_objMassValue;
         QLabel* m_objRadiusValue;
+        QLabel* m_metricValues[Instrumentation::MetricsCount];
 };
 
 #endif // SIMULATIONINFOWIDGET_H